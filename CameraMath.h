@@ -0,0 +1,138 @@
+#pragma once
+#include <stddef.h>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define CAMERA_MATH_SIMD 1
+#endif
+
+// Projection parameters of the 3D view. The aspect ratio comes from the viewport every frame;
+// CAMERA_ASPECT is the one of the 800x600 frame buffer the app starts with, which headless code
+// uses as well.
+const float CAMERA_FOV_SCALE = 1.3f;
+const float CAMERA_ASPECT    = 800.0f / 600.0f;
+const float CAMERA_NEAR      = 0.1f;
+
+struct alignas(16) Vec4 {
+    float x, y, z, w;
+};
+
+// 4x4 matrix stored column by column (m[column][row]), which is how HLSL packs a float4x4 in a
+// constant buffer by default, so it can be copied there as is. Points are column vectors:
+// p' = M * p, and Mat4Multiply(a, b) applies b first.
+struct alignas(16) Mat4 {
+    float m[4][4];
+
+    float At(int row, int column) const { return m[column][row]; }
+    void Set(int row, int column, float value) { m[column][row] = value; }
+
+    static Mat4 Identity() {
+        Mat4 result = {};
+        for (int i = 0; i < 4; i++) result.m[i][i] = 1.0f;
+        return result;
+    }
+};
+
+// M * (x, y, z, 1).
+inline Vec4 Mat4TransformPoint(const Mat4& a, float x, float y, float z) {
+    Vec4 out;
+#ifdef CAMERA_MATH_SIMD
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_load_ps(a.m[0]), _mm_set1_ps(x)), _mm_mul_ps(_mm_load_ps(a.m[1]), _mm_set1_ps(y)));
+    r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(_mm_load_ps(a.m[2]), _mm_set1_ps(z)), _mm_load_ps(a.m[3])));
+    _mm_store_ps(&out.x, r);
+#else
+    float* o = &out.x;
+    for (int row = 0; row < 4; row++) o[row] = (a.m[0][row] * x + a.m[1][row] * y) + (a.m[2][row] * z + a.m[3][row]);
+#endif
+    return out;
+}
+
+inline Vec4 Mat4Transform(const Mat4& a, const Vec4& v) {
+    Vec4 out;
+#ifdef CAMERA_MATH_SIMD
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_load_ps(a.m[0]), _mm_set1_ps(v.x)), _mm_mul_ps(_mm_load_ps(a.m[1]), _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(_mm_load_ps(a.m[2]), _mm_set1_ps(v.z)), _mm_mul_ps(_mm_load_ps(a.m[3]), _mm_set1_ps(v.w))));
+    _mm_store_ps(&out.x, r);
+#else
+    float* o = &out.x;
+    for (int row = 0; row < 4; row++) o[row] = (a.m[0][row] * v.x + a.m[1][row] * v.y) + (a.m[2][row] * v.z + a.m[3][row] * v.w);
+#endif
+    return out;
+}
+
+// Column j of a * b is a times column j of b.
+inline Mat4 Mat4Multiply(const Mat4& a, const Mat4& b) {
+    Mat4 result;
+    for (int column = 0; column < 4; column++) {
+        const Vec4 in = { b.m[column][0], b.m[column][1], b.m[column][2], b.m[column][3] };
+        Vec4 out = Mat4Transform(a, in);
+        result.m[column][0] = out.x; result.m[column][1] = out.y; result.m[column][2] = out.z; result.m[column][3] = out.w;
+    }
+    return result;
+}
+
+// out[i] = M * (p, 1) for count points, where point i starts at xyz + i * stride (in floats), so
+// vertex arrays can be read in place. The columns are loaded once for the whole batch, leaving
+// three broadcasts, three multiplies and three adds per point; results match Mat4TransformPoint().
+inline void TransformPoints(const Mat4& a, const float* xyz, size_t count, size_t stride, Vec4* out) {
+#ifdef CAMERA_MATH_SIMD
+    const __m128 c0 = _mm_load_ps(a.m[0]), c1 = _mm_load_ps(a.m[1]), c2 = _mm_load_ps(a.m[2]), c3 = _mm_load_ps(a.m[3]);
+    for (size_t i = 0; i < count; i++, xyz += stride) {
+        __m128 r = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(xyz[0])), _mm_mul_ps(c1, _mm_set1_ps(xyz[1])));
+        r = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(xyz[2])), c3));
+        _mm_store_ps(&out[i].x, r);
+    }
+#else
+    for (size_t i = 0; i < count; i++, xyz += stride) out[i] = Mat4TransformPoint(a, xyz[0], xyz[1], xyz[2]);
+#endif
+}
+
+// Everything the frame needs to know about the camera, built once per frame and shared by the
+// vertex shader, frustum culling, picking and the CPU rasterizers.
+//
+// The view turns yaw about Y, then pitch about X; the projection keeps the shader's old clip
+// space: x * fovScale, y * fovScale * aspect, z - near, w = z, with no far plane, so z / w runs
+// from 0 at the near plane towards 1 at infinity.
+struct CameraMatrices {
+    Mat4 view;              // World -> view
+    Mat4 projection;        // View -> clip
+    Mat4 viewProj;          // World -> clip
+    Mat4 relativeViewProj;  // (world - eye) -> clip: no large translation, so precise far from the origin
+    float eye[3];
+    float forward[3];       // Unit view direction
+    float fovScale, aspect, nearZ;
+
+    static CameraMatrices FromCamera(float camX, float camY, float camZ, float yaw, float pitch, float fovScale, float aspect, float nearZ) {
+        float c = cos(yaw), s = sin(yaw);
+        float cp = cos(pitch), sp = sin(pitch);
+        // Rows of the world -> view rotation.
+        const float rows[3][3] = { { c, 0.0f, -s }, { -s * sp, cp, -c * sp }, { s * cp, sp, c * cp } };
+
+        CameraMatrices cam;
+        cam.eye[0] = camX; cam.eye[1] = camY; cam.eye[2] = camZ;
+        for (int a = 0; a < 3; a++) cam.forward[a] = rows[2][a];
+        cam.fovScale = fovScale; cam.aspect = aspect; cam.nearZ = nearZ;
+
+        Mat4 rotation = Mat4::Identity();
+        for (int r = 0; r < 3; r++)
+            for (int col = 0; col < 3; col++) rotation.Set(r, col, rows[r][col]);
+        cam.view = rotation;
+        for (int r = 0; r < 3; r++) cam.view.Set(r, 3, -(rows[r][0] * camX + rows[r][1] * camY + rows[r][2] * camZ));
+
+        cam.projection = {};
+        cam.projection.Set(0, 0, fovScale);
+        cam.projection.Set(1, 1, fovScale * aspect);
+        cam.projection.Set(2, 2, 1.0f); cam.projection.Set(2, 3, -nearZ);
+        cam.projection.Set(3, 2, 1.0f);
+
+        cam.viewProj = Mat4Multiply(cam.projection, cam.view);
+        cam.relativeViewProj = Mat4Multiply(cam.projection, rotation);
+        return cam;
+    }
+
+    // Clip coordinates of a world-space point, through relativeViewProj.
+    Vec4 ToClip(float x, float y, float z) const {
+        return Mat4TransformPoint(relativeViewProj, x - eye[0], y - eye[1], z - eye[2]);
+    }
+};
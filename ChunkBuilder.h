@@ -0,0 +1,255 @@
+#pragma once
+#include "VoxelWorld.h"
+#include "ChunkMesher.h"
+#include "LodMesher.h"
+#include "JobSystem.h"
+#include "RegionFile.h"
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A chunk the renderer wants a mesh for. Lower priority values are built first.
+struct ChunkRequest {
+    ChunkCoord coord;
+    float priority;
+    int lodLevel = 0;   // > 0 asks for a heightfield tile from LodMesher.h, which needs no chunk data
+};
+
+struct ChunkBuildResult {
+    ChunkCoord coord = { 0, 0 };
+    std::shared_ptr<Chunk> chunk;   // Set by generation jobs
+    ChunkMesh mesh;                 // Set by meshing jobs
+    bool meshed = false;
+};
+
+// Builds terrain and meshes on a JobSystem. The frame loop calls Poll() and Schedule() once per
+// frame; neither waits for a worker. A chunk is meshed once it and its eight neighbours are in the
+// world, so requests first trigger generation of whatever is missing. LOD tiles are meshed straight
+// from the terrain. Finished work comes back through a lock-free queue and is only applied to the
+// world on the calling thread.
+class ChunkBuilder {
+public:
+    int MaxInFlight;
+    size_t ChunksGenerated = 0;
+    size_t ChunksMeshed = 0;
+    size_t LodTilesMeshed = 0;
+    RegionStore* Store = nullptr;   // Saved chunks are loaded from here instead of generated; must outlive the builder
+
+    // Every job delivers exactly one result, which counts as in flight until Poll() takes it, so
+    // keeping InFlight() at or below the queue's size means a worker never finds the queue full.
+    static const int kResultSlots = 1024;
+
+    // threadCount 0 = one worker per spare core. maxInFlight 0 = four jobs per worker.
+    explicit ChunkBuilder(int threadCount = 0, int maxInFlight = 0)
+        : MaxInFlight(0), m_Results(kResultSlots), m_Jobs(new JobSystem(threadCount)) {
+        MaxInFlight = (maxInFlight > 0) ? std::min(maxInFlight, kResultSlots) : std::min(m_Jobs->ThreadCount() * 4, kResultSlots);
+    }
+
+    ~ChunkBuilder() {
+        WaitForSaves();   // The job system drops jobs that have not started
+        // Workers still running deliver into the queue; from here on they drop their result instead
+        // of waiting for room, so joining them below cannot hang.
+        m_ShuttingDown.store(true, std::memory_order_release);
+        m_Jobs.reset();
+        ChunkBuildResult* result;
+        while (m_Results.TryPop(result)) delete result;
+    }
+
+    int ThreadCount() const { return m_Jobs->ThreadCount(); }
+    JobSystem& Jobs() { return *m_Jobs; }   // Shared with other per-frame work, e.g. ParallelFor()
+    int InFlight() const { return (int)(m_Generating.size() + m_Meshing.size() + m_LodMeshing.size()); }
+    int Generating() const { return (int)m_Generating.size(); }
+    bool IsGenerating(ChunkCoord coord) const { return m_Generating.count(coord) != 0; }
+    int Saving() const { return (int)m_Saving.size(); }
+    bool IsSaving(ChunkCoord coord) const { return m_Saving.count(coord) != 0; }
+
+    void Schedule(VoxelWorld& world, std::vector<ChunkRequest>& requests) {
+        std::sort(requests.begin(), requests.end(), [](const ChunkRequest& a, const ChunkRequest& b) { return a.priority < b.priority; });
+
+        for (const ChunkRequest& request : requests) {
+            if (InFlight() >= MaxInFlight) break;
+            ChunkCoord c = request.coord;
+            if (request.lodLevel > 0) {
+                if (!m_LodMeshing.count(c)) SubmitLodMesh(world.Terrain, c, request.lodLevel);
+                continue;
+            }
+            if (m_Meshing.count(c)) continue;
+
+            // The chunk and all eight around it: faces on its borders and the ambient occlusion at
+            // its edges and corners depend on them.
+            bool ready = true;
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dz = -1; dz <= 1; dz++) {
+                    ChunkCoord n = { c.x + dx, c.z + dz };
+                    if (world.FindChunk(n)) continue;
+                    ready = false;
+                    if (!m_Generating.count(n) && !m_Saving.count(n) && InFlight() < MaxInFlight) SubmitGenerate(world.Terrain, n);
+                }
+            }
+            if (ready) SubmitMesh(world, c);
+        }
+    }
+
+    // Loads or generates a chunk that is not in the world, regardless of MaxInFlight but never past
+    // kResultSlots; the chunk arrives through Poll(). Returns false when it is loaded or already on
+    // its way, when its save is still pending or when the result queue could not take it; ask
+    // again next frame.
+    bool Load(const VoxelWorld& world, ChunkCoord coord) {
+        if (InFlight() >= kResultSlots || m_Generating.count(coord) || m_Saving.count(coord) || world.FindChunkShared(coord)) return false;
+        SubmitGenerate(world.Terrain, coord);
+        return true;
+    }
+
+    // Meshes a chunk that is already in the world again, e.g. after an edit, regardless of
+    // MaxInFlight but never past kResultSlots. The job works on the chunk as it is now. Returns
+    // false when the chunk is not loaded, a mesh of it is still being built or the result queue
+    // could not take it; ask again next frame.
+    bool Remesh(const VoxelWorld& world, ChunkCoord coord) {
+        if (InFlight() >= kResultSlots || m_Meshing.count(coord) || !world.FindChunkShared(coord)) return false;
+        SubmitMesh(world, coord);
+        return true;
+    }
+
+    // Writes a chunk that has left the world to store on a worker, since a save can compact a whole
+    // region file. Until it is written the chunk is neither loaded nor generated again, so the
+    // stale copy in the store never comes back; a second save of the same chunk waits for the
+    // first, and only the newest waiting one is written. store must outlive the builder.
+    void Save(RegionStore& store, std::shared_ptr<Chunk> chunk) {
+        auto it = m_Saving.find(chunk->coord);
+        if (it != m_Saving.end()) {
+            it->second.nextStore = &store;
+            it->second.next = std::move(chunk);
+            return;
+        }
+        PendingSave& save = m_Saving[chunk->coord];
+        SubmitSave(save, store, std::move(chunk));
+    }
+
+    // Blocks until every save is written.
+    void WaitForSaves() {
+        while (!m_Saving.empty()) {
+            if (!ReapSaves()) std::this_thread::yield();
+        }
+    }
+
+    // Hands generated chunks to the world and appends finished meshes to finishedMeshes, and the
+    // coordinates of the chunks inserted to insertedChunks if given. Also retires finished saves.
+    void Poll(VoxelWorld& world, std::vector<ChunkMesh>& finishedMeshes, std::vector<ChunkCoord>* insertedChunks = nullptr) {
+        ReapSaves();
+        ChunkBuildResult* result;
+        while (m_Results.TryPop(result)) {
+            if (result->meshed && result->mesh.lodLevel > 0) {
+                m_LodMeshing.erase(result->coord);
+                finishedMeshes.push_back(std::move(result->mesh));
+                LodTilesMeshed++;
+            } else if (result->meshed) {
+                m_Meshing.erase(result->coord);
+                finishedMeshes.push_back(std::move(result->mesh));
+                ChunksMeshed++;
+            } else {
+                m_Generating.erase(result->coord);
+                world.InsertChunk(std::move(result->chunk));
+                if (insertedChunks) insertedChunks->push_back(result->coord);
+                ChunksGenerated++;
+            }
+            delete result;
+        }
+    }
+
+private:
+    struct PendingSave {
+        std::shared_ptr<std::atomic<bool>> done;    // Set by the job once the chunk is written
+        std::shared_ptr<Chunk> next;                // Saved once done is set, if an unload came meanwhile
+        RegionStore* nextStore = nullptr;
+    };
+
+    // The job holds the chunk, which is already out of the world, so nothing else touches it.
+    void SubmitSave(PendingSave& save, RegionStore& store, std::shared_ptr<Chunk> chunk) {
+        std::shared_ptr<std::atomic<bool>> done = std::make_shared<std::atomic<bool>>(false);
+        save.done = done;
+        RegionStore* target = &store;
+        m_Jobs->Submit([target, chunk, done]() {
+            target->SaveChunk(*chunk);
+            done->store(true, std::memory_order_release);
+        });
+    }
+
+    // Drops written saves, or starts the one waiting behind them. True if any finished.
+    bool ReapSaves() {
+        bool any = false;
+        for (auto it = m_Saving.begin(); it != m_Saving.end(); ) {
+            PendingSave& save = it->second;
+            if (!save.done->load(std::memory_order_acquire)) { ++it; continue; }
+            any = true;
+            if (save.next) {
+                std::shared_ptr<Chunk> next = std::move(save.next);
+                SubmitSave(save, *save.nextStore, std::move(next));
+                ++it;
+            } else {
+                it = m_Saving.erase(it);
+            }
+        }
+        return any;
+    }
+
+    // The in-flight cap leaves room for every result; the wait is a safety net, and on shutdown the
+    // result is dropped instead.
+    void Deliver(ChunkBuildResult* result) {
+        while (!m_Results.TryPush(result)) {
+            if (m_ShuttingDown.load(std::memory_order_acquire)) { delete result; return; }
+            std::this_thread::yield();
+        }
+    }
+
+    void SubmitGenerate(const TerrainConfig& terrain, ChunkCoord coord) {
+        m_Generating.insert(coord);
+        RegionStore* store = Store;
+        m_Jobs->Submit([this, terrain, coord, store]() {
+            ChunkBuildResult* result = new ChunkBuildResult();
+            result->coord = coord;
+            result->chunk = std::make_shared<Chunk>();
+            if (!store || !store->LoadChunk(coord, *result->chunk)) GenerateChunk(terrain, coord, *result->chunk);
+            Deliver(result);
+        });
+    }
+
+    void SubmitMesh(const VoxelWorld& world, ChunkCoord c) {
+        m_Meshing.insert(c);
+        // Holding the chunks keeps them alive for the job even if the world drops them meanwhile.
+        std::array<std::shared_ptr<const Chunk>, 9> chunks;    // [(dx + 1) * 3 + dz + 1]
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dz = -1; dz <= 1; dz++) chunks[(dx + 1) * 3 + dz + 1] = world.FindChunkShared({ c.x + dx, c.z + dz });
+        m_Jobs->Submit([this, c, chunks]() {
+            ChunkBuildResult* result = new ChunkBuildResult();
+            result->coord = c;
+            result->meshed = true;
+            ChunkNeighborhood n;
+            n.negXnegZ = chunks[0].get(); n.negX = chunks[1].get(); n.negXposZ = chunks[2].get();
+            n.negZ     = chunks[3].get(); n.center = chunks[4].get(); n.posZ = chunks[5].get();
+            n.posXnegZ = chunks[6].get(); n.posX = chunks[7].get(); n.posXposZ = chunks[8].get();
+            MeshChunk(n, result->mesh);
+            Deliver(result);
+        });
+    }
+
+    void SubmitLodMesh(const TerrainConfig& terrain, ChunkCoord coord, int level) {
+        m_LodMeshing.insert(coord);
+        m_Jobs->Submit([this, terrain, coord, level]() {
+            ChunkBuildResult* result = new ChunkBuildResult();
+            result->coord = coord;
+            result->meshed = true;
+            MeshLodTile(terrain, coord, level, result->mesh);
+            Deliver(result);
+        });
+    }
+
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_Generating;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_Meshing;
+    std::unordered_set<ChunkCoord, ChunkCoordHash> m_LodMeshing;   // At most one tile per coordinate at a time
+    std::unordered_map<ChunkCoord, PendingSave, ChunkCoordHash> m_Saving;
+    LockFreeQueue<ChunkBuildResult*> m_Results;
+    std::atomic<bool> m_ShuttingDown{ false };
+    std::unique_ptr<JobSystem> m_Jobs;
+};
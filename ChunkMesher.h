@@ -0,0 +1,409 @@
+#pragma once
+#include "VoxelWorld.h"
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+struct Vertex {
+    float x, y, z;
+    float r, g, b, a;
+};
+
+// One cube face. Corners are bit masks (1 = +X, 2 = +Y, 4 = +Z) in the same clockwise order
+// as the old 36-vertex cube table, so back-face culling keeps working unchanged.
+struct VoxelFace {
+    int axis;       // 0 = X, 1 = Y, 2 = Z
+    int dir;        // -1 or +1 along axis
+    float shade;    // Fixed per-face grey
+    int corners[4];
+};
+
+static const VoxelFace kVoxelFaces[6] = {
+    { 2, -1, 0.7f, { 0, 2, 3, 1 } },
+    { 2, +1, 0.6f, { 4, 5, 7, 6 } },
+    { 0, -1, 0.5f, { 4, 6, 2, 0 } },
+    { 0, +1, 0.5f, { 1, 3, 7, 5 } },
+    { 1, +1, 1.0f, { 2, 6, 7, 3 } },
+    { 1, -1, 0.3f, { 0, 1, 5, 4 } },
+};
+
+// Material colours, formerly picked per pixel in PS() from world Y and isTopBlock.
+inline void BlockTint(uint8_t block, float out[3]) {
+    static const float tints[BLOCK_TYPE_COUNT][3] = {
+        { 1.0f, 1.0f, 1.0f },   // Air (unused)
+        { 0.1f, 0.1f, 0.1f },   // Bedrock
+        { 0.35f, 0.25f, 0.2f }, // Dirt
+        { 0.0f, 0.4f, 0.8f },   // Water
+        { 0.2f, 0.8f, 0.2f },   // Grass
+        { 0.5f, 0.5f, 0.5f },   // Stone
+        { 1.0f, 1.0f, 1.0f },   // Snow
+        { 1.0f, 0.85f, 0.45f }, // Lamp
+    };
+    const float* t = tints[block < BLOCK_TYPE_COUNT ? block : 0];
+    out[0] = t[0]; out[1] = t[1]; out[2] = t[2];
+}
+
+// The chunk being meshed plus its eight horizontal neighbours: the four across its faces resolve
+// border faces, and ambient occlusion at the chunk corners also looks into the diagonal ones.
+// Missing neighbours read as air; everything below the world floor reads as solid.
+struct ChunkNeighborhood {
+    const Chunk* center = nullptr;
+    const Chunk* negX = nullptr;
+    const Chunk* posX = nullptr;
+    const Chunk* negZ = nullptr;
+    const Chunk* posZ = nullptr;
+    const Chunk* negXnegZ = nullptr;
+    const Chunk* posXnegZ = nullptr;
+    const Chunk* negXposZ = nullptr;
+    const Chunk* posXposZ = nullptr;
+
+    // The chunk at offset (dx, dz), each in -1..1.
+    const Chunk* At(int dx, int dz) const {
+        const Chunk* const grid[3][3] = { { negXnegZ, negX, negXposZ }, { negZ, center, posZ }, { posXnegZ, posX, posXposZ } };
+        return grid[dx + 1][dz + 1];
+    }
+
+    // lx/lz may each be one block outside the chunk.
+    uint8_t Get(int lx, int ly, int lz) const {
+        if (ly < 0) return BLOCK_BEDROCK;
+        if (ly >= CHUNK_HEIGHT) return BLOCK_AIR;
+        int dx = (lx < 0) ? -1 : (lx >= CHUNK_SIZE) ? 1 : 0;
+        int dz = (lz < 0) ? -1 : (lz >= CHUNK_SIZE) ? 1 : 0;
+        const Chunk* chunk = At(dx, dz);
+        return chunk ? chunk->Get(lx - dx * CHUNK_SIZE, ly, lz - dz * CHUNK_SIZE) : (uint8_t)BLOCK_AIR;
+    }
+};
+
+inline ChunkNeighborhood GetNeighborhood(VoxelWorld& world, ChunkCoord coord) {
+    ChunkNeighborhood n;
+    n.negX = &world.GetChunk({ coord.x - 1, coord.z });
+    n.posX = &world.GetChunk({ coord.x + 1, coord.z });
+    n.negZ = &world.GetChunk({ coord.x, coord.z - 1 });
+    n.posZ = &world.GetChunk({ coord.x, coord.z + 1 });
+    n.negXnegZ = &world.GetChunk({ coord.x - 1, coord.z - 1 });
+    n.posXnegZ = &world.GetChunk({ coord.x + 1, coord.z - 1 });
+    n.negXposZ = &world.GetChunk({ coord.x - 1, coord.z + 1 });
+    n.posXposZ = &world.GetChunk({ coord.x + 1, coord.z + 1 });
+    n.center = &world.GetChunk(coord); // Last, so it is the one left in the lookup cache
+    return n;
+}
+
+struct FaceCullStats {
+    int facesKept = 0;      // Faces touching air
+    int facesCulled = 0;    // Faces hidden behind a solid neighbour
+};
+
+struct ChunkMesh {
+    ChunkCoord coord = { 0, 0 };
+    std::vector<Vertex> vertices;   // Triangle list, 6 vertices per quad
+    int quadCount = 0;
+    FaceCullStats cull;
+    int lodLevel = 0;               // 0 = full-resolution chunk, see LodMesher.h for the rest
+    float boundsMin[3] = { 0, 0, 0 };   // World-space box around all vertices
+    float boundsMax[3] = { 0, 0, 0 };
+};
+
+// Hidden-face pass. Sets bit f of faceMask[Chunk::Index(...)] when face kVoxelFaces[f] of that
+// block touches air. Only walks each column up to its top block, since everything above is air.
+// blocks holds the centre chunk unpacked, so only faces on the chunk border go through n.Get().
+inline void ComputeFaceVisibility(const ChunkNeighborhood& n, const uint8_t blocks[CHUNK_BLOCKS], uint8_t faceMask[CHUNK_BLOCKS], FaceCullStats& stats) {
+    const Chunk& chunk = *n.center;
+    memset(faceMask, 0, CHUNK_BLOCKS);
+    stats = FaceCullStats();
+
+    const int dims[3] = { CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE };
+    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+            int topLy = chunk.TopY(lx, lz) - WORLD_MIN_Y;
+            for (int ly = 0; ly <= topLy; ly++) {
+                if (!IsSolidBlock(blocks[Chunk::Index(lx, ly, lz)])) continue;
+                uint8_t bits = 0;
+                for (int f = 0; f < 6; f++) {
+                    int q[3] = { lx, ly, lz };
+                    int a = kVoxelFaces[f].axis;
+                    q[a] += kVoxelFaces[f].dir;
+                    uint8_t neighbour = (q[a] >= 0 && q[a] < dims[a]) ? blocks[Chunk::Index(q[0], q[1], q[2])] : n.Get(q[0], q[1], q[2]);
+                    if (!IsSolidBlock(neighbour)) bits |= (uint8_t)(1 << f);
+                }
+                faceMask[Chunk::Index(lx, ly, lz)] = bits;
+                int kept = __builtin_popcount(bits);
+                stats.facesKept += kept;
+                stats.facesCulled += 6 - kept;
+            }
+        }
+    }
+}
+
+inline void ComputeFaceVisibility(const ChunkNeighborhood& n, uint8_t faceMask[CHUNK_BLOCKS], FaceCullStats& stats) {
+    uint8_t blocks[CHUNK_BLOCKS];
+    n.center->blocks.Unpack(blocks);
+    ComputeFaceVisibility(n, blocks, faceMask, stats);
+}
+
+// Shading of a face corner, baked into its vertex colour: ambient occlusion from 3 = open down to
+// 0 when both side neighbours in front of the face are solid, and the light level (0..MAX_LIGHT)
+// of the air around the corner. Each corner i of VoxelFace::corners takes 6 bits of a face's
+// shading, AO in the low two, light in the next four.
+const int AO_OPEN = 3;
+const uint32_t SHADE_FULL = 0xFFFFFF;   // Every corner open and fully lit
+
+// What MeshChunk() bakes into the corners. MESH_FLAT samples nothing, as the mesher did before
+// ambient occlusion, and MESH_AO_ONLY leaves out the light; both are there to time the parts.
+enum MeshShading { MESH_FLAT, MESH_AO_ONLY, MESH_AO_AND_LIGHT };
+static const float kAoLight[4] = { 0.55f, 0.7f, 0.85f, 1.0f };
+// 0.1 + 0.9 * 0.8^(15 - level): each level darkens by a fifth, never quite to black.
+static const float kLightCurve[MAX_LIGHT + 1] = {
+    0.132f, 0.140f, 0.150f, 0.162f, 0.177f, 0.196f, 0.221f, 0.251f, 0.289f, 0.336f, 0.395f, 0.469f, 0.561f, 0.676f, 0.820f, 1.0f,
+};
+
+inline int CornerAo(uint32_t shade, int corner) { return (shade >> (corner * 6)) & 3; }
+inline int CornerLight(uint32_t shade, int corner) { return (shade >> (corner * 6 + 2)) & 15; }
+inline uint32_t CornerShade(int ao, int light) { return (uint32_t)(ao | light << 2); }
+inline float CornerBrightness(uint32_t shade, int corner) { return kAoLight[CornerAo(shade, corner)] * kLightCurve[CornerLight(shade, corner)]; }
+
+// Emits one face as two triangles. lo/hi span the face rectangle; they are equal on face.axis.
+// The quad is split along the diagonal whose corners are brighter, so a single dark corner stays
+// in one triangle whichever corner it is instead of smearing along a fixed diagonal.
+inline void EmitFace(const VoxelFace& face, const float lo[3], const float hi[3], uint8_t block, ChunkMesh& out, uint32_t shade = SHADE_FULL) {
+    float tint[3];
+    BlockTint(block, tint);
+    float r = face.shade * 0.4f + tint[0] * 0.6f;
+    float g = face.shade * 0.4f + tint[1] * 0.6f;
+    float b = face.shade * 0.4f + tint[2] * 0.6f;
+
+    Vertex quad[4];
+    float brightness[4];
+    for (int i = 0; i < 4; i++) {
+        int c = face.corners[i];
+        brightness[i] = CornerBrightness(shade, i);
+        float light = brightness[i];
+        quad[i] = { (c & 1) ? hi[0] : lo[0], (c & 2) ? hi[1] : lo[1], (c & 4) ? hi[2] : lo[2], r * light, g * light, b * light, 1.0f };
+    }
+    if (brightness[0] + brightness[2] >= brightness[1] + brightness[3]) {
+        out.vertices.push_back(quad[0]); out.vertices.push_back(quad[1]); out.vertices.push_back(quad[2]);
+        out.vertices.push_back(quad[0]); out.vertices.push_back(quad[2]); out.vertices.push_back(quad[3]);
+    } else {
+        out.vertices.push_back(quad[0]); out.vertices.push_back(quad[1]); out.vertices.push_back(quad[3]);
+        out.vertices.push_back(quad[1]); out.vertices.push_back(quad[2]); out.vertices.push_back(quad[3]);
+    }
+    out.quadCount++;
+}
+
+// Emits the quad covering cells [u0, u0 + w) x [v0, v0 + h) of a face slice.
+inline void EmitQuad(const Chunk& chunk, const VoxelFace& face, int slice, int u0, int v0, int w, int h, uint8_t block, uint32_t shade, ChunkMesh& out) {
+    int uAxis = (face.axis + 1) % 3;
+    int vAxis = (face.axis + 2) % 3;
+    float origin[3] = { (float)chunk.OriginX(), (float)WORLD_MIN_Y, (float)chunk.OriginZ() };
+
+    float lo[3], hi[3];
+    lo[face.axis] = hi[face.axis] = origin[face.axis] + slice + 0.5f * face.dir;
+    lo[uAxis] = origin[uAxis] + u0 - 0.5f; hi[uAxis] = lo[uAxis] + w;
+    lo[vAxis] = origin[vAxis] + v0 - 0.5f; hi[vAxis] = lo[vAxis] + h;
+    EmitFace(face, lo, hi, block, out, shade);
+}
+
+inline void ComputeMeshBounds(ChunkMesh& mesh) {
+    if (mesh.vertices.empty()) return;
+    const Vertex& first = mesh.vertices[0];
+    mesh.boundsMin[0] = mesh.boundsMax[0] = first.x;
+    mesh.boundsMin[1] = mesh.boundsMax[1] = first.y;
+    mesh.boundsMin[2] = mesh.boundsMax[2] = first.z;
+    for (const Vertex& vtx : mesh.vertices) {
+        mesh.boundsMin[0] = std::min(mesh.boundsMin[0], vtx.x); mesh.boundsMax[0] = std::max(mesh.boundsMax[0], vtx.x);
+        mesh.boundsMin[1] = std::min(mesh.boundsMin[1], vtx.y); mesh.boundsMax[1] = std::max(mesh.boundsMax[1], vtx.y);
+        mesh.boundsMin[2] = std::min(mesh.boundsMin[2], vtx.z); mesh.boundsMax[2] = std::max(mesh.boundsMax[2], vtx.z);
+    }
+}
+
+// Solid flags and light levels (CombinedLight()) for the chunk and a one-block border around it,
+// including the diagonal neighbours and the layers below and above, so corner lookups never leave
+// the arrays. Missing neighbours are open air.
+struct PaddedVolume {
+    static const int SX = CHUNK_SIZE + 2, SZ = CHUNK_SIZE + 2, SY = CHUNK_HEIGHT + 2;
+    static const int STRIDE_X = 1, STRIDE_Z = SX, STRIDE_Y = SX * SZ;
+    uint8_t solid[SX * SY * SZ];
+    uint8_t light[SX * SY * SZ];
+
+    static int Index(int lx, int ly, int lz) { return ((ly + 1) * SZ + (lz + 1)) * SX + (lx + 1); }
+
+    // Layers above the highest block of all nine chunks are cleared without looking at them.
+    // Without withLight only the solid flags are filled in.
+    void Fill(const ChunkNeighborhood& n, const uint8_t blocks[CHUNK_BLOCKS], bool withLight = true) {
+        int topLy = -1;
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dz = -1; dz <= 1; dz++)
+                if (const Chunk* chunk = n.At(dx, dz)) topLy = std::max(topLy, chunk->maxTopY - WORLD_MIN_Y);
+        topLy = std::min(topLy, CHUNK_HEIGHT - 1);
+
+        memset(solid, 1, SX * SZ);                                              // Below the world floor
+        memset(solid + (topLy + 2) * SX * SZ, 0, (SY - topLy - 2) * SX * SZ);   // Open sky above every column
+        if (withLight) {
+            memset(light, 0, SX * SZ);
+            memset(light + (topLy + 2) * SX * SZ, MAX_LIGHT, (SY - topLy - 2) * SX * SZ);
+        }
+        const Chunk& chunk = *n.center;
+        for (int ly = 0; ly <= topLy; ly++) {
+            for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                int row = Index(0, ly, lz), src = Chunk::Index(0, ly, lz);
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) solid[row + lx] = IsSolidBlock(blocks[src + lx]);
+                if (withLight)
+                    for (int lx = 0; lx < CHUNK_SIZE; lx++) light[row + lx] = (uint8_t)CombinedLight(chunk.light[src + lx]);
+            }
+            // The ring around the chunk, one neighbour at a time.
+            const int last = CHUNK_SIZE - 1;
+            FillStrip(n.negZ, 0, ly, last, STRIDE_X, CHUNK_SIZE, Index(0, ly, -1), withLight);
+            FillStrip(n.posZ, 0, ly, 0, STRIDE_X, CHUNK_SIZE, Index(0, ly, CHUNK_SIZE), withLight);
+            FillStrip(n.negX, last, ly, 0, STRIDE_Z, CHUNK_SIZE, Index(-1, ly, 0), withLight);
+            FillStrip(n.posX, 0, ly, 0, STRIDE_Z, CHUNK_SIZE, Index(CHUNK_SIZE, ly, 0), withLight);
+            FillStrip(n.negXnegZ, last, ly, last, STRIDE_X, 1, Index(-1, ly, -1), withLight);
+            FillStrip(n.posXnegZ, 0, ly, last, STRIDE_X, 1, Index(CHUNK_SIZE, ly, -1), withLight);
+            FillStrip(n.negXposZ, last, ly, 0, STRIDE_X, 1, Index(-1, ly, CHUNK_SIZE), withLight);
+            FillStrip(n.posXposZ, 0, ly, 0, STRIDE_X, 1, Index(CHUNK_SIZE, ly, CHUNK_SIZE), withLight);
+        }
+    }
+
+private:
+    // count blocks of a neighbour from (lx, ly, lz) on, along x or z to match stride, written from
+    // index start on.
+    void FillStrip(const Chunk* chunk, int lx, int ly, int lz, int stride, int count, int start, bool withLight) {
+        for (int i = 0; i < count; i++) {
+            int cell = start + i * stride;
+            if (!chunk) { solid[cell] = 0; light[cell] = MAX_LIGHT; continue; }
+            int index = (stride == STRIDE_X) ? Chunk::Index(lx + i, ly, lz) : Chunk::Index(lx, ly, lz + i);
+            solid[cell] = IsSolidBlock(chunk->blocks.Get(index));
+            if (withLight) light[cell] = (uint8_t)CombinedLight(chunk->light[index]);
+        }
+    }
+};
+
+// Shading of the four corners of one face direction. Each corner looks at the cell in front of the
+// face plus the two beside it and the one diagonal to it in that layer: classic three-neighbour
+// voxel AO from their solid flags, and smooth light as the mean level of those that are open (the
+// diagonal one only counts when it is not hidden behind both sides). The offsets into PaddedVolume
+// are worked out once per direction.
+struct FaceShadeSampler {
+    int front;          // From a block to the cell its face looks into
+    int side1[4], side2[4];
+
+    explicit FaceShadeSampler(const VoxelFace& face) {
+        const int strides[3] = { PaddedVolume::STRIDE_X, PaddedVolume::STRIDE_Y, PaddedVolume::STRIDE_Z };
+        int uAxis = (face.axis + 1) % 3, vAxis = (face.axis + 2) % 3;
+        front = face.dir * strides[face.axis];
+        for (int i = 0; i < 4; i++) {
+            int c = face.corners[i];
+            side1[i] = ((c >> uAxis) & 1) ? strides[uAxis] : -strides[uAxis];
+            side2[i] = ((c >> vAxis) & 1) ? strides[vAxis] : -strides[vAxis];
+        }
+    }
+
+    // Packed as CornerAo() / CornerLight() read it, for the block at PaddedVolume::Index()
+    // paddedIndex. Without smoothLight every corner reads as fully lit.
+    uint32_t Sample(const PaddedVolume& volume, int paddedIndex, bool smoothLight) const {
+        // AO by (side1, side2, corner) solid bits; two solid sides hide the corner completely.
+        static const uint8_t kAo[8] = { 3, 2, 2, 1, 2, 1, 0, 0 };
+        int cell = paddedIndex + front;
+        const uint8_t* solid = &volume.solid[cell];
+        const uint8_t* light = &volume.light[cell];
+        uint32_t packed = 0;
+        for (int i = 0; i < 4; i++) {
+            int a = side1[i], b = side2[i], c = side1[i] + side2[i];
+            int bits = solid[a] << 2 | solid[b] << 1 | solid[c];
+            int level = MAX_LIGHT;
+            if (smoothLight) {
+                int sum = light[0], count = 1;
+                if (!solid[a]) { sum += light[a]; count++; }
+                if (!solid[b]) { sum += light[b]; count++; }
+                if (!solid[c] && !(solid[a] && solid[b])) { sum += light[c]; count++; }
+                level = sum / count;
+            }
+            packed |= CornerShade(kAo[bits], level) << (i * 6);
+        }
+        return packed;
+    }
+};
+
+// Greedy mesher: runs the hidden-face pass, then for every face direction sweeps the chunk slice by
+// slice, collects the visible faces into a 2D mask and merges runs of the same block type into the
+// largest rectangles it can.
+//
+// Faces only merge when their corner shading matches as well, and only along a direction it does
+// not change in, so every merged quad shades exactly like the faces it replaces.
+inline void MeshChunk(const ChunkNeighborhood& n, ChunkMesh& out, MeshShading shading = MESH_AO_AND_LIGHT) {
+    const Chunk& chunk = *n.center;
+    out.coord = chunk.coord;
+    out.lodLevel = 0;
+    out.vertices.clear();
+    out.quadCount = 0;
+
+    uint8_t blocks[CHUNK_BLOCKS];
+    chunk.blocks.Unpack(blocks);
+    uint8_t faceMask[CHUNK_BLOCKS];
+    ComputeFaceVisibility(n, blocks, faceMask, out.cull);
+
+    static thread_local PaddedVolume volume;
+    if (shading != MESH_FLAT) volume.Fill(n, blocks, shading == MESH_AO_AND_LIGHT);
+
+    const int dims[3] = { CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE };
+    uint32_t mask[CHUNK_SIZE * CHUNK_HEIGHT];   // Block id, corner shading above it
+
+    for (int f = 0; f < 6; f++) {
+        const VoxelFace& face = kVoxelFaces[f];
+        int uAxis = (face.axis + 1) % 3;
+        int vAxis = (face.axis + 2) % 3;
+        int du = dims[uAxis], dv = dims[vAxis];
+
+        FaceShadeSampler sampler(face);
+        // Corner index at each (u, v) end of the face, to tell which way its shading is flat.
+        int cornerAt[2][2];
+        for (int i = 0; i < 4; i++) cornerAt[(face.corners[i] >> uAxis) & 1][(face.corners[i] >> vAxis) & 1] = i;
+
+        for (int slice = 0; slice < dims[face.axis]; slice++) {
+            int p[3];
+            p[face.axis] = slice;
+            for (int v = 0; v < dv; v++) {
+                p[vAxis] = v;
+                for (int u = 0; u < du; u++) {
+                    p[uAxis] = u;
+                    int index = Chunk::Index(p[0], p[1], p[2]);
+                    uint32_t key = BLOCK_AIR;
+                    if (faceMask[index] & (1 << f)) {
+                        uint32_t shade = (shading == MESH_FLAT) ? SHADE_FULL
+                                       : sampler.Sample(volume, PaddedVolume::Index(p[0], p[1], p[2]), shading == MESH_AO_AND_LIGHT);
+                        key = blocks[index] | shade << 8;
+                    }
+                    mask[v * du + u] = key;
+                }
+            }
+
+            for (int v = 0; v < dv; v++) {
+                for (int u = 0; u < du; ) {
+                    uint32_t key = mask[v * du + u];
+                    if (key == BLOCK_AIR) { u++; continue; }
+                    uint32_t shade = key >> 8;
+                    uint32_t s00 = (shade >> (cornerAt[0][0] * 6)) & 63, s10 = (shade >> (cornerAt[1][0] * 6)) & 63;
+                    uint32_t s01 = (shade >> (cornerAt[0][1] * 6)) & 63, s11 = (shade >> (cornerAt[1][1] * 6)) & 63;
+                    bool flatU = s00 == s10 && s01 == s11;
+                    bool flatV = s00 == s01 && s10 == s11;
+
+                    int w = 1;
+                    while (flatU && u + w < du && mask[v * du + u + w] == key) w++;
+
+                    int h = 1;
+                    for (; flatV && v + h < dv; h++) {
+                        bool rowMatches = true;
+                        for (int k = 0; k < w; k++) {
+                            if (mask[(v + h) * du + u + k] != key) { rowMatches = false; break; }
+                        }
+                        if (!rowMatches) break;
+                    }
+
+                    EmitQuad(chunk, face, slice, u, v, w, h, (uint8_t)key, shade, out);
+                    for (int dy = 0; dy < h; dy++) std::fill(&mask[(v + dy) * du + u], &mask[(v + dy) * du + u + w], (uint32_t)BLOCK_AIR);
+                    u += w;
+                }
+            }
+        }
+    }
+
+    ComputeMeshBounds(out);
+}
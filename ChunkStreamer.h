@@ -0,0 +1,126 @@
+#pragma once
+#include "ChunkBuilder.h"
+#include "RegionFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+struct StreamingStats {
+    size_t resident = 0;            // Chunks in the world
+    size_t wanted = 0;              // Chunks inside the load radius
+    size_t pending = 0;             // Chunk loads on the builder not back yet
+    size_t memoryBytes = 0;         // Held by the resident chunks
+    int loadsStarted = 0;           // By the last Update()
+    int unloads = 0;                // By the last Update()
+    size_t saving = 0;              // Unloaded edited chunks still being written to the store
+    size_t totalLoads = 0;
+    size_t totalUnloads = 0;
+    double updateMs = 0.0;          // Time the last Update() took
+    double worstOverrunMs = 0.0;    // Most any Update() has gone past BudgetMs
+};
+
+// Keeps the chunks around the camera resident. Every frame Update() works out the chunks within
+// LoadRadius of the camera, starts loads for the missing ones through a priority queue (nearest
+// first, and chunks ahead of the camera before those beside and behind it) and unloads chunks
+// beyond UnloadRadius, farthest first. Edited ones are saved through ChunkBuilder::Save(), off the
+// frame since a save can compact the whole region file; the builder loads no chunk, here or for a
+// neighbour in Schedule(), while its save is pending. The gap between the two radii is the
+// hysteresis: pacing back and forth over a chunk border neither reloads nor drops anything.
+// Both loops stop once the frame's budget is spent and loads in flight are capped at MaxPending,
+// so a teleport spreads its work over several frames.
+class ChunkStreamer {
+public:
+    int LoadRadius;         // Blocks, same Chebyshev distance as the LOD rings
+    int UnloadRadius;
+    double BudgetMs;
+    int MaxPending;
+    StreamingStats Stats;
+
+    // The default load radius is ring 0 plus the neighbour chunks its meshes need.
+    explicit ChunkStreamer(int loadRadius = kLodRingRadius[0] + CHUNK_SIZE, int unloadRadius = kLodRingRadius[0] + 3 * CHUNK_SIZE,
+                           double budgetMs = 1.0, int maxPending = 16)
+        : LoadRadius(loadRadius), UnloadRadius(std::max(unloadRadius, loadRadius)), BudgetMs(budgetMs), MaxPending(maxPending) {}
+
+    // Lower is loaded first: the distance to the chunk centre, times 1 ahead of the camera up to 3
+    // behind it. (forwardX, forwardZ) need not be normalized; zero means no preferred direction.
+    static float Priority(ChunkCoord coord, float camX, float camZ, float forwardX, float forwardZ) {
+        float dx = (coord.x + 0.5f) * CHUNK_SIZE - 0.5f - camX;
+        float dz = (coord.z + 0.5f) * CHUNK_SIZE - 0.5f - camZ;
+        float distance = sqrtf(dx * dx + dz * dz);
+        float forwardLength = sqrtf(forwardX * forwardX + forwardZ * forwardZ);
+        if (distance < CHUNK_SIZE || forwardLength == 0.0f) return distance;
+        float facing = (dx * forwardX + dz * forwardZ) / (distance * forwardLength);
+        return distance * (2.0f - facing);
+    }
+
+    // Call once per frame before the builder's Schedule(). Edited chunks that are unloaded go to
+    // store, if given; without one their edits are lost. store must outlive the builder.
+    void Update(VoxelWorld& world, ChunkBuilder& builder, RegionStore* store, float camX, float camZ, float forwardX, float forwardZ) {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsedMs = [start]() { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+        int camBlockX = (int)floor(camX + 0.5f), camBlockZ = (int)floor(camZ + 0.5f);
+        Stats.loadsStarted = 0;
+        Stats.unloads = 0;
+        m_Started.clear();
+
+        // Unloads first, so a frame that runs out of budget still frees memory.
+        m_Unload.clear();
+        world.ForEachChunk([&](const std::shared_ptr<Chunk>& chunk) {
+            int distance = ChunkDistance(chunk->coord, camBlockX, camBlockZ);
+            if (distance > UnloadRadius) m_Unload.push_back({ (float)-distance, chunk->coord });
+        });
+        std::sort(m_Unload.begin(), m_Unload.end(), ByPriority);
+        for (const auto& entry : m_Unload) {
+            if (elapsedMs() >= BudgetMs) break;
+            std::shared_ptr<Chunk> chunk = world.RemoveChunk(entry.second);
+            if (chunk->modified && store) builder.Save(*store, std::move(chunk));
+            Stats.unloads++;
+        }
+
+        // Loads: every missing chunk in range goes on the heap, the best ones are started.
+        m_Load.clear();
+        Stats.wanted = 0;
+        ChunkCoord center = ChunkCoordOf(camBlockX, camBlockZ);
+        int reach = LoadRadius / CHUNK_SIZE + 1;
+        for (int cx = center.x - reach; cx <= center.x + reach; cx++) {
+            for (int cz = center.z - reach; cz <= center.z + reach; cz++) {
+                ChunkCoord coord = { cx, cz };
+                if (ChunkDistance(coord, camBlockX, camBlockZ) > LoadRadius) continue;
+                Stats.wanted++;
+                if (world.FindChunk(coord) || builder.IsGenerating(coord) || builder.IsSaving(coord)) continue;
+                m_Load.push_back({ Priority(coord, camX, camZ, forwardX, forwardZ), coord });
+            }
+        }
+        std::make_heap(m_Load.begin(), m_Load.end(), ByPriorityHeap);
+        while (!m_Load.empty() && builder.Generating() < MaxPending && elapsedMs() < BudgetMs) {
+            std::pop_heap(m_Load.begin(), m_Load.end(), ByPriorityHeap);
+            ChunkCoord coord = m_Load.back().second;
+            m_Load.pop_back();
+            if (!builder.Load(world, coord)) continue;
+            m_Started.push_back(coord);
+            Stats.loadsStarted++;
+        }
+
+        Stats.totalLoads += Stats.loadsStarted;
+        Stats.totalUnloads += Stats.unloads;
+        Stats.resident = world.ChunkCount();
+        Stats.pending = builder.Generating();
+        Stats.saving = builder.Saving();
+        Stats.memoryBytes = world.ChunkMemoryBytes();
+        Stats.updateMs = elapsedMs();
+        Stats.worstOverrunMs = std::max(Stats.worstOverrunMs, Stats.updateMs - BudgetMs);
+    }
+
+    // Loads started by the last Update(), in the order they were queued.
+    const std::vector<ChunkCoord>& Started() const { return m_Started; }
+
+private:
+    typedef std::pair<float, ChunkCoord> Entry;
+    static bool ByPriority(const Entry& a, const Entry& b) { return a.first < b.first; }
+    static bool ByPriorityHeap(const Entry& a, const Entry& b) { return a.first > b.first; }   // Min-heap
+
+    std::vector<Entry> m_Unload;
+    std::vector<Entry> m_Load;
+    std::vector<ChunkCoord> m_Started;
+};
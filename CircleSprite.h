@@ -0,0 +1,80 @@
+#pragma once
+#include "imgui.h"
+#include <math.h>
+#include <stddef.h>
+
+// An anti-aliased white disc baked once into a custom rectangle of the font atlas, so any number of
+// circles can be drawn as one textured quad each. The atlas is the texture ImGui draws text and
+// shapes with, so the quads land in the same draw command as the rest of the window; 16-bit
+// indices only split it every 16k circles. AddCircleFilled() instead builds a polygon plus an
+// anti-aliasing fringe per circle, 48 vertices at the enemies' radius and more for larger ones.
+class CircleSprite {
+public:
+    static const int kSize = 64;            // Texels per side; the disc leaves a 1 texel clear border
+
+    // Adds the rectangle and writes the disc into it. Call after NewFrame(), when the atlas texture
+    // exists; the backend uploads the new texels with the next frame. False if the atlas is full.
+    bool Bake(ImFontAtlas* atlas) {
+        ImFontAtlasRect r;
+        m_Id = atlas->AddCustomRect(kSize, kSize, &r);
+        if (m_Id == ImFontAtlasRectId_Invalid) return false;
+        ImTextureData* tex = atlas->TexData;
+        for (int y = 0; y < kSize; y++) {
+            for (int x = 0; x < kSize; x++) {
+                unsigned char alpha = Coverage(x, y);
+                if (tex->Format == ImTextureFormat_Alpha8) *(ImU8*)tex->GetPixelsAt(r.x + x, r.y + y) = alpha;
+                else *(ImU32*)(void*)tex->GetPixelsAt(r.x + x, r.y + y) = IM_COL32(255, 255, 255, alpha);
+            }
+        }
+        m_Atlas = atlas;
+        return true;
+    }
+
+    bool IsBaked() const { return m_Atlas != nullptr; }
+    ImFontAtlas* Atlas() const { return m_Atlas; }
+
+    // The rectangle moves whenever the atlas grows or is repacked, so this is looked up every
+    // frame rather than stored. False if the atlas has been cleared since Bake().
+    bool GetUv(ImVec2& uv0, ImVec2& uv1) const {
+        ImFontAtlasRect r;
+        if (!m_Atlas || !m_Atlas->GetCustomRect(m_Id, &r)) return false;
+        uv0 = r.uv0; uv1 = r.uv1;
+        return true;
+    }
+
+    // Alpha of texel (x, y): the disc's edge is a one texel wide ramp, like ImGui's own AA fringe.
+    static unsigned char Coverage(int x, int y) {
+        float dx = x + 0.5f - kSize * 0.5f, dy = y + 0.5f - kSize * 0.5f;
+        float alpha = Radius() + 0.5f - sqrtf(dx * dx + dy * dy);
+        alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+        return (unsigned char)(alpha * 255.0f + 0.5f);
+    }
+
+    // The disc's radius in texels; a quad of half-size radius * HalfExtent() draws a circle of radius.
+    static float Radius() { return kSize * 0.5f - 1.0f; }
+    static float HalfExtent() { return kSize * 0.5f / Radius(); }
+
+private:
+    ImFontAtlas* m_Atlas = nullptr;
+    ImFontAtlasRectId m_Id = ImFontAtlasRectId_Invalid;
+};
+
+// Draws circles of one radius and colour at (x[i], y[i]) as one quad each, 4 vertices and 6
+// indices per circle. Reserves up to 16k quads at a time so 16-bit indices never overflow.
+// False, drawing nothing, if the sprite is not in the atlas (not baked yet, or the atlas was cleared).
+inline bool AddCircleSprites(ImDrawList* drawList, const CircleSprite& sprite, const float* x, const float* y, size_t count,
+                             float radius, ImU32 col) {
+    ImVec2 uv0, uv1;
+    if (!sprite.GetUv(uv0, uv1)) return false;
+    if (count == 0 || (col & IM_COL32_A_MASK) == 0) return true;
+    const size_t kQuadsPerReserve = 16383;
+    float h = radius * CircleSprite::HalfExtent();
+    drawList->PushTexture(sprite.Atlas()->TexRef);
+    for (size_t begin = 0; begin < count; begin += kQuadsPerReserve) {
+        size_t end = begin + kQuadsPerReserve < count ? begin + kQuadsPerReserve : count;
+        drawList->PrimReserve((int)(end - begin) * 6, (int)(end - begin) * 4);
+        for (size_t i = begin; i < end; i++) drawList->PrimRectUV(ImVec2(x[i] - h, y[i] - h), ImVec2(x[i] + h, y[i] + h), uv0, uv1, col);
+    }
+    drawList->PopTexture();
+    return true;
+}
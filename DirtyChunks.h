@@ -0,0 +1,101 @@
+#pragma once
+#include "ChunkBuilder.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// Chunks whose meshes are out of date after block edits. An edit marks the chunk it is in, plus
+// the neighbour across the face when the block sits on a chunk border (its hidden faces there may
+// have become visible, and its ambient occlusion changed), and the diagonal neighbour for a block
+// in a chunk's corner column. Any number of edits to a chunk before its remesh starts collapse into one
+// remesh, and at most MaxRemeshesPerFrame are started per frame, oldest edit first, so an edit
+// storm costs a bounded amount of work per frame instead of a rebuild of everything around it.
+//
+// Latency is measured from the first edit a remesh covers until its mesh comes back, and the last
+// LatencyWindow samples are kept in a ring, so a long session neither grows memory nor slows the
+// percentiles down.
+class DirtyChunks {
+public:
+    int MaxRemeshesPerFrame;
+    size_t LatencyWindow;
+    size_t EditsMarked = 0;
+    size_t RemeshesStarted = 0;
+
+    explicit DirtyChunks(int maxRemeshesPerFrame = 4, size_t latencyWindow = 1024)
+        : MaxRemeshesPerFrame(maxRemeshesPerFrame), LatencyWindow(std::max<size_t>(1, latencyWindow)) {}
+
+    void MarkBlock(int x, int z, double now) {
+        EditsMarked++;
+        ChunkCoord c = ChunkCoordOf(x, z);
+        MarkChunk(c, now);
+        int lx = x - c.x * CHUNK_SIZE, lz = z - c.z * CHUNK_SIZE;
+        if (lx == 0)              MarkChunk({ c.x - 1, c.z }, now);
+        if (lx == CHUNK_SIZE - 1) MarkChunk({ c.x + 1, c.z }, now);
+        if (lz == 0)              MarkChunk({ c.x, c.z - 1 }, now);
+        if (lz == CHUNK_SIZE - 1) MarkChunk({ c.x, c.z + 1 }, now);
+        int dx = (lx == 0) ? -1 : (lx == CHUNK_SIZE - 1) ? 1 : 0;
+        int dz = (lz == 0) ? -1 : (lz == CHUNK_SIZE - 1) ? 1 : 0;
+        if (dx && dz) MarkChunk({ c.x + dx, c.z + dz }, now);
+    }
+
+    // Keeps the time of the oldest edit still waiting.
+    void MarkChunk(ChunkCoord c, double now) {
+        m_Dirty.insert({ c, now });
+    }
+
+    // Starts remeshes for up to MaxRemeshesPerFrame dirty chunks. Chunks that are no longer loaded
+    // are dropped; chunks whose previous mesh is still being built wait for the next frame.
+    int Flush(const VoxelWorld& world, ChunkBuilder& builder) {
+        m_Order.assign(m_Dirty.begin(), m_Dirty.end());
+        std::sort(m_Order.begin(), m_Order.end(), [](const std::pair<ChunkCoord, double>& a, const std::pair<ChunkCoord, double>& b) { return a.second < b.second; });
+        int started = 0;
+        for (const auto& entry : m_Order) {
+            if (started >= MaxRemeshesPerFrame) break;
+            if (!world.FindChunkShared(entry.first)) { m_Dirty.erase(entry.first); continue; }
+            if (!builder.Remesh(world, entry.first)) continue;
+            m_InFlight[entry.first] = entry.second;
+            m_Dirty.erase(entry.first);
+            started++;
+        }
+        RemeshesStarted += started;
+        return started;
+    }
+
+    // Call with every full-resolution mesh Poll() returns. Records and returns the latency when it
+    // is a remesh started by Flush(), -1 otherwise.
+    double Finished(ChunkCoord c, double now) {
+        auto it = m_InFlight.find(c);
+        if (it == m_InFlight.end()) return -1.0;
+        double latency = now - it->second;
+        m_InFlight.erase(it);
+        if (m_Latencies.size() < LatencyWindow) m_Latencies.push_back((float)latency);
+        else m_Latencies[m_NextLatency] = (float)latency;
+        m_NextLatency = (m_NextLatency + 1) % LatencyWindow;
+        return latency;
+    }
+
+    size_t Pending() const { return m_Dirty.size(); }
+    size_t InFlight() const { return m_InFlight.size(); }
+
+    // Remesh latencies in seconds at each of percentiles[0..count) in [0, 100], over the samples in
+    // the window. Sorts one copy of the window for all of them; 0 while there are no samples.
+    void LatencyPercentiles(const double* percentiles, double* out, int count) const {
+        m_Sorted.assign(m_Latencies.begin(), m_Latencies.end());
+        std::sort(m_Sorted.begin(), m_Sorted.end());
+        for (int i = 0; i < count; i++) {
+            if (m_Sorted.empty()) { out[i] = 0.0; continue; }
+            size_t rank = std::min(m_Sorted.size() - 1, (size_t)(percentiles[i] / 100.0 * (m_Sorted.size() - 1) + 0.5));
+            out[i] = m_Sorted[rank];
+        }
+    }
+    size_t LatencySamples() const { return m_Latencies.size(); }
+    void ClearLatencies() { m_Latencies.clear(); m_NextLatency = 0; }
+
+private:
+    std::unordered_map<ChunkCoord, double, ChunkCoordHash> m_Dirty;     // Oldest pending edit per chunk
+    std::unordered_map<ChunkCoord, double, ChunkCoordHash> m_InFlight;  // Remeshes started, by oldest edit covered
+    std::vector<std::pair<ChunkCoord, double>> m_Order;
+    std::vector<float> m_Latencies;         // Ring of the last LatencyWindow samples
+    size_t m_NextLatency = 0;
+    mutable std::vector<float> m_Sorted;    // LatencyPercentiles() scratch
+};
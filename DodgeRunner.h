@@ -0,0 +1,133 @@
+#pragma once
+#include "GalleDodgeSim.h"
+#include "JobSystem.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// What a policy remembers between ticks of one game; zeroed at the start of every game.
+struct DodgeBotMemory {
+    uint32_t rng = 1;
+    uint32_t held = 0;
+};
+
+// A dodging policy: looks at the game and returns the next tick's input bits.
+typedef uint32_t (*DodgePolicy)(const DodgeGame& game, DodgeBotMemory& memory);
+
+// Holds a random direction, sometimes sprinting, for a quarter of a second at a time.
+inline uint32_t DodgeRandomPolicy(const DodgeGame& game, DodgeBotMemory& memory) {
+    if (game.ticks % 30 == 0) {
+        memory.rng = memory.rng * 1664525u + 1013904223u;
+        memory.held = (memory.rng >> 16) & (DODGE_LEFT | DODGE_RIGHT | DODGE_UP | DODGE_DOWN | DODGE_SPRINT);
+    }
+    return memory.held;
+}
+
+// Steps sideways out of the path of the most threatening enemy: the one whose closest approach
+// comes soonest within a few hit radii. Sprints when that approach is less than half a second away
+// and drifts back towards the middle of the arena when nothing is coming.
+inline uint32_t DodgeFleePolicy(const DodgeGame& game, DodgeBotMemory&) {
+    float cx = game.CenterX(), cy = game.CenterY();
+    float danger = PLAYER_SIZE * 0.4f + ENEMY_RADIUS;
+    float bestT = 1e30f, awayX = 0.0f, awayY = 0.0f;
+    for (size_t i = 0; i < game.enemies.Count(); i++) {
+        float rx = cx - game.enemies.x[i], ry = cy - game.enemies.y[i];
+        float vx = game.enemies.vx[i], vy = game.enemies.vy[i];
+        float v2 = vx * vx + vy * vy;
+        if (v2 <= 0.0f) continue;
+        float t = (rx * vx + ry * vy) / v2;             // When it passes closest
+        if (t < 0.0f || t >= bestT) continue;
+        float mx = rx - vx * t, my = ry - vy * t;       // Player relative to that closest point
+        if (mx * mx + my * my > (danger * 3.0f) * (danger * 3.0f)) continue;
+        bestT = t;
+        // Dodge along the miss vector; dead centre picks the perpendicular of the velocity.
+        if (mx * mx + my * my > 1.0f) { awayX = mx; awayY = my; }
+        else { awayX = -vy; awayY = vx; }
+    }
+    uint32_t input = 0;
+    if (bestT < 1e30f) {
+        // Against a wall, run the other way along it.
+        if (game.posX <= 0.0f && awayX < 0.0f) awayX = 0.0f;
+        if (game.posX >= game.width - PLAYER_SIZE && awayX > 0.0f) awayX = 0.0f;
+        if (game.posY <= 0.0f && awayY < 0.0f) awayY = 0.0f;
+        if (game.posY >= game.height - PLAYER_SIZE && awayY > 0.0f) awayY = 0.0f;
+        if (awayX == 0.0f && awayY == 0.0f) awayX = game.posX < game.width * 0.5f ? 1.0f : -1.0f;
+        if (fabsf(awayX) * 2.0f >= fabsf(awayY)) input |= awayX < 0.0f ? DODGE_LEFT : DODGE_RIGHT;
+        if (fabsf(awayY) * 2.0f >= fabsf(awayX)) input |= awayY < 0.0f ? DODGE_UP : DODGE_DOWN;
+        if (bestT < 0.5f) input |= DODGE_SPRINT;
+    } else {
+        float dx = game.width * 0.5f - cx, dy = game.height * 0.5f - cy;
+        if (dx < -PLAYER_SIZE) input |= DODGE_LEFT;
+        if (dx > PLAYER_SIZE) input |= DODGE_RIGHT;
+        if (dy < -PLAYER_SIZE) input |= DODGE_UP;
+        if (dy > PLAYER_SIZE) input |= DODGE_DOWN;
+    }
+    return input;
+}
+
+struct DodgeResult {
+    uint32_t seed = 0;
+    int score = 0;
+    uint64_t ticks = 0;         // How long the game lasted
+};
+
+// Plays one game from seed to the end, or for at most maxTicks, reusing game's arrays.
+inline DodgeResult PlayDodge(DodgeGame& game, uint32_t seed, DodgePolicy policy, float dt, uint64_t maxTicks) {
+    DodgeBotMemory memory;
+    memory.rng = seed;
+    game.Reset(seed);
+    while (!game.over && game.ticks < maxTicks) StepDodge(game, policy(game, memory), dt);
+    DodgeResult result;
+    result.seed = seed;
+    result.score = game.score;
+    result.ticks = game.ticks;
+    return result;
+}
+
+// Plays one game per seed, firstSeed to firstSeed + count - 1, and leaves them in results in seed
+// order. Seeds go out in batches through ParallelFor, so the workers and the calling thread keep
+// claiming batches until none are left and long games do not hold up the rest. Every game owns
+// its state and random numbers, so the results do not depend on the thread count.
+inline void RunDodgeSeeds(JobSystem& jobs, uint32_t firstSeed, int count, DodgePolicy policy, float dt, uint64_t maxTicks,
+                          std::vector<DodgeResult>& results, int batchSize = 16) {
+    results.resize(count);
+    int batches = (count + batchSize - 1) / batchSize;
+    jobs.ParallelFor(batches, [&](int batch) {
+        DodgeGame game;
+        int end = std::min(count, (batch + 1) * batchSize);
+        for (int i = batch * batchSize; i < end; i++) results[i] = PlayDodge(game, firstSeed + (uint32_t)i, policy, dt, maxTicks);
+    });
+}
+
+struct DodgeScoreStats {
+    int games = 0;
+    double mean = 0.0, stddev = 0.0;
+    int minScore = 0, p10 = 0, median = 0, p90 = 0, maxScore = 0;
+    double meanSeconds = 0.0;   // Average game length
+    uint64_t ticks = 0;         // All games together
+};
+
+inline DodgeScoreStats SummarizeDodge(const std::vector<DodgeResult>& results, float dt) {
+    DodgeScoreStats stats;
+    stats.games = (int)results.size();
+    if (results.empty()) return stats;
+    std::vector<int> scores;
+    scores.reserve(results.size());
+    double sum = 0.0, sumSq = 0.0;
+    for (const DodgeResult& r : results) {
+        scores.push_back(r.score);
+        sum += r.score;
+        sumSq += (double)r.score * r.score;
+        stats.ticks += r.ticks;
+    }
+    std::sort(scores.begin(), scores.end());
+    stats.mean = sum / stats.games;
+    stats.stddev = sqrt(std::max(0.0, sumSq / stats.games - stats.mean * stats.mean));
+    stats.minScore = scores.front();
+    stats.p10 = scores[scores.size() / 10];
+    stats.median = scores[scores.size() / 2];
+    stats.p90 = scores[scores.size() * 9 / 10];
+    stats.maxScore = scores.back();
+    stats.meanSeconds = (double)stats.ticks * dt / stats.games;
+    return stats;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SWARM_SIMD 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// GalleDodge's enemies as a structure of arrays, one array per field, so a step streams through
+// each of them 4 or 8 enemies at a time. Order is not kept: Remove() moves the last enemy into
+// the hole, so removing is O(1) however many enemies leave in one frame.
+struct EnemySwarm {
+    std::vector<float> x, y, vx, vy;
+    std::vector<uint32_t> leaving;  // Scratch for StepEnemies(), indices in ascending order
+
+    void Clear() { x.clear(); y.clear(); vx.clear(); vy.clear(); }
+    size_t Count() const { return x.size(); }
+    void Add(float px, float py, float velX, float velY) {
+        x.push_back(px); y.push_back(py); vx.push_back(velX); vy.push_back(velY);
+    }
+    void Remove(size_t i) {
+        size_t last = x.size() - 1;
+        x[i] = x[last]; y[i] = y[last]; vx[i] = vx[last]; vy[i] = vy[last];
+        x.pop_back(); y.pop_back(); vx.pop_back(); vy.pop_back();
+    }
+};
+
+// The player's circle and the area enemies may be in; one beyond margin of the screen has been dodged.
+struct SwarmArena {
+    float playerX, playerY;
+    float hitRadius;            // Player radius plus enemy radius
+    float width, height;
+    float margin;
+};
+
+struct SwarmStepResult {
+    bool playerHit = false;
+    int escaped = 0;            // Enemies that left the arena and were removed
+};
+
+// Moves every enemy by velocity * dt, then tests it against the player circle and the arena.
+// Enemies that touch the player set playerHit; enemies outside the arena are removed. One pass
+// does the moves and both tests, 8 enemies per step with AVX, 4 with SSE, and collects the
+// leavers; they are then removed from the back so each swap-and-pop fills its hole with an enemy
+// that stays. Distances are compared squared, no square roots.
+inline SwarmStepResult StepEnemies(EnemySwarm& swarm, float dt, const SwarmArena& arena) {
+    SwarmStepResult result;
+    size_t count = swarm.Count();
+    float* px = swarm.x.data(); float* py = swarm.y.data();
+    const float* vx = swarm.vx.data(); const float* vy = swarm.vy.data();
+    float hitSq = arena.hitRadius * arena.hitRadius;
+    float minX = -arena.margin, maxX = arena.width + arena.margin;
+    float minY = -arena.margin, maxY = arena.height + arena.margin;
+    swarm.leaving.clear();
+    int hitBits = 0;
+    size_t i = 0;
+#if defined(__AVX__)
+    {
+        __m256 t = _mm256_set1_ps(dt), cx = _mm256_set1_ps(arena.playerX), cy = _mm256_set1_ps(arena.playerY), r2 = _mm256_set1_ps(hitSq);
+        __m256 lowX = _mm256_set1_ps(minX), highX = _mm256_set1_ps(maxX), lowY = _mm256_set1_ps(minY), highY = _mm256_set1_ps(maxY);
+        __m256 hit = _mm256_setzero_ps();
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_add_ps(_mm256_loadu_ps(px + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), t));
+            __m256 y = _mm256_add_ps(_mm256_loadu_ps(py + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), t));
+            _mm256_storeu_ps(px + i, x);
+            _mm256_storeu_ps(py + i, y);
+            __m256 dx = _mm256_sub_ps(cx, x), dy = _mm256_sub_ps(cy, y);
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            hit = _mm256_or_ps(hit, _mm256_cmp_ps(d2, r2, _CMP_LT_OQ));
+            __m256 out = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(x, lowX, _CMP_LT_OQ), _mm256_cmp_ps(x, highX, _CMP_GT_OQ)),
+                                      _mm256_or_ps(_mm256_cmp_ps(y, lowY, _CMP_LT_OQ), _mm256_cmp_ps(y, highY, _CMP_GT_OQ)));
+            int bits = _mm256_movemask_ps(out);
+            for (int k = 0; bits != 0; k++, bits >>= 1) if (bits & 1) swarm.leaving.push_back((uint32_t)(i + k));
+        }
+        hitBits |= _mm256_movemask_ps(hit);
+    }
+#endif
+#ifdef SWARM_SIMD
+    {
+        __m128 t = _mm_set1_ps(dt), cx = _mm_set1_ps(arena.playerX), cy = _mm_set1_ps(arena.playerY), r2 = _mm_set1_ps(hitSq);
+        __m128 lowX = _mm_set1_ps(minX), highX = _mm_set1_ps(maxX), lowY = _mm_set1_ps(minY), highY = _mm_set1_ps(maxY);
+        __m128 hit = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), t));
+            __m128 y = _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(_mm_loadu_ps(vy + i), t));
+            _mm_storeu_ps(px + i, x);
+            _mm_storeu_ps(py + i, y);
+            __m128 dx = _mm_sub_ps(cx, x), dy = _mm_sub_ps(cy, y);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            hit = _mm_or_ps(hit, _mm_cmplt_ps(d2, r2));
+            __m128 out = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(x, lowX), _mm_cmpgt_ps(x, highX)),
+                                   _mm_or_ps(_mm_cmplt_ps(y, lowY), _mm_cmpgt_ps(y, highY)));
+            int bits = _mm_movemask_ps(out);
+            for (int k = 0; bits != 0; k++, bits >>= 1) if (bits & 1) swarm.leaving.push_back((uint32_t)(i + k));
+        }
+        hitBits |= _mm_movemask_ps(hit);
+    }
+#endif
+    for (; i < count; i++) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        float dx = arena.playerX - px[i], dy = arena.playerY - py[i];
+        if (dx * dx + dy * dy < hitSq) hitBits |= 1;
+        if (px[i] < minX || px[i] > maxX || py[i] < minY || py[i] > maxY) swarm.leaving.push_back((uint32_t)i);
+    }
+
+    for (size_t k = swarm.leaving.size(); k-- > 0; ) swarm.Remove(swarm.leaving[k]);
+    result.playerHit = hitBits != 0;
+    result.escaped = (int)swarm.leaving.size();
+    return result;
+}
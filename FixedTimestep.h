@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// Fixed-step simulation clock. Each frame feeds its real delta into Advance(), which says how many
+// whole ticks of Step seconds to simulate; the leftover fraction comes back as Alpha() for
+// interpolating between the last two simulated states. The simulation itself only ever sees Step,
+// so it behaves the same at any frame rate and replays bit for bit from the same per-tick input.
+class FixedTimestep {
+public:
+    float Step;
+    int MaxTicksPerFrame;   // After a long stall the clock drops time instead of trying to catch up
+    uint64_t Ticks = 0;
+
+    explicit FixedTimestep(float step = 1.0f / 60.0f, int maxTicksPerFrame = 8)
+        : Step(step), MaxTicksPerFrame(maxTicksPerFrame) {}
+
+    int Advance(float frameDt) {
+        if (frameDt > 0.0f) m_Accumulator += frameDt;
+        int ticks = (int)(m_Accumulator / Step);
+        if (ticks > MaxTicksPerFrame) {
+            ticks = MaxTicksPerFrame;
+            m_Accumulator = Step * ticks;
+        }
+        m_Accumulator -= Step * ticks;
+        Ticks += ticks;
+        return ticks;
+    }
+
+    // How far real time is between the last tick and the next one, in [0, 1).
+    float Alpha() const { return (float)(m_Accumulator / Step); }
+
+    void Reset() { m_Accumulator = 0.0; Ticks = 0; }
+
+private:
+    double m_Accumulator = 0.0;
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include "CameraMath.h"
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SIMD 1
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// A point p is inside when nx * p.x + ny * p.y + nz * p.z + d >= 0.
+struct Plane {
+    float nx, ny, nz, d;
+};
+
+// The clip volume of a view-projection matrix in world space. The camera's far plane is at
+// infinity, so there are only the four sides and the near plane.
+struct Frustum {
+    static const int PLANE_COUNT = 5;
+    Plane planes[PLANE_COUNT];
+
+    // Gribb-Hartmann: with clip = M * p, the conditions w + x >= 0, w - x >= 0, w + y >= 0,
+    // w - y >= 0 and z >= 0 are planes made of sums of M's rows.
+    static Frustum FromMatrix(const Mat4& viewProj) {
+        const float sign[PLANE_COUNT] = { 1.0f, -1.0f, 1.0f, -1.0f, 0.0f };
+        const int axis[PLANE_COUNT] = { 0, 0, 1, 1, 2 };
+        Frustum frustum;
+        for (int i = 0; i < PLANE_COUNT; i++) {
+            float n[4];
+            for (int c = 0; c < 4; c++)
+                n[c] = (i == 4) ? viewProj.At(2, c) : viewProj.At(3, c) + sign[i] * viewProj.At(axis[i], c);
+            float len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            frustum.planes[i] = { n[0] / len, n[1] / len, n[2] / len, n[3] / len };
+        }
+        return frustum;
+    }
+
+    static Frustum FromCamera(const CameraMatrices& camera) { return FromMatrix(camera.viewProj); }
+
+    static Frustum FromCamera(float camX, float camY, float camZ, float yaw, float pitch, float fovScale, float aspect, float nearZ) {
+        return FromMatrix(CameraMatrices::FromCamera(camX, camY, camZ, yaw, pitch, fovScale, aspect, nearZ).viewProj);
+    }
+};
+
+// Axis-aligned boxes in structure-of-arrays form so they can be tested several at a time.
+struct AabbBatch {
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+    void Clear() { minX.clear(); minY.clear(); minZ.clear(); maxX.clear(); maxY.clear(); maxZ.clear(); }
+    size_t Count() const { return minX.size(); }
+    void Add(const float boxMin[3], const float boxMax[3]) {
+        minX.push_back(boxMin[0]); minY.push_back(boxMin[1]); minZ.push_back(boxMin[2]);
+        maxX.push_back(boxMax[0]); maxY.push_back(boxMax[1]); maxZ.push_back(boxMax[2]);
+    }
+};
+
+struct CullStats {
+    int visible = 0;
+    int culled = 0;
+};
+
+// A box is outside when it lies entirely behind one plane. Per plane and axis the farthest
+// corner along the normal contributes max(n * min, n * max), which needs no branches.
+inline bool BoxInFrustum(const Frustum& frustum, const float boxMin[3], const float boxMax[3]) {
+    for (const Plane& p : frustum.planes) {
+        float dist = p.d;
+        dist += std::max(p.nx * boxMin[0], p.nx * boxMax[0]);
+        dist += std::max(p.ny * boxMin[1], p.ny * boxMax[1]);
+        dist += std::max(p.nz * boxMin[2], p.nz * boxMax[2]);
+        if (dist < 0.0f) return false;
+    }
+    return true;
+}
+
+inline bool AabbInFrustum(const Frustum& frustum, const AabbBatch& boxes, size_t i) {
+    const float boxMin[3] = { boxes.minX[i], boxes.minY[i], boxes.minZ[i] };
+    const float boxMax[3] = { boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i] };
+    return BoxInFrustum(frustum, boxMin, boxMax);
+}
+
+// Sets visible[i] to 1 for every box that intersects the frustum and 0 otherwise.
+// Tests 8 boxes per step with AVX, 4 with SSE, and finishes the tail one at a time.
+inline void CullAabbs(const Frustum& frustum, const AabbBatch& boxes, uint8_t* visible, CullStats& stats) {
+    size_t count = boxes.Count();
+    size_t i = 0;
+#if defined(__AVX__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const Plane& p : frustum.planes) {
+            __m256 nx = _mm256_set1_ps(p.nx), ny = _mm256_set1_ps(p.ny), nz = _mm256_set1_ps(p.nz);
+            __m256 dist = _mm256_set1_ps(p.d);
+            dist = _mm256_add_ps(dist, _mm256_max_ps(_mm256_mul_ps(nx, _mm256_loadu_ps(&boxes.minX[i])), _mm256_mul_ps(nx, _mm256_loadu_ps(&boxes.maxX[i]))));
+            dist = _mm256_add_ps(dist, _mm256_max_ps(_mm256_mul_ps(ny, _mm256_loadu_ps(&boxes.minY[i])), _mm256_mul_ps(ny, _mm256_loadu_ps(&boxes.maxY[i]))));
+            dist = _mm256_add_ps(dist, _mm256_max_ps(_mm256_mul_ps(nz, _mm256_loadu_ps(&boxes.minZ[i])), _mm256_mul_ps(nz, _mm256_loadu_ps(&boxes.maxZ[i]))));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        int bits = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; k++) visible[i + k] = (uint8_t)((bits >> k) & 1);
+    }
+#endif
+#ifdef FRUSTUM_SIMD
+    for (; i + 4 <= count; i += 4) {
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+        for (const Plane& p : frustum.planes) {
+            __m128 nx = _mm_set1_ps(p.nx), ny = _mm_set1_ps(p.ny), nz = _mm_set1_ps(p.nz);
+            __m128 dist = _mm_set1_ps(p.d);
+            dist = _mm_add_ps(dist, _mm_max_ps(_mm_mul_ps(nx, _mm_loadu_ps(&boxes.minX[i])), _mm_mul_ps(nx, _mm_loadu_ps(&boxes.maxX[i]))));
+            dist = _mm_add_ps(dist, _mm_max_ps(_mm_mul_ps(ny, _mm_loadu_ps(&boxes.minY[i])), _mm_mul_ps(ny, _mm_loadu_ps(&boxes.maxY[i]))));
+            dist = _mm_add_ps(dist, _mm_max_ps(_mm_mul_ps(nz, _mm_loadu_ps(&boxes.minZ[i])), _mm_mul_ps(nz, _mm_loadu_ps(&boxes.maxZ[i]))));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, _mm_setzero_ps()));
+        }
+        int bits = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; k++) visible[i + k] = (uint8_t)((bits >> k) & 1);
+    }
+#endif
+    for (; i < count; i++) visible[i] = AabbInFrustum(frustum, boxes, i) ? 1 : 0;
+
+    stats = CullStats();
+    for (size_t k = 0; k < count; k++) {
+        if (visible[k]) stats.visible++;
+        else stats.culled++;
+    }
+}
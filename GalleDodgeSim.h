@@ -0,0 +1,125 @@
+#pragma once
+#include "EnemySwarm.h"
+#include <stdint.h>
+#include <math.h>
+
+// GalleDodge's rules, as main.cpp used to run them inline every frame.
+const float MAX_SPRINT_TIME  = 1.0f;    // Can run for 1 seconds
+const float COOLDOWN_TIME    = 1.5f;    // Must wait 1.5 seconds if overheated
+const float SPRINT_RECOVERY  = 1.5f;    // Recover faster than you drain
+const float WALK_SPEED       = 150.0f;
+const float SPRINT_SPEED     = 300.0f;
+const float PLAYER_SIZE      = 30.0f;
+const float ENEMY_RADIUS     = 20.0f;
+const float ENEMY_SPEED      = 500.0f;
+const float ENEMY_MARGIN     = 100.0f;  // How far off screen an enemy counts as dodged
+const float START_SPAWN_RATE = 2.0f;    // Start: Spawn 1 enemy every 2 seconds
+const float MIN_SPAWN_RATE   = 0.2f;
+const float SPAWN_RATE_DECAY = 0.98f;   // Every spawn makes the next one come sooner
+
+// One tick's keys as a bitmask, so inputs can be scripted, recorded and replayed.
+enum DodgeInput : uint32_t {
+    DODGE_LEFT   = 1u << 0,
+    DODGE_RIGHT  = 1u << 1,
+    DODGE_UP     = 1u << 2,
+    DODGE_DOWN   = 1u << 3,
+    DODGE_SPRINT = 1u << 4,
+};
+
+// Everything one game needs, random state included, so a game is a pure function of its seed,
+// arena size and input stream. No globals and no ImGui: it runs headless.
+struct DodgeGame {
+    EnemySwarm enemies;
+    float width = 960.0f, height = 600.0f;
+    float posX = 100.0f, posY = 100.0f;     // Top-left corner of the player
+    float sprintTimer = 0.0f;
+    float cooldownTimer = 0.0f;
+    float spawnTimer = 0.0f;
+    float spawnRate = START_SPAWN_RATE;
+    int score = 0;
+    bool over = false;                      // Set by the tick in which an enemy touches the player
+    uint64_t ticks = 0;
+    uint32_t rng = 1;
+
+    // Starts a new game. The enemy arrays keep their capacity, so later games allocate nothing.
+    void Reset(uint32_t seed, float arenaWidth = 960.0f, float arenaHeight = 600.0f) {
+        enemies.Clear();
+        width = arenaWidth; height = arenaHeight;
+        posX = 100.0f; posY = 100.0f;
+        sprintTimer = 0.0f; cooldownTimer = 0.0f;
+        spawnTimer = 0.0f; spawnRate = START_SPAWN_RATE;
+        score = 0; over = false; ticks = 0;
+        rng = seed ? seed : 1;
+    }
+
+    float CenterX() const { return posX + PLAYER_SIZE * 0.5f; }
+    float CenterY() const { return posY + PLAYER_SIZE * 0.5f; }
+};
+
+// xorshift32, standing in for rand(): same cost, but each game has its own sequence.
+inline uint32_t DodgeRandom(DodgeGame& game) {
+    uint32_t x = game.rng;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return game.rng = x;
+}
+
+// Advances a game by dt seconds: sprint and cooldown, player movement clamped to the arena,
+// spawning from a random edge towards the player, then one StepEnemies() pass that moves, scores
+// and hit-tests the enemies. Does nothing once the game is over. Call it with a fixed dt and the
+// same seed and inputs replay bit for bit.
+inline SwarmStepResult StepDodge(DodgeGame& game, uint32_t input, float dt) {
+    SwarmStepResult result;
+    if (game.over) return result;
+    game.ticks++;
+
+    float moveSpeed = WALK_SPEED;
+    if (game.cooldownTimer > 0.0f) {
+        game.cooldownTimer -= dt;
+    } else if (input & DODGE_SPRINT) {
+        moveSpeed = SPRINT_SPEED;
+        game.sprintTimer += dt;
+        if (game.sprintTimer >= MAX_SPRINT_TIME) {
+            game.cooldownTimer = COOLDOWN_TIME;
+            game.sprintTimer = 0.0f;
+        }
+    } else {
+        game.sprintTimer -= SPRINT_RECOVERY * dt;
+        if (game.sprintTimer < 0.0f) game.sprintTimer = 0.0f;
+    }
+
+    float step = moveSpeed * dt;
+    if (input & DODGE_LEFT) game.posX -= step;
+    if (input & DODGE_RIGHT) game.posX += step;
+    if (input & DODGE_UP) game.posY -= step;
+    if (input & DODGE_DOWN) game.posY += step;
+    if (game.posX < 0) game.posX = 0;
+    if (game.posY < 0) game.posY = 0;
+    if (game.posX > game.width - PLAYER_SIZE) game.posX = game.width - PLAYER_SIZE;
+    if (game.posY > game.height - PLAYER_SIZE) game.posY = game.height - PLAYER_SIZE;
+
+    game.spawnTimer -= dt;
+    if (game.spawnTimer <= 0.0f) {
+        int w = game.width >= 1.0f ? (int)game.width : 1, h = game.height >= 1.0f ? (int)game.height : 1;
+        uint32_t edge = DodgeRandom(game) % 4;
+        float sx, sy;
+        if (edge == 0) { sx = (float)(DodgeRandom(game) % w); sy = -20.0f; }
+        else if (edge == 1) { sx = game.width + 20.0f; sy = (float)(DodgeRandom(game) % h); }
+        else if (edge == 2) { sx = (float)(DodgeRandom(game) % w); sy = game.height + 20.0f; }
+        else { sx = -20.0f; sy = (float)(DodgeRandom(game) % h); }
+
+        float dx = game.posX - sx, dy = game.posY - sy;
+        float len = sqrtf(dx * dx + dy * dy);
+        if (len > 0) { dx /= len; dy /= len; }
+        game.enemies.Add(sx, sy, dx * ENEMY_SPEED, dy * ENEMY_SPEED);
+
+        game.spawnTimer = game.spawnRate;
+        game.spawnRate *= SPAWN_RATE_DECAY;
+        if (game.spawnRate < MIN_SPAWN_RATE) game.spawnRate = MIN_SPAWN_RATE;
+    }
+
+    SwarmArena arena = { game.CenterX(), game.CenterY(), PLAYER_SIZE * 0.4f + ENEMY_RADIUS, game.width, game.height, ENEMY_MARGIN };
+    result = StepEnemies(game.enemies, dt, arena);
+    game.score += result.escaped; // Score when you dodge them successfully
+    if (result.playerHit) game.over = true;
+    return result;
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bounded multi-producer/multi-consumer queue (Dmitry Vyukov's ring). Every slot carries a sequence
+// number, so producers and consumers only contend on one atomic each and never take a lock.
+template <typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_Mask = size - 1;
+        m_Slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; i++) m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool TryPush(const T& value) {
+        size_t pos = m_Tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_Slots[pos & m_Mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = m_Tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T& value) {
+        size_t pos = m_Head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_Slots[pos & m_Mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = slot.value;
+                    slot.sequence.store(pos + m_Mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else {
+                pos = m_Head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Slot[]> m_Slots;
+    size_t m_Mask = 0;
+    alignas(64) std::atomic<size_t> m_Head{ 0 };
+    alignas(64) std::atomic<size_t> m_Tail{ 0 };
+};
+
+// Fixed pool of worker threads, one job deque each. Jobs submitted from outside are spread
+// round-robin; jobs submitted from a worker stay on its own deque. Workers take from the front of
+// their own deque (so submission order is roughly kept) and steal from the back of the others
+// when they run dry.
+class JobSystem {
+public:
+    // threadCount 0 = one worker per core, leaving one core for the main thread.
+    explicit JobSystem(int threadCount = 0) {
+        if (threadCount <= 0) threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+        for (int i = 0; i < threadCount; i++) m_Workers.emplace_back(new Worker());
+        for (int i = 0; i < threadCount; i++) m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Quit.store(true, std::memory_order_release);
+        }
+        m_WakeUp.notify_all();
+        for (std::thread& t : m_Threads) t.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    int ThreadCount() const { return (int)m_Workers.size(); }
+    int PendingJobs() const { return m_Pending.load(std::memory_order_acquire); }
+
+    void Submit(std::function<void()> job) {
+        int target = (t_WorkerIndex >= 0 && t_Owner == this) ? t_WorkerIndex
+                   : (int)(m_NextWorker.fetch_add(1, std::memory_order_relaxed) % m_Workers.size());
+        {
+            std::lock_guard<std::mutex> lock(m_Workers[target]->mutex);
+            m_Workers[target]->jobs.push_back(std::move(job));
+        }
+        m_Pending.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex); // Pairs with the predicate check in WorkerLoop
+            m_Queued.fetch_add(1, std::memory_order_release);
+        }
+        m_WakeUp.notify_one();
+    }
+
+    // Runs fn(0) .. fn(count - 1) on the workers and the calling thread and returns once all have
+    // finished. The caller keeps claiming indices itself, so this finishes even when every worker is
+    // busy with long jobs, and it never waits on unrelated work the way WaitIdle() does.
+    void ParallelFor(int count, const std::function<void(int)>& fn) {
+        struct Batch {
+            std::atomic<int> next{ 0 };
+            std::atomic<int> done{ 0 };
+        };
+        std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+        const std::function<void(int)>* body = &fn; // Only touched while indices are left, i.e. before we return
+        auto run = [batch, body, count]() {
+            for (int i = batch->next.fetch_add(1, std::memory_order_relaxed); i < count; i = batch->next.fetch_add(1, std::memory_order_relaxed)) {
+                (*body)(i);
+                batch->done.fetch_add(1, std::memory_order_release);
+            }
+        };
+        int helpers = std::min(ThreadCount(), count - 1);
+        for (int h = 0; h < helpers; h++) Submit(run);
+        run();
+        while (batch->done.load(std::memory_order_acquire) < count) std::this_thread::yield();
+    }
+
+    // Blocks until every submitted job has finished. For tools and benchmarks, not the frame loop.
+    void WaitIdle() {
+        while (m_Pending.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    bool TakeJob(int self, std::function<void()>& job) {
+        {
+            Worker& own = *m_Workers[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) { job = std::move(own.jobs.front()); own.jobs.pop_front(); m_Queued.fetch_sub(1, std::memory_order_relaxed); return true; }
+        }
+        for (size_t k = 1; k < m_Workers.size(); k++) {
+            Worker& victim = *m_Workers[(self + k) % m_Workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) { job = std::move(victim.jobs.back()); victim.jobs.pop_back(); m_Queued.fetch_sub(1, std::memory_order_relaxed); return true; }
+        }
+        return false;
+    }
+
+    void WorkerLoop(int self) {
+        t_WorkerIndex = self;
+        t_Owner = this;
+        std::function<void()> job;
+        for (;;) {
+            if (m_Quit.load(std::memory_order_acquire)) return;
+            if (TakeJob(self, job)) {
+                job();
+                job = nullptr;
+                m_Pending.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_WakeUp.wait(lock, [this] { return m_Quit.load(std::memory_order_acquire) || m_Queued.load(std::memory_order_acquire) > 0; });
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+    std::vector<std::thread> m_Threads;
+    std::atomic<int> m_Pending{ 0 };   // Submitted and not finished
+    std::atomic<int> m_Queued{ 0 };    // Submitted and not picked up yet
+    std::atomic<unsigned int> m_NextWorker{ 0 };
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeUp;
+    std::atomic<bool> m_Quit{ false };  // Queued jobs that never started are dropped
+
+    static thread_local int t_WorkerIndex;
+    static thread_local JobSystem* t_Owner;
+};
+
+inline thread_local int JobSystem::t_WorkerIndex = -1;
+inline thread_local JobSystem* JobSystem::t_Owner = nullptr;
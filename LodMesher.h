@@ -0,0 +1,143 @@
+#pragma once
+#include "ChunkMesher.h"
+#include <algorithm>
+
+// Distance rings around the camera. Ring 0 is drawn from real chunks; ring k > 0 is drawn from
+// heightfield tiles sampled every 2^k blocks straight from the terrain, so it needs no chunk data.
+// Ring widths are at least a chunk, which keeps the level of neighbouring tiles within one step.
+const int LOD_LEVELS = 4;
+const int kLodRingRadius[LOD_LEVELS] = { 32, 64, 128, 256 };    // Chebyshev distance in blocks
+
+// Ring of the chunk footprint nearest to the camera column, or -1 when it is beyond the last ring.
+// Level 0 covers exactly the chunks the renderer used to draw at range 32.
+inline int LodLevelForChunk(ChunkCoord coord, int camBlockX, int camBlockZ) {
+    int d = ChunkDistance(coord, camBlockX, camBlockZ);
+    for (int level = 0; level < LOD_LEVELS; level++) {
+        if (d <= kLodRingRadius[level]) return level;
+    }
+    return -1;
+}
+
+// Top block of a column with the given terrain height, WORLD_MIN_Y - 1 when it is empty. Same
+// rounding and clamping as GenerateChunk().
+inline int LodTopY(float height) {
+    int top = std::min((int)(height - 1.0f), WORLD_MAX_Y);
+    return std::max(top, WORLD_MIN_Y - 1);
+}
+
+// Top blocks of the cells a tile at step `step` would place against one edge of the tile at
+// (originX, originZ): the row just outside face kVoxelFaces[f], f in 0..3. Cells are sampled at
+// their centre column, origin + i * step + step / 2, which for step 1 is the block itself.
+inline void SampleLodEdge(const TerrainConfig& terrain, int originX, int originZ, int f, int step, int* outTop) {
+    int count = CHUNK_SIZE / step;
+    float heights[CHUNK_SIZE];
+    float along = (float)(step / 2);
+    float across = (kVoxelFaces[f].dir > 0) ? (float)(CHUNK_SIZE + step / 2) : (float)(-step + step / 2);
+    if (kVoxelFaces[f].axis == 0) GetTerrainHeights(terrain, originX + across, originZ + along, 1, count, heights, (float)step);
+    else GetTerrainHeights(terrain, originX + along, originZ + across, count, 1, heights, (float)step);
+    for (int i = 0; i < count; i++) outTop[i] = LodTopY(heights[i]);
+}
+
+// Meshes one chunk footprint as a blocky heightfield with (16 >> level)^2 cells of 2^level blocks.
+// Each cell is a column up to the terrain height at its centre: a top face plus walls down to
+// whatever is next to it. Inside the tile that is the neighbouring cell. On the tile border the
+// neighbour may be drawn at this level, one finer or one coarser, so the wall goes down to the
+// lowest of those three surfaces. Whichever side is higher then always closes the gap, and tiles
+// of different levels meet without cracks.
+inline void MeshLodTile(const TerrainConfig& terrain, ChunkCoord coord, int level, ChunkMesh& out) {
+    const int step = 1 << level;
+    const int n = CHUNK_SIZE / step;
+    const int originX = coord.x * CHUNK_SIZE, originZ = coord.z * CHUNK_SIZE;
+    out.coord = coord;
+    out.lodLevel = level;
+    out.vertices.clear();
+    out.quadCount = 0;
+    out.cull = FaceCullStats();
+
+    float heights[CHUNK_SIZE * CHUNK_SIZE];
+    int top[CHUNK_SIZE * CHUNK_SIZE];
+    GetTerrainHeights(terrain, (float)(originX + step / 2), (float)(originZ + step / 2), n, n, heights, (float)step);
+    for (int i = 0; i < n * n; i++) top[i] = LodTopY(heights[i]);
+
+    // edgeBottom[f][k]: lowest neighbouring surface next to border cell k along face f.
+    int edgeBottom[4][CHUNK_SIZE];
+    int samples[CHUNK_SIZE];
+    for (int f = 0; f < 4; f++) {
+        for (int k = 0; k < n; k++) edgeBottom[f][k] = WORLD_MAX_Y;
+        for (int neighbourLevel = std::max(level - 1, 0); neighbourLevel <= std::min(level + 1, LOD_LEVELS - 1); neighbourLevel++) {
+            int neighbourStep = 1 << neighbourLevel;
+            SampleLodEdge(terrain, originX, originZ, f, neighbourStep, samples);
+            for (int k = 0; k < n; k++) {
+                int first = k * step / neighbourStep;
+                int last = std::max(first, ((k + 1) * step - 1) / neighbourStep);
+                for (int s = first; s <= last; s++) edgeBottom[f][k] = std::min(edgeBottom[f][k], samples[s]);
+            }
+        }
+    }
+
+    // Top faces, merged greedily over cells with the same height.
+    const VoxelFace& up = kVoxelFaces[4];
+    bool done[CHUNK_SIZE * CHUNK_SIZE] = {};
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; ) {
+            int t = top[j * n + i];
+            if (done[j * n + i] || t < WORLD_MIN_Y) { i++; continue; }
+            int w = 1;
+            while (i + w < n && !done[j * n + i + w] && top[j * n + i + w] == t) w++;
+            int h = 1;
+            for (; j + h < n; h++) {
+                bool rowMatches = true;
+                for (int k = 0; k < w; k++) {
+                    if (done[(j + h) * n + i + k] || top[(j + h) * n + i + k] != t) { rowMatches = false; break; }
+                }
+                if (!rowMatches) break;
+            }
+            for (int dz = 0; dz < h; dz++)
+                for (int dx = 0; dx < w; dx++) done[(j + dz) * n + i + dx] = true;
+
+            float lo[3] = { originX + i * step - 0.5f, t + 0.5f, originZ + j * step - 0.5f };
+            float hi[3] = { lo[0] + w * step, t + 0.5f, lo[2] + h * step };
+            EmitFace(up, lo, hi, SurfaceBlockAt(t), out);
+            i += w;
+        }
+    }
+
+    // Side walls, merged along each row of cells when the span and material repeat.
+    for (int f = 0; f < 4; f++) {
+        const VoxelFace& face = kVoxelFaces[f];
+        int axis = face.axis;                   // 0 = X, 2 = Z
+        int alongAxis = (axis == 0) ? 2 : 0;
+        for (int line = 0; line < n; line++) {  // Cell index along `axis`
+            int runStart = 0, runBottom = 0, runTop = WORLD_MIN_Y - 1;
+            for (int k = 0; k <= n; k++) {      // Cell index along the wall
+                int wallTop = WORLD_MIN_Y - 1, wallBottom = 0;
+                if (k < n) {
+                    int i = (axis == 0) ? line : k;
+                    int j = (axis == 0) ? k : line;
+                    wallTop = top[j * n + i];
+                    int ni = i + ((axis == 0) ? face.dir : 0);
+                    int nj = j + ((axis == 2) ? face.dir : 0);
+                    if (ni >= 0 && ni < n && nj >= 0 && nj < n) wallBottom = top[nj * n + ni];
+                    else wallBottom = edgeBottom[f][k];
+                    if (wallBottom >= wallTop) wallTop = WORLD_MIN_Y - 1;
+                }
+                bool extends = (k < n) && wallTop >= WORLD_MIN_Y && wallTop == runTop && wallBottom == runBottom;
+                if (extends) continue;
+
+                if (runTop >= WORLD_MIN_Y) {
+                    float lo[3], hi[3];
+                    int origin[3] = { originX, 0, originZ };
+                    lo[axis] = hi[axis] = origin[axis] + line * step - 0.5f + ((face.dir > 0) ? step : 0);
+                    lo[alongAxis] = origin[alongAxis] + runStart * step - 0.5f;
+                    hi[alongAxis] = origin[alongAxis] + k * step - 0.5f;
+                    lo[1] = runBottom + 0.5f;
+                    hi[1] = runTop + 0.5f;
+                    EmitFace(face, lo, hi, SurfaceBlockAt(runTop), out);
+                }
+                runStart = k; runTop = wallTop; runBottom = wallBottom;
+            }
+        }
+    }
+
+    ComputeMeshBounds(out);
+}
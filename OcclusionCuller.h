@@ -0,0 +1,269 @@
+#pragma once
+#include "Frustum.h"
+#include "JobSystem.h"
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_SIMD 1
+#endif
+
+struct OcclusionStats {
+    int occluderTriangles = 0;  // Front-facing triangles that reached the depth buffer
+    int tested = 0;
+    int occluded = 0;
+};
+
+// Software hierarchical-Z occlusion. The nearest chunk meshes are rasterized into a small depth
+// buffer through the frame's CameraMatrices, the same transform VS() uses, the buffer is reduced
+// into a pyramid that keeps the farthest depth of every 2x2 block, and chunk boxes are then
+// tested against the coarsest level that still resolves them. Depth is stored as 1 / view z, so
+// 0 means nothing drawn and "nearer" is "larger".
+//
+// Occluders are sampled at pixel centres, which is not conservative along their silhouettes; the
+// box test widens every box by a texel to make up for it.
+class OcclusionCuller {
+public:
+    static const int WIDTH = 256;
+    static const int HEIGHT = 128;
+    static const int BAND_HEIGHT = 16;      // Rows per raster job
+    static const int MAX_LEVELS = 9;        // 256x128 down to 1x1
+
+    OcclusionStats Stats;
+
+    OcclusionCuller() {
+        int w = WIDTH, h = HEIGHT;
+        for (m_LevelCount = 0; m_LevelCount < MAX_LEVELS; m_LevelCount++) {
+            m_LevelWidth[m_LevelCount] = w;
+            m_LevelHeight[m_LevelCount] = h;
+            m_Levels[m_LevelCount].assign((size_t)w * h, 0.0f);
+            if (w == 1 && h == 1) { m_LevelCount++; break; }
+            w = std::max(w / 2, 1); h = std::max(h / 2, 1);
+        }
+    }
+
+    void BeginFrame(const CameraMatrices& camera) {
+        m_Camera = camera;
+        m_Triangles.clear();
+        Stats = OcclusionStats();
+    }
+
+    // Queues a triangle list for the next Rasterize(): vertex i is at xyz + i * stride (in floats).
+    // Triangles are near-clipped, projected and back-face culled here, with D3D's clockwise-is-front
+    // rule.
+    void AddOccluder(const float* xyz, size_t vertexCount, size_t stride = 3) {
+        for (size_t v = 0; v + 3 <= vertexCount; v += 3) {
+            Vec4 clip[3];
+            int behind = 0;
+            for (int k = 0; k < 3; k++) {
+                const float* p = xyz + (v + k) * stride;
+                clip[k] = m_Camera.ToClip(p[0], p[1], p[2]);
+                if (clip[k].w < m_Camera.nearZ) behind++;
+            }
+            if (behind == 3) continue;
+            if (behind == 0) { AddClipTriangle(clip[0], clip[1], clip[2]); continue; }
+
+            // Clip against the near plane (w = view z); one triangle in, at most a quad out.
+            Vec4 poly[4];
+            int count = 0;
+            const float nearZ = m_Camera.nearZ;
+            for (int k = 0; k < 3; k++) {
+                const Vec4& a = clip[k];
+                const Vec4& b = clip[(k + 1) % 3];
+                bool aIn = a.w >= nearZ, bIn = b.w >= nearZ;
+                if (aIn) poly[count++] = a;
+                if (aIn != bIn) {
+                    float t = (nearZ - a.w) / (b.w - a.w);
+                    poly[count] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, nearZ };
+                    count++;
+                }
+            }
+            for (int k = 1; k + 1 < count; k++) AddClipTriangle(poly[0], poly[k], poly[k + 1]);
+        }
+    }
+
+    size_t QueuedTriangles() const { return m_Triangles.size(); }
+
+    // Clears the depth buffer, draws every queued occluder and rebuilds the pyramid. Rows are split
+    // into bands of BAND_HEIGHT that rasterize independently, on `jobs` when one is given.
+    void Rasterize(JobSystem* jobs = nullptr) {
+        std::vector<float>& depth = m_Levels[0];
+        std::fill(depth.begin(), depth.end(), 0.0f);
+        const int bands = HEIGHT / BAND_HEIGHT;
+        if (jobs) jobs->ParallelFor(bands, [this](int band) { RasterizeBand(band * BAND_HEIGHT, (band + 1) * BAND_HEIGHT); });
+        else for (int band = 0; band < bands; band++) RasterizeBand(band * BAND_HEIGHT, (band + 1) * BAND_HEIGHT);
+        Stats.occluderTriangles = (int)m_Triangles.size();
+        BuildPyramid();
+    }
+
+    // False when the box lies entirely behind what was rasterized. Boxes that reach the near plane
+    // or leave the screen are always visible; the frustum test handles the rest of that.
+    bool IsBoxVisible(const float boxMin[3], const float boxMax[3]) const {
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 0.0f;
+        for (int corner = 0; corner < 8; corner++) {
+            float p[3] = { (corner & 1) ? boxMax[0] : boxMin[0], (corner & 2) ? boxMax[1] : boxMin[1], (corner & 4) ? boxMax[2] : boxMin[2] };
+            Vec4 v = m_Camera.ToClip(p[0], p[1], p[2]);
+            if (v.w < m_Camera.nearZ) return true;
+            float invZ = 1.0f / v.w;
+            float sx = WIDTH * 0.5f * (1.0f + v.x * invZ);
+            float sy = HEIGHT * 0.5f * (1.0f - v.y * invZ);
+            minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+            nearest = std::max(nearest, invZ);
+        }
+        if (maxX < 0.0f || maxY < 0.0f || minX >= WIDTH || minY >= HEIGHT) return true;
+
+        int x0 = std::max((int)floor(minX) - 1, 0), x1 = std::min((int)floor(maxX) + 1, WIDTH - 1);
+        int y0 = std::max((int)floor(minY) - 1, 0), y1 = std::min((int)floor(maxY) + 1, HEIGHT - 1);
+        int size = std::max(x1 - x0, y1 - y0) + 1;
+        int level = 0;
+        while (level + 1 < m_LevelCount && (size >> level) > 2) level++;
+
+        const std::vector<float>& texels = m_Levels[level];
+        int w = m_LevelWidth[level];
+        float farthest = 1e30f;
+        for (int y = y0 >> level; y <= (y1 >> level); y++)
+            for (int x = x0 >> level; x <= (x1 >> level); x++) farthest = std::min(farthest, texels[(size_t)y * w + x]);
+        return nearest >= farthest;
+    }
+
+    // Clears visible[i] for every box that is still marked visible but occluded.
+    void CullOccluded(const AabbBatch& boxes, uint8_t* visible) {
+        for (size_t i = 0; i < boxes.Count(); i++) {
+            if (!visible[i]) continue;
+            const float boxMin[3] = { boxes.minX[i], boxes.minY[i], boxes.minZ[i] };
+            const float boxMax[3] = { boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i] };
+            Stats.tested++;
+            if (!IsBoxVisible(boxMin, boxMax)) { visible[i] = 0; Stats.occluded++; }
+        }
+    }
+
+    const float* DepthBuffer() const { return m_Levels[0].data(); }   // WIDTH x HEIGHT, 1 / view z
+
+private:
+    struct ScreenTriangle {
+        float x[3], y[3], invZ[3];
+        int minY, maxY;
+    };
+
+    void AddClipTriangle(const Vec4& a, const Vec4& b, const Vec4& c) {
+        ScreenTriangle tri;
+        const Vec4* v[3] = { &a, &b, &c };
+        for (int k = 0; k < 3; k++) {
+            float invZ = 1.0f / v[k]->w;
+            tri.x[k] = WIDTH * 0.5f * (1.0f + v[k]->x * invZ);
+            tri.y[k] = HEIGHT * 0.5f * (1.0f - v[k]->y * invZ);
+            tri.invZ[k] = invZ;
+        }
+        float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+        if (area <= 0.0f) return; // Back-facing or degenerate; the GPU would not draw it either
+        float minY = std::min(tri.y[0], std::min(tri.y[1], tri.y[2]));
+        float maxY = std::max(tri.y[0], std::max(tri.y[1], tri.y[2]));
+        float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+        float maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+        if (maxY < 0.0f || minY >= HEIGHT || maxX < 0.0f || minX >= WIDTH) return;
+        tri.minY = std::max((int)floor(minY), 0);
+        tri.maxY = std::min((int)floor(maxY), HEIGHT - 1);
+        m_Triangles.push_back(tri);
+    }
+
+    // Pixel centres inside all three edges take max(depth, plane depth). Every lane outside the
+    // triangle contributes 0, which max() ignores, so there is no blend.
+    void RasterizeBand(int bandY0, int bandY1) {
+        float* depth = m_Levels[0].data();
+        for (const ScreenTriangle& tri : m_Triangles) {
+            if (tri.maxY < bandY0 || tri.minY >= bandY1) continue;
+            int y0 = std::max(tri.minY, bandY0), y1 = std::min(tri.maxY, bandY1 - 1);
+            float minX = std::min(tri.x[0], std::min(tri.x[1], tri.x[2]));
+            float maxX = std::max(tri.x[0], std::max(tri.x[1], tri.x[2]));
+            int x0 = std::max((int)floor(minX), 0) & ~3;
+            int x1 = std::min((int)floor(maxX), WIDTH - 1);
+
+            // Edge k runs from vertex k to k + 1: E(px, py) = ea * px + eb * py + ec >= 0 inside.
+            float ea[3], eb[3], ec[3];
+            for (int k = 0; k < 3; k++) {
+                int n = (k + 1) % 3;
+                ea[k] = -(tri.y[n] - tri.y[k]);
+                eb[k] = tri.x[n] - tri.x[k];
+                ec[k] = -eb[k] * tri.y[k] - ea[k] * tri.x[k];
+            }
+            float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+            float dzdx = ((tri.invZ[1] - tri.invZ[0]) * (tri.y[2] - tri.y[0]) - (tri.invZ[2] - tri.invZ[0]) * (tri.y[1] - tri.y[0])) / area;
+            float dzdy = ((tri.invZ[2] - tri.invZ[0]) * (tri.x[1] - tri.x[0]) - (tri.invZ[1] - tri.invZ[0]) * (tri.x[2] - tri.x[0])) / area;
+            float z0 = tri.invZ[0] - dzdx * tri.x[0] - dzdy * tri.y[0];
+
+            for (int y = y0; y <= y1; y++) {
+                float py = y + 0.5f;
+                float* row = depth + (size_t)y * WIDTH;
+                int x = x0;
+#ifdef OCCLUSION_SIMD
+                const __m128 laneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+                __m128 e0Step = _mm_set1_ps(ea[0] * 4.0f), e1Step = _mm_set1_ps(ea[1] * 4.0f), e2Step = _mm_set1_ps(ea[2] * 4.0f);
+                __m128 zStep = _mm_set1_ps(dzdx * 4.0f);
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneX);
+                __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[0]), px), _mm_set1_ps(eb[0] * py + ec[0]));
+                __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[1]), px), _mm_set1_ps(eb[1] * py + ec[1]));
+                __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[2]), px), _mm_set1_ps(eb[2] * py + ec[2]));
+                __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(dzdx), px), _mm_set1_ps(dzdy * py + z0));
+                for (; x <= x1; x += 4) {
+                    __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, _mm_setzero_ps()), _mm_and_ps(_mm_cmpge_ps(e1, _mm_setzero_ps()), _mm_cmpge_ps(e2, _mm_setzero_ps())));
+                    _mm_storeu_ps(row + x, _mm_max_ps(_mm_loadu_ps(row + x), _mm_and_ps(inside, z)));
+                    e0 = _mm_add_ps(e0, e0Step); e1 = _mm_add_ps(e1, e1Step); e2 = _mm_add_ps(e2, e2Step);
+                    z = _mm_add_ps(z, zStep);
+                }
+#else
+                for (; x <= x1; x++) {
+                    float px = x + 0.5f;
+                    if (ea[0] * px + eb[0] * py + ec[0] < 0.0f) continue;
+                    if (ea[1] * px + eb[1] * py + ec[1] < 0.0f) continue;
+                    if (ea[2] * px + eb[2] * py + ec[2] < 0.0f) continue;
+                    row[x] = std::max(row[x], dzdx * px + dzdy * py + z0);
+                }
+#endif
+            }
+        }
+    }
+
+    // Each texel keeps the farthest (smallest) of the four below it. Odd sizes fold the last
+    // row/column into the previous texel so nothing is dropped.
+    void BuildPyramid() {
+        for (int level = 1; level < m_LevelCount; level++) {
+            const std::vector<float>& src = m_Levels[level - 1];
+            std::vector<float>& dst = m_Levels[level];
+            int sw = m_LevelWidth[level - 1], sh = m_LevelHeight[level - 1];
+            int dw = m_LevelWidth[level], dh = m_LevelHeight[level];
+            for (int y = 0; y < dh; y++) {
+                const float* r0 = &src[(size_t)std::min(2 * y, sh - 1) * sw];
+                const float* r1 = &src[(size_t)std::min(2 * y + 1, sh - 1) * sw];
+                float* out = &dst[(size_t)y * dw];
+                int x = 0;
+#ifdef OCCLUSION_SIMD
+                if (sw == 2 * dw) {
+                    for (; x + 4 <= dw; x += 4) {
+                        __m128 a = _mm_min_ps(_mm_loadu_ps(r0 + 2 * x), _mm_loadu_ps(r1 + 2 * x));
+                        __m128 b = _mm_min_ps(_mm_loadu_ps(r0 + 2 * x + 4), _mm_loadu_ps(r1 + 2 * x + 4));
+                        __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+                        __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+                        _mm_storeu_ps(out + x, _mm_min_ps(even, odd));
+                    }
+                }
+#endif
+                for (; x < dw; x++) {
+                    int sx0 = std::min(2 * x, sw - 1), sx1 = std::min(2 * x + 1, sw - 1);
+                    out[x] = std::min(std::min(r0[sx0], r0[sx1]), std::min(r1[sx0], r1[sx1]));
+                }
+            }
+        }
+    }
+
+    CameraMatrices m_Camera = CameraMatrices::FromCamera(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+    std::vector<ScreenTriangle> m_Triangles;
+    std::vector<float> m_Levels[MAX_LEVELS];
+    int m_LevelWidth[MAX_LEVELS] = {};
+    int m_LevelHeight[MAX_LEVELS] = {};
+    int m_LevelCount = 0;
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Block storage for one chunk: a palette of the block types that occur in it plus one palette index
+// per block, packed into 64-bit words at the smallest width that fits the palette (0 to 8 bits, so
+// a chunk of one block type stores no indices at all). Indices never straddle a word, which keeps
+// Get() and Set() to one multiply, one shift and one mask.
+//
+// The palette tracks how many blocks use each entry. Set() reuses entries nobody uses any more,
+// widens the indices when the palette outgrows them and narrows them again once enough entries
+// are gone, keeping one spare slot so a type that comes and goes does not repack every time.
+class PalettedBlocks {
+public:
+    explicit PalettedBlocks(int count, uint8_t fill = 0) : m_Count(count) { Reset(fill); }
+
+    int Count() const { return m_Count; }
+    int Bits() const { return m_Bits; }
+    int PaletteSize() const { return m_Live; }   // Entries in use
+
+    uint8_t Get(int index) const { return m_Palette[IndexAt(index)]; }
+
+    void Set(int index, uint8_t block) {
+        int old = IndexAt(index);
+        if (m_Palette[old] == block) return;
+        int entry = FindEntry(block);
+        if (entry < 0) entry = AddEntry(block);
+        WriteIndex(index, entry);
+        m_Uses[entry]++;
+        if (--m_Uses[old] == 0) {
+            m_Live--;
+            int needed = BitsFor(m_Live);
+            if (needed < m_Bits && (m_Live <= 1 || m_Live < (1 << needed))) Repack(needed);
+        }
+    }
+
+    // Every block set to `fill`.
+    void Reset(uint8_t fill) {
+        m_Palette.assign(1, fill);
+        m_Uses.assign(1, (uint32_t)m_Count);
+        m_Live = 1;
+        SetWidth(0);
+        m_Words.assign(1, 0);
+        m_Words.shrink_to_fit();
+    }
+
+    // Replaces the contents with Count() raw block ids: one pass to count the types (four
+    // interleaved histograms, so repeated ids do not serialize on one counter), one to pack each
+    // word in a register.
+    void Assign(const uint8_t* blocks) {
+        uint32_t counts[4][256] = {};
+        int i = 0;
+        for (; i + 4 <= m_Count; i += 4) {
+            counts[0][blocks[i]]++; counts[1][blocks[i + 1]]++; counts[2][blocks[i + 2]]++; counts[3][blocks[i + 3]]++;
+        }
+        for (; i < m_Count; i++) counts[0][blocks[i]]++;
+
+        uint8_t remap[256];
+        m_Palette.clear();
+        m_Uses.clear();
+        for (int block = 0; block < 256; block++) {
+            uint32_t uses = counts[0][block] + counts[1][block] + counts[2][block] + counts[3][block];
+            if (uses == 0) continue;
+            remap[block] = (uint8_t)m_Palette.size();
+            m_Palette.push_back((uint8_t)block);
+            m_Uses.push_back(uses);
+        }
+        m_Live = (int)m_Palette.size();
+        SetWidth(BitsFor(m_Live));
+        m_Words.assign(WordCount(), 0);
+        m_Words.shrink_to_fit();
+        if (m_Bits == 0) return;
+
+        i = 0;
+        for (uint64_t& out : m_Words) {
+            uint64_t word = 0;
+            for (int shift = 0; shift + m_Bits <= 64 && i < m_Count; shift += m_Bits, i++) word |= (uint64_t)remap[blocks[i]] << shift;
+            out = word;
+        }
+    }
+
+    // Writes all Count() block ids to out, a word at a time.
+    void Unpack(uint8_t* out) const {
+        if (m_Bits == 0) { memset(out, m_Palette[0], m_Count); return; }
+        // Locals, since out may alias any member as far as the compiler knows.
+        const uint8_t* palette = m_Palette.data();
+        const uint64_t* words = m_Words.data();
+        const int bits = m_Bits, perWord = m_PerWord, count = m_Count;
+        const uint64_t mask = m_Mask;
+        for (int w = 0, i = 0; i < count; w++) {
+            uint64_t word = words[w];
+            for (int slot = 0; slot < perWord && i < count; slot++, i++) {
+                out[i] = palette[word & mask];
+                word >>= bits;
+            }
+        }
+    }
+
+    // Heap and inline bytes held by this storage.
+    size_t MemoryBytes() const {
+        return sizeof(*this) + m_Words.capacity() * sizeof(uint64_t) + m_Palette.capacity() + m_Uses.capacity() * sizeof(uint32_t);
+    }
+
+private:
+    static int BitsFor(int entries) {
+        int bits = 0;
+        while ((1 << bits) < entries) bits++;
+        return bits;
+    }
+
+    // Word and slot of an index without dividing: for counts below 2^26, (i * ceil(2^32 / perWord)) >> 32
+    // is exactly i / perWord.
+    void SetWidth(int bits) {
+        m_Bits = bits;
+        m_PerWord = bits ? 64 / bits : m_Count;
+        m_WordMagic = bits ? (uint32_t)((((uint64_t)1 << 32) + m_PerWord - 1) / m_PerWord) : 0;
+        m_Mask = bits ? ((uint64_t)1 << bits) - 1 : 0;
+    }
+    size_t WordCount() const { return m_Bits ? (size_t)((m_Count + m_PerWord - 1) / m_PerWord) : 1; }
+
+    int IndexAt(int index) const {
+        uint32_t word = (uint32_t)(((uint64_t)(uint32_t)index * m_WordMagic) >> 32);
+        int shift = (index - (int)word * m_PerWord) * m_Bits;
+        return (int)((m_Words[word] >> shift) & m_Mask);
+    }
+
+    void WriteIndex(int index, int entry) {
+        uint32_t word = (uint32_t)(((uint64_t)(uint32_t)index * m_WordMagic) >> 32);
+        int shift = (index - (int)word * m_PerWord) * m_Bits;
+        m_Words[word] = (m_Words[word] & ~(m_Mask << shift)) | ((uint64_t)entry << shift);
+    }
+
+    int FindEntry(uint8_t block) const {
+        for (size_t e = 0; e < m_Palette.size(); e++)
+            if (m_Palette[e] == block && m_Uses[e] > 0) return (int)e;
+        return -1;
+    }
+
+    // New palette entry with no users yet, widening the indices if it does not fit.
+    int AddEntry(uint8_t block) {
+        m_Live++;
+        for (size_t e = 0; e < m_Palette.size(); e++) {
+            if (m_Uses[e] == 0) { m_Palette[e] = block; return (int)e; }
+        }
+        if (m_Palette.size() + 1 > ((size_t)1 << m_Bits)) Repack(BitsFor((int)m_Palette.size() + 1));
+        m_Palette.push_back(block);
+        m_Uses.push_back(0);
+        return (int)m_Palette.size() - 1;
+    }
+
+    // Rewrites every index at a new width. Unused entries are dropped from the palette on the way.
+    void Repack(int bits) {
+        std::vector<int> remap(m_Palette.size(), 0);
+        std::vector<uint8_t> palette;
+        std::vector<uint32_t> uses;
+        for (size_t e = 0; e < m_Palette.size(); e++) {
+            if (m_Uses[e] == 0) continue;
+            remap[e] = (int)palette.size();
+            palette.push_back(m_Palette[e]);
+            uses.push_back(m_Uses[e]);
+        }
+
+        std::vector<uint64_t> oldWords;
+        oldWords.swap(m_Words);
+        int oldBits = m_Bits, oldPerWord = m_PerWord;
+        uint64_t oldMask = m_Mask;
+
+        SetWidth(bits);
+        m_Words.assign(WordCount(), 0);
+        for (int i = 0; i < m_Count; i++) {
+            int entry = oldBits ? (int)((oldWords[i / oldPerWord] >> ((i % oldPerWord) * oldBits)) & oldMask) : 0;
+            WriteIndex(i, remap[entry]);
+        }
+        m_Palette.swap(palette);
+        m_Uses.swap(uses);
+    }
+
+    int m_Count;
+    int m_Bits = 0;
+    int m_PerWord = 0;
+    uint32_t m_WordMagic = 0;
+    uint64_t m_Mask = 0;
+    int m_Live = 0;
+    std::vector<uint8_t> m_Palette;     // Block id per entry
+    std::vector<uint32_t> m_Uses;       // Blocks referencing each entry, 0 = free slot
+    std::vector<uint64_t> m_Words;
+};
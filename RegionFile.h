@@ -0,0 +1,458 @@
+#pragma once
+#include "VoxelWorld.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Saved worlds are split into regions of 32x32 chunks, one file each:
+//
+//   header   "VXRG", version, 1024 slots of { offset, size }   (offset 0 = chunk not saved)
+//   records  { uint16 slot, uint16 reserved, uint32 size } + compressed chunk payload, appended
+//
+// A chunk that is saved again gets a new record at the end of the file and only its slot is
+// rewritten, so existing bytes never change under a reader. Once superseded records take up more
+// than half of a file it is compacted into a fresh copy. Files are read through a memory mapping
+// and chunks are decoded straight out of it.
+const int REGION_SIZE = 32;                                 // Chunks per region along X and Z
+const int REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+const uint32_t REGION_VERSION = 1;
+const size_t REGION_HEADER_BYTES = 8 + REGION_CHUNKS * 8;
+const size_t REGION_RECORD_BYTES = 8;
+
+struct RegionCoord {
+    int x, z;
+    bool operator==(const RegionCoord& o) const { return x == o.x && z == o.z; }
+};
+
+struct RegionCoordHash {
+    size_t operator()(const RegionCoord& c) const { return ChunkCoordHash()({ c.x, c.z }); }
+};
+
+inline RegionCoord RegionCoordOf(ChunkCoord chunk) { return { FloorDiv(chunk.x, REGION_SIZE), FloorDiv(chunk.z, REGION_SIZE) }; }
+inline int RegionSlotOf(ChunkCoord chunk) {
+    return (chunk.z - FloorDiv(chunk.z, REGION_SIZE) * REGION_SIZE) * REGION_SIZE + (chunk.x - FloorDiv(chunk.x, REGION_SIZE) * REGION_SIZE);
+}
+
+// Chunk payload: the palette, then runs of palette indices in column order (each column bottom to
+// top, runs may continue into the next column). Generated terrain is a handful of runs per column.
+inline void EncodeChunk(const Chunk& chunk, std::vector<uint8_t>& out) {
+    uint8_t raw[CHUNK_BLOCKS];
+    chunk.blocks.Unpack(raw);
+    int remap[256];
+    memset(remap, -1, sizeof(remap));
+    uint8_t palette[256];
+    int paletteSize = 0;
+    for (int i = 0; i < CHUNK_BLOCKS; i++) {
+        if (remap[raw[i]] < 0) { remap[raw[i]] = paletteSize; palette[paletteSize++] = raw[i]; }
+    }
+
+    out.clear();
+    out.push_back((uint8_t)(paletteSize - 1));
+    out.insert(out.end(), palette, palette + paletteSize);
+    int runEntry = -1;
+    uint32_t runLength = 0;
+    auto flush = [&]() {
+        if (runLength == 0) return;
+        out.push_back((uint8_t)runEntry);
+        for (uint32_t n = runLength; ; n >>= 7) {   // Varint
+            if (n < 0x80) { out.push_back((uint8_t)n); break; }
+            out.push_back((uint8_t)(0x80 | (n & 0x7F)));
+        }
+    };
+    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+            for (int ly = 0; ly < CHUNK_HEIGHT; ly++) {
+                int entry = remap[raw[Chunk::Index(lx, ly, lz)]];
+                if (entry == runEntry) { runLength++; continue; }
+                flush();
+                runEntry = entry;
+                runLength = 1;
+            }
+        }
+    }
+    flush();
+}
+
+// Returns false on a malformed payload instead of reading past it.
+inline bool DecodeChunk(const uint8_t* data, size_t size, ChunkCoord coord, Chunk& chunk) {
+    if (size < 2) return false;
+    int paletteSize = data[0] + 1;
+    if (size < (size_t)(1 + paletteSize)) return false;
+    const uint8_t* palette = data + 1;
+    const uint8_t* p = palette + paletteSize;
+    const uint8_t* end = data + size;
+
+    uint8_t raw[CHUNK_BLOCKS];
+    int column = 0, ly = 0;
+    while (p < end && column < CHUNK_SIZE * CHUNK_SIZE) {
+        int entry = *p++;
+        uint32_t runLength = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (p >= end || shift > 28) return false;
+            uint8_t byte = *p++;
+            runLength |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (entry >= paletteSize || runLength == 0) return false;
+        if (runLength > (uint32_t)((CHUNK_SIZE * CHUNK_SIZE - column) * CHUNK_HEIGHT - ly)) return false;
+        uint8_t block = palette[entry];
+        for (; runLength > 0; runLength--) {
+            raw[Chunk::Index(column & (CHUNK_SIZE - 1), ly, column / CHUNK_SIZE)] = block;
+            if (++ly == CHUNK_HEIGHT) { ly = 0; column++; }
+        }
+    }
+    if (column != CHUNK_SIZE * CHUNK_SIZE || p != end) return false;
+
+    chunk.coord = coord;
+    chunk.blocks.Assign(raw);
+    chunk.RecomputeTopY(raw);
+    chunk.modified = false;
+    return true;
+}
+
+// Read-only view of a whole file. Bytes past Size() are never touched.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path) {
+        Close();
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) { Close(); return false; }
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_Mapping) { Close(); return false; }
+        m_Data = (const uint8_t*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_Data) { Close(); return false; }
+        m_Size = (size_t)size.QuadPart;
+#else
+        m_Fd = open(path.c_str(), O_RDONLY);
+        if (m_Fd < 0) return false;
+        struct stat st;
+        if (fstat(m_Fd, &st) != 0 || st.st_size == 0) { Close(); return false; }
+        void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, m_Fd, 0);
+        if (data == MAP_FAILED) { Close(); return false; }
+        m_Data = (const uint8_t*)data;
+        m_Size = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (m_Data) UnmapViewOfFile(m_Data);
+        if (m_Mapping) CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+        m_Mapping = nullptr;
+        m_File = INVALID_HANDLE_VALUE;
+#else
+        if (m_Data) munmap((void*)m_Data, m_Size);
+        if (m_Fd >= 0) ::close(m_Fd);
+        m_Fd = -1;
+#endif
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+    const uint8_t* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+
+private:
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#else
+    int m_Fd = -1;
+#endif
+};
+
+// One open region file: its slot table in memory, a mapping for reads and a stdio handle for
+// appends. Not thread-safe by itself; RegionStore serializes access.
+class RegionFile {
+public:
+    struct Slot { uint32_t offset, size; };
+
+    ~RegionFile() { if (m_Writer) fclose(m_Writer); }
+
+    // Loads the slot table, creating an empty file when there is none.
+    bool Open(const std::string& path) {
+        m_Path = path;
+        for (Slot& slot : m_Slots) slot = { 0, 0 };
+        m_LiveBytes = 0;
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec) && !WriteEmpty(path)) return false;
+        if (!Remap()) return false;
+        const uint8_t* data = m_Map->Data();
+        if (m_Map->Size() < REGION_HEADER_BYTES || memcmp(data, "VXRG", 4) != 0) return false;
+        uint32_t version;
+        memcpy(&version, data + 4, 4);
+        if (version != REGION_VERSION) return false;
+        memcpy(m_Slots, data + 8, sizeof(m_Slots));
+        for (Slot& slot : m_Slots) {
+            if (slot.offset == 0) continue;
+            if ((uint64_t)slot.offset + slot.size > m_Map->Size() || slot.offset < REGION_HEADER_BYTES + REGION_RECORD_BYTES) slot = { 0, 0 };
+            else m_LiveBytes += slot.size + REGION_RECORD_BYTES;
+        }
+        return true;
+    }
+
+    bool Has(int slot) const { return m_Slots[slot].offset != 0; }
+    uint64_t FileBytes() const { return m_FileBytes; }
+    uint64_t LiveBytes() const { return m_LiveBytes; }
+
+    // Mapping and byte range holding a chunk's payload. The mapping stays valid while the caller
+    // holds it, even if the file is appended to or compacted meanwhile.
+    bool Locate(int slot, std::shared_ptr<const MappedFile>& map, const uint8_t*& data, size_t& size) {
+        const Slot& s = m_Slots[slot];
+        if (s.offset == 0) return false;
+        if ((uint64_t)s.offset + s.size > m_Map->Size() && !Remap()) return false;
+        map = m_Map;
+        data = m_Map->Data() + s.offset;
+        size = s.size;
+        return true;
+    }
+
+    bool Append(int slot, const std::vector<uint8_t>& payload) {
+        if (!m_Writer) m_Writer = fopen(m_Path.c_str(), "r+b");
+        if (!m_Writer) return false;
+        uint32_t offset = (uint32_t)(m_FileBytes + REGION_RECORD_BYTES);
+        uint8_t record[REGION_RECORD_BYTES] = {};
+        uint16_t slot16 = (uint16_t)slot;
+        uint32_t size = (uint32_t)payload.size();
+        memcpy(record, &slot16, 2);
+        memcpy(record + 4, &size, 4);
+        if (fseek(m_Writer, (long)m_FileBytes, SEEK_SET) != 0) return false;
+        if (fwrite(record, 1, sizeof(record), m_Writer) != sizeof(record)) return false;
+        if (!payload.empty() && fwrite(payload.data(), 1, payload.size(), m_Writer) != payload.size()) return false;
+        // The slot only points at the record once the record is complete.
+        fflush(m_Writer);
+        Slot updated = { offset, size };
+        if (fseek(m_Writer, (long)(8 + slot * sizeof(Slot)), SEEK_SET) != 0) return false;
+        if (fwrite(&updated, sizeof(Slot), 1, m_Writer) != 1) return false;
+        fflush(m_Writer);
+
+        if (m_Slots[slot].offset != 0) m_LiveBytes -= m_Slots[slot].size + REGION_RECORD_BYTES;
+        m_Slots[slot] = updated;
+        m_LiveBytes += size + REGION_RECORD_BYTES;
+        m_FileBytes += REGION_RECORD_BYTES + size;
+        return true;
+    }
+
+    bool NeedsCompaction() const {
+        uint64_t dead = m_FileBytes - REGION_HEADER_BYTES - m_LiveBytes;
+        return dead > 64 * 1024 && dead > m_LiveBytes;
+    }
+
+    // Copies the live records into a new file and swaps it in. If the swap fails (on Windows,
+    // while another mapping of the old file is still held) the old file is simply kept.
+    bool Compact() {
+        if (m_Map->Size() < m_FileBytes && !Remap()) return false;  // Records appended since the last read
+        std::string temp = m_Path + ".tmp";
+        FILE* out = fopen(temp.c_str(), "wb");
+        if (!out) return false;
+        Slot slots[REGION_CHUNKS] = {};
+        uint32_t version = REGION_VERSION;
+        bool ok = fwrite("VXRG", 1, 4, out) == 4 && fwrite(&version, 4, 1, out) == 1 && fwrite(slots, sizeof(slots), 1, out) == 1;
+        uint64_t offset = REGION_HEADER_BYTES;
+        for (int i = 0; i < REGION_CHUNKS && ok; i++) {
+            if (m_Slots[i].offset == 0) continue;
+            uint8_t record[REGION_RECORD_BYTES] = {};
+            uint16_t slot16 = (uint16_t)i;
+            memcpy(record, &slot16, 2);
+            memcpy(record + 4, &m_Slots[i].size, 4);
+            ok = fwrite(record, 1, sizeof(record), out) == sizeof(record)
+                && fwrite(m_Map->Data() + m_Slots[i].offset, 1, m_Slots[i].size, out) == m_Slots[i].size;
+            slots[i] = { (uint32_t)(offset + REGION_RECORD_BYTES), m_Slots[i].size };
+            offset += REGION_RECORD_BYTES + m_Slots[i].size;
+        }
+        ok = ok && fseek(out, 8, SEEK_SET) == 0 && fwrite(slots, sizeof(slots), 1, out) == 1;
+        ok = (fclose(out) == 0) && ok;
+
+        std::error_code ec;
+        if (ok) {
+            if (m_Writer) { fclose(m_Writer); m_Writer = nullptr; }
+            m_Map.reset();
+            std::filesystem::rename(temp, m_Path, ec);
+        }
+        if (!ok || ec) {
+            std::filesystem::remove(temp, ec);
+            if (!m_Map) Remap();
+            return false;
+        }
+        memcpy(m_Slots, slots, sizeof(slots));
+        return Remap();
+    }
+
+private:
+    static bool WriteEmpty(const std::string& path) {
+        FILE* out = fopen(path.c_str(), "wb");
+        if (!out) return false;
+        static const Slot empty[REGION_CHUNKS] = {};
+        uint32_t version = REGION_VERSION;
+        bool ok = fwrite("VXRG", 1, 4, out) == 4 && fwrite(&version, 4, 1, out) == 1 && fwrite(empty, sizeof(empty), 1, out) == 1;
+        return (fclose(out) == 0) && ok;
+    }
+
+    bool Remap() {
+        std::shared_ptr<MappedFile> map = std::make_shared<MappedFile>();
+        if (!map->Open(m_Path)) return false;
+        m_FileBytes = map->Size();
+        m_Map = map;
+        return true;
+    }
+
+    std::string m_Path;
+    Slot m_Slots[REGION_CHUNKS];
+    uint64_t m_LiveBytes = 0;       // Header excluded
+    uint64_t m_FileBytes = 0;
+    std::shared_ptr<const MappedFile> m_Map;
+    FILE* m_Writer = nullptr;
+};
+
+struct RegionStoreStats {
+    size_t chunksLoaded = 0;
+    size_t chunksSaved = 0;
+    size_t regionsOpened = 0;
+    size_t compactions = 0;
+    uint64_t bytesWritten = 0;
+};
+
+// Chunk persistence for a world directory. Regions are opened on first use and at most
+// MaxOpenRegions stay mapped (least recently used are closed), so neither startup time nor
+// resident memory grows with the size of the saved world. Safe to call from any thread; decoding
+// happens outside the lock.
+class RegionStore {
+public:
+    size_t MaxOpenRegions;
+
+    explicit RegionStore(const std::string& directory, size_t maxOpenRegions = 16)
+        : MaxOpenRegions(maxOpenRegions), m_Directory(directory) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+    }
+
+    // Fills chunk from disk. False when the chunk was never saved or its record is unreadable,
+    // in which case the caller generates it.
+    bool LoadChunk(ChunkCoord coord, Chunk& chunk) {
+        std::shared_ptr<const MappedFile> map;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            RegionFile* region = GetRegion(RegionCoordOf(coord), false);
+            if (!region || !region->Locate(RegionSlotOf(coord), map, data, size)) return false;
+        }
+        if (!DecodeChunk(data, size, coord, chunk)) return false;
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.chunksLoaded++;
+        return true;
+    }
+
+    bool SaveChunk(const Chunk& chunk) {
+        std::vector<uint8_t> payload;
+        EncodeChunk(chunk, payload);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        RegionFile* region = GetRegion(RegionCoordOf(chunk.coord), true);
+        if (!region || !region->Append(RegionSlotOf(chunk.coord), payload)) return false;
+        m_Stats.chunksSaved++;
+        m_Stats.bytesWritten += payload.size() + REGION_RECORD_BYTES;
+        if (region->NeedsCompaction() && region->Compact()) m_Stats.compactions++;
+        return true;
+    }
+
+    RegionStoreStats Stats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    size_t OpenRegions() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Open.size();
+    }
+
+    std::string RegionPath(RegionCoord coord) const {
+        return m_Directory + "/r." + std::to_string(coord.x) + "." + std::to_string(coord.z) + ".vxr";
+    }
+
+private:
+    struct OpenRegion {
+        std::unique_ptr<RegionFile> file;
+        std::list<RegionCoord>::iterator lru;
+    };
+
+    // Returns the open region, opening it (and creating the file if create is set) when needed.
+    RegionFile* GetRegion(RegionCoord coord, bool create) {
+        auto it = m_Open.find(coord);
+        if (it != m_Open.end()) {
+            m_Lru.splice(m_Lru.begin(), m_Lru, it->second.lru);
+            return it->second.file.get();
+        }
+        std::string path = RegionPath(coord);
+        std::error_code ec;
+        if (!create && !std::filesystem::exists(path, ec)) return nullptr;
+
+        std::unique_ptr<RegionFile> file(new RegionFile());
+        if (!file->Open(path)) return nullptr;
+        while (!m_Lru.empty() && m_Open.size() >= MaxOpenRegions) {
+            m_Open.erase(m_Lru.back());
+            m_Lru.pop_back();
+        }
+        m_Lru.push_front(coord);
+        RegionFile* result = file.get();
+        m_Open[coord] = { std::move(file), m_Lru.begin() };
+        m_Stats.regionsOpened++;
+        return result;
+    }
+
+    std::string m_Directory;
+    mutable std::mutex m_Mutex;
+    std::unordered_map<RegionCoord, OpenRegion, RegionCoordHash> m_Open;
+    std::list<RegionCoord> m_Lru;       // Most recently used first
+    RegionStoreStats m_Stats;
+};
+
+// The terrain seeds of a saved world, so it regenerates identically around the saved chunks.
+inline bool ReadWorldInfo(const std::string& directory, TerrainConfig& terrain) {
+    FILE* in = fopen((directory + "/level.dat").c_str(), "rb");
+    if (!in) return false;
+    float seeds[2];
+    bool ok = fread(seeds, sizeof(seeds), 1, in) == 1;
+    fclose(in);
+    if (ok) { terrain.seedX = seeds[0]; terrain.seedZ = seeds[1]; }
+    return ok;
+}
+
+inline bool WriteWorldInfo(const std::string& directory, const TerrainConfig& terrain) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    FILE* out = fopen((directory + "/level.dat").c_str(), "wb");
+    if (!out) return false;
+    float seeds[2] = { terrain.seedX, terrain.seedZ };
+    bool ok = fwrite(seeds, sizeof(seeds), 1, out) == 1;
+    return (fclose(out) == 0) && ok;
+}
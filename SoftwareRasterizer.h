@@ -0,0 +1,294 @@
+#pragma once
+#include "ChunkMesher.h"
+#include "CameraMath.h"
+#include "JobSystem.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_SIMD 1
+#endif
+
+struct RasterStats {
+    int trianglesIn = 0;        // Submitted, before clipping and culling
+    int trianglesDrawn = 0;     // Front-facing and on screen after the near clip
+    int binEntries = 0;         // Triangle references across all tiles
+};
+
+// CPU version of the voxel pipeline: VS() and PS() from shaderCode (the frame's CameraMatrices,
+// then the vertex colour passed through) and the fixed-function state they run with (near clip,
+// clockwise front faces, back-face culling, depth test, top-left fill rule, pixel-centre sampling
+// and perspective-correct colour), writing RGBA8 like the R8G8B8A8_UNORM frame buffer. Depth is
+// 1 / view z, which orders like D3D's z / w.
+//
+// Triangles are set up once as plane equations and binned into TILE_SIZE square tiles; tiles then
+// clear and rasterize independently, on a JobSystem when one is given. Every tile draws its
+// triangles in submission order, so the image does not depend on the thread count.
+class SoftwareRasterizer {
+public:
+    static const int TILE_SIZE = 64;
+
+    RasterStats Stats;
+
+    void Resize(int width, int height) {
+        width = std::max(width, 1); height = std::max(height, 1);
+        if (width == m_Width && height == m_Height) return;
+        m_Width = width; m_Height = height;
+        m_Stride = (width + 3) & ~3;   // Whole groups of four, so the last group of a row stays in bounds
+        m_Color.assign((size_t)m_Stride * height, 0);
+        m_Depth.assign((size_t)m_Stride * height, 0.0f);
+        m_TilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        m_TilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        m_Bins.assign((size_t)m_TilesX * m_TilesY, std::vector<uint32_t>());
+    }
+
+    int Width() const { return m_Width; }
+    int Height() const { return m_Height; }
+    int Stride() const { return m_Stride; }   // Pixels per row in Pixels() and Depth()
+
+    void BeginFrame(const CameraMatrices& camera, const float clearColor[4]) {
+        m_Camera = camera;
+        m_Clear = PackColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        m_Triangles.clear();
+        for (std::vector<uint32_t>& bin : m_Bins) bin.clear();
+        Stats = RasterStats();
+    }
+
+    // Queues a triangle list in world space for the next Render().
+    void AddMesh(const Vertex* vertices, size_t count) {
+        for (size_t v = 0; v + 3 <= count; v += 3) {
+            Stats.trianglesIn++;
+            ClipVertex clip[3];
+            int behind = 0;
+            for (int k = 0; k < 3; k++) {
+                const Vertex& in = vertices[v + k];
+                clip[k].p = m_Camera.ToClip(in.x, in.y, in.z);
+                clip[k].col[0] = in.r; clip[k].col[1] = in.g; clip[k].col[2] = in.b; clip[k].col[3] = in.a;
+                if (clip[k].p.w < m_Camera.nearZ) behind++;
+            }
+            if (behind == 3) continue;
+            if (behind == 0) { AddClipTriangle(clip[0], clip[1], clip[2]); continue; }
+
+            // Clip against the near plane (w = view z); colours are linear along the edge.
+            ClipVertex poly[4];
+            int polyCount = 0;
+            const float nearZ = m_Camera.nearZ;
+            for (int k = 0; k < 3; k++) {
+                const ClipVertex& a = clip[k];
+                const ClipVertex& b = clip[(k + 1) % 3];
+                bool aIn = a.p.w >= nearZ, bIn = b.p.w >= nearZ;
+                if (aIn) poly[polyCount++] = a;
+                if (aIn != bIn) {
+                    float t = (nearZ - a.p.w) / (b.p.w - a.p.w);
+                    ClipVertex& out = poly[polyCount++];
+                    out.p = { a.p.x + (b.p.x - a.p.x) * t, a.p.y + (b.p.y - a.p.y) * t, 0.0f, nearZ };
+                    for (int d = 0; d < 4; d++) out.col[d] = a.col[d] + (b.col[d] - a.col[d]) * t;
+                }
+            }
+            for (int k = 1; k + 1 < polyCount; k++) AddClipTriangle(poly[0], poly[k], poly[k + 1]);
+        }
+    }
+
+    // Clears the buffers and draws everything queued since BeginFrame(), one job per tile.
+    void Render(JobSystem* jobs = nullptr) {
+        int tiles = m_TilesX * m_TilesY;
+        if (jobs && tiles > 1) jobs->ParallelFor(tiles, [this](int tile) { RasterizeTile(tile); });
+        else for (int tile = 0; tile < tiles; tile++) RasterizeTile(tile);
+    }
+
+    const uint32_t* Pixels() const { return m_Color.data(); }   // RGBA8, red in the low byte
+    const float* Depth() const { return m_Depth.data(); }       // 1 / view z, 0 where nothing was drawn
+
+    // Binary PPM of the colour buffer, for looking at headless renders.
+    bool SaveImage(const char* path) const {
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        fprintf(f, "P6\n%d %d\n255\n", m_Width, m_Height);
+        std::vector<uint8_t> row((size_t)m_Width * 3);
+        bool ok = true;
+        for (int y = 0; y < m_Height && ok; y++) {
+            const uint32_t* src = &m_Color[(size_t)y * m_Stride];
+            for (int x = 0; x < m_Width; x++) {
+                row[x * 3 + 0] = (uint8_t)(src[x]);
+                row[x * 3 + 1] = (uint8_t)(src[x] >> 8);
+                row[x * 3 + 2] = (uint8_t)(src[x] >> 16);
+            }
+            ok = fwrite(row.data(), 1, row.size(), f) == row.size();
+        }
+        return fclose(f) == 0 && ok;
+    }
+
+    // UNORM conversion: clamp, scale and round to nearest even, as _mm_cvtps_epi32 does.
+    static uint32_t PackColor(float r, float g, float b, float a) {
+        auto unorm = [](float v) { return (uint32_t)lrintf(std::min(std::max(v, 0.0f), 1.0f) * 255.0f); };
+        return unorm(r) | (unorm(g) << 8) | (unorm(b) << 16) | (unorm(a) << 24);
+    }
+
+private:
+    struct ClipVertex {
+        Vec4 p;
+        float col[4];
+    };
+
+    // Everything a tile needs, as planes over screen space: A(px, py) = dx * px + dy * py + c.
+    struct Plane {
+        float dx, dy, c;
+    };
+    struct RasterTriangle {
+        Plane edge[3];          // >= 0 inside
+        bool topLeft[3];        // Pixels exactly on a top or left edge belong to this triangle
+        Plane invZ;
+        Plane col[4];           // Colour / view z; divided by invZ per pixel
+        int minX, minY, maxX, maxY;
+    };
+
+    void AddClipTriangle(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c) {
+        const ClipVertex* v[3] = { &a, &b, &c };
+        float x[3], y[3], invZ[3];
+        for (int k = 0; k < 3; k++) {
+            invZ[k] = 1.0f / v[k]->p.w;
+            x[k] = m_Width * 0.5f * (1.0f + v[k]->p.x * invZ[k]);
+            y[k] = m_Height * 0.5f * (1.0f - v[k]->p.y * invZ[k]);
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area <= 0.0f) return; // Back-facing or degenerate
+        float minX = std::min(x[0], std::min(x[1], x[2])), maxX = std::max(x[0], std::max(x[1], x[2]));
+        float minY = std::min(y[0], std::min(y[1], y[2])), maxY = std::max(y[0], std::max(y[1], y[2]));
+        // Pixel centres covered: those with x + 0.5 in [minX, maxX].
+        RasterTriangle tri;
+        tri.minX = std::max((int)ceil(minX - 0.5f), 0); tri.maxX = std::min((int)floor(maxX - 0.5f), m_Width - 1);
+        tri.minY = std::max((int)ceil(minY - 0.5f), 0); tri.maxY = std::min((int)floor(maxY - 0.5f), m_Height - 1);
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+        // Edge k runs from vertex k to k + 1. Inside is the side its gradient points to, so a left
+        // edge has dx > 0 and a top edge (horizontal, inside below it in y-down space) dx == 0, dy > 0.
+        for (int k = 0; k < 3; k++) {
+            int n = (k + 1) % 3;
+            Plane& e = tri.edge[k];
+            e.dx = -(y[n] - y[k]);
+            e.dy = x[n] - x[k];
+            e.c = -e.dy * y[k] - e.dx * x[k];
+            tri.topLeft[k] = e.dx > 0.0f || (e.dx == 0.0f && e.dy > 0.0f);
+        }
+        auto plane = [&](const float value[3]) {
+            Plane p;
+            p.dx = ((value[1] - value[0]) * (y[2] - y[0]) - (value[2] - value[0]) * (y[1] - y[0])) / area;
+            p.dy = ((value[2] - value[0]) * (x[1] - x[0]) - (value[1] - value[0]) * (x[2] - x[0])) / area;
+            p.c = value[0] - p.dx * x[0] - p.dy * y[0];
+            return p;
+        };
+        tri.invZ = plane(invZ);
+        for (int ch = 0; ch < 4; ch++) {
+            const float perZ[3] = { v[0]->col[ch] * invZ[0], v[1]->col[ch] * invZ[1], v[2]->col[ch] * invZ[2] };
+            tri.col[ch] = plane(perZ);
+        }
+
+        uint32_t index = (uint32_t)m_Triangles.size();
+        m_Triangles.push_back(tri);
+        Stats.trianglesDrawn++;
+        for (int ty = tri.minY / TILE_SIZE; ty <= tri.maxY / TILE_SIZE; ty++) {
+            for (int tx = tri.minX / TILE_SIZE; tx <= tri.maxX / TILE_SIZE; tx++) {
+                m_Bins[(size_t)ty * m_TilesX + tx].push_back(index);
+                Stats.binEntries++;
+            }
+        }
+    }
+
+    void RasterizeTile(int tile) {
+        int tx0 = (tile % m_TilesX) * TILE_SIZE, ty0 = (tile / m_TilesX) * TILE_SIZE;
+        int tx1 = std::min(tx0 + TILE_SIZE, m_Width) - 1, ty1 = std::min(ty0 + TILE_SIZE, m_Height) - 1;
+        for (int y = ty0; y <= ty1; y++) {
+            std::fill(&m_Color[(size_t)y * m_Stride + tx0], &m_Color[(size_t)y * m_Stride + tx1 + 1], m_Clear);
+            std::fill(&m_Depth[(size_t)y * m_Stride + tx0], &m_Depth[(size_t)y * m_Stride + tx1 + 1], 0.0f);
+        }
+        for (uint32_t index : m_Bins[tile]) {
+            const RasterTriangle& tri = m_Triangles[index];
+            int x0 = std::max(tri.minX, tx0), x1 = std::min(tri.maxX, tx1);
+            int y0 = std::max(tri.minY, ty0), y1 = std::min(tri.maxY, ty1);
+            for (int y = y0; y <= y1; y++) RasterizeSpan(tri, y, x0, x1);
+        }
+    }
+
+    // Every plane is evaluated directly at each pixel centre rather than stepped, so the SIMD and
+    // scalar paths produce the same bits. A pixel is written when it is inside all three edges and
+    // nearer than what is there (depth test LESS on z / w is GREATER on 1 / z).
+    void RasterizeSpan(const RasterTriangle& tri, int y, int x0, int x1) {
+        float py = y + 0.5f;
+        uint32_t* color = &m_Color[(size_t)y * m_Stride];
+        float* depth = &m_Depth[(size_t)y * m_Stride];
+        int x = x0;
+#ifdef SOFTWARE_RASTER_SIMD
+        const __m128 laneX = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f);
+        __m128 edgeDx[3], edgeRow[3], edgeOnLine[3];
+        for (int k = 0; k < 3; k++) {
+            edgeDx[k] = _mm_set1_ps(tri.edge[k].dx);
+            edgeRow[k] = _mm_set1_ps(tri.edge[k].dy * py + tri.edge[k].c);
+            edgeOnLine[k] = _mm_castsi128_ps(_mm_set1_epi32(tri.topLeft[k] ? -1 : 0));
+        }
+        __m128 zDx = _mm_set1_ps(tri.invZ.dx), zRow = _mm_set1_ps(tri.invZ.dy * py + tri.invZ.c);
+        __m128 colDx[4], colRow[4];
+        for (int ch = 0; ch < 4; ch++) {
+            colDx[ch] = _mm_set1_ps(tri.col[ch].dx);
+            colRow[ch] = _mm_set1_ps(tri.col[ch].dy * py + tri.col[ch].c);
+        }
+        __m128 lastX = _mm_set1_ps(x1 + 0.5f);
+
+        for (x = x0 & ~3; x <= x1; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneX);
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, _mm_set1_ps(x0 + 0.5f)), _mm_cmple_ps(px, lastX));
+            for (int k = 0; k < 3; k++) {
+                __m128 e = _mm_add_ps(_mm_mul_ps(edgeDx[k], px), edgeRow[k]);
+                __m128 in = _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), edgeOnLine[k]));
+                inside = _mm_and_ps(inside, in);
+            }
+            if (_mm_movemask_ps(inside) == 0) continue;
+            __m128 z = _mm_add_ps(_mm_mul_ps(zDx, px), zRow);
+            __m128 oldZ = _mm_loadu_ps(depth + x);
+            __m128 write = _mm_and_ps(inside, _mm_cmpgt_ps(z, oldZ));
+            if (_mm_movemask_ps(write) == 0) continue;
+            _mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, oldZ)));
+
+            __m128i rgba = _mm_setzero_si128();
+            for (int ch = 0; ch < 4; ch++) {
+                __m128 value = _mm_div_ps(_mm_add_ps(_mm_mul_ps(colDx[ch], px), colRow[ch]), z);
+                value = _mm_mul_ps(_mm_min_ps(_mm_max_ps(value, zero), one), scale);
+                rgba = _mm_or_si128(rgba, _mm_slli_epi32(_mm_cvtps_epi32(value), ch * 8));
+            }
+            __m128i mask = _mm_castps_si128(write);
+            __m128i old = _mm_loadu_si128((const __m128i*)(color + x));
+            _mm_storeu_si128((__m128i*)(color + x), _mm_or_si128(_mm_and_si128(mask, rgba), _mm_andnot_si128(mask, old)));
+        }
+#else
+        for (; x <= x1; x++) {
+            float px = x + 0.5f;
+            bool inside = true;
+            for (int k = 0; k < 3 && inside; k++) {
+                float e = tri.edge[k].dx * px + (tri.edge[k].dy * py + tri.edge[k].c);
+                inside = e > 0.0f || (e == 0.0f && tri.topLeft[k]);
+            }
+            if (!inside) continue;
+            float z = tri.invZ.dx * px + (tri.invZ.dy * py + tri.invZ.c);
+            if (!(z > depth[x])) continue;
+            depth[x] = z;
+            float value[4];
+            for (int ch = 0; ch < 4; ch++) value[ch] = (tri.col[ch].dx * px + (tri.col[ch].dy * py + tri.col[ch].c)) / z;
+            color[x] = PackColor(value[0], value[1], value[2], value[3]);
+        }
+#endif
+    }
+
+    CameraMatrices m_Camera = CameraMatrices::FromCamera(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+    uint32_t m_Clear = 0;
+    int m_Width = 0, m_Height = 0, m_Stride = 0;
+    int m_TilesX = 0, m_TilesY = 0;
+    std::vector<uint32_t> m_Color;
+    std::vector<float> m_Depth;
+    std::vector<RasterTriangle> m_Triangles;
+    std::vector<std::vector<uint32_t>> m_Bins;     // Triangle indices per tile, in submission order
+};
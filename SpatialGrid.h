@@ -0,0 +1,127 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+
+// Uniform grid over 2D points, rebuilt from scratch every frame. Build() is a counting sort: one
+// pass counts the points per cell, a prefix sum turns the counts into offsets, a second pass
+// scatters the points so each cell's points sit next to each other, and a row of cells is one
+// contiguous range. Positions are copied along with the indices, so a query reads memory linearly
+// and only looks at the cells its shape overlaps. Points outside the bounds are clamped into the
+// border cells, so they are still found, and NaN coordinates land in the first cell. All tests
+// compare squared distances. Queries before the first Build() find nothing.
+class SpatialGrid {
+public:
+    // cellSize around the diameter of the things stored works well: a circle query of that
+    // radius touches at most 3x3 cells.
+    void Build(const float* x, const float* y, size_t count, float minX, float minY, float maxX, float maxY, float cellSize) {
+        m_MinX = minX; m_MinY = minY;
+        m_InvCell = 1.0f / cellSize;
+        m_Columns = CellsAcross(maxX - minX);
+        m_Rows = CellsAcross(maxY - minY);
+
+        m_CellStart.assign((size_t)m_Columns * m_Rows + 1, 0);
+        m_CellOf.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t cell = (uint32_t)(CellY(y[i]) * m_Columns + CellX(x[i]));
+            m_CellOf[i] = cell;
+            m_CellStart[cell + 1]++;
+        }
+        for (size_t c = 1; c < m_CellStart.size(); c++) m_CellStart[c] += m_CellStart[c - 1];
+
+        m_Slots.resize(count);
+        m_Fill.assign(m_CellStart.begin(), m_CellStart.end() - 1);
+        for (size_t i = 0; i < count; i++) {
+            Slot& slot = m_Slots[m_Fill[m_CellOf[i]]++];
+            slot.x = x[i];
+            slot.y = y[i];
+            slot.index = (uint32_t)i;
+        }
+    }
+
+    size_t Count() const { return m_Slots.size(); }
+    int Columns() const { return m_Columns; }
+    int Rows() const { return m_Rows; }
+
+    // Calls fn(index) for every point strictly closer than radius to (cx, cy), the same test
+    // StepEnemies() uses for the player.
+    template <typename Fn>
+    void QueryCircle(float cx, float cy, float radius, Fn&& fn) const {
+        if (m_CellStart.empty()) return;
+        float r2 = radius * radius;
+        int x0 = CellX(cx - radius), x1 = CellX(cx + radius);
+        int y0 = CellY(cy - radius), y1 = CellY(cy + radius);
+        for (int row = y0; row <= y1; row++) {
+            uint32_t begin = m_CellStart[row * m_Columns + x0], end = m_CellStart[row * m_Columns + x1 + 1];
+            for (uint32_t k = begin; k < end; k++) {
+                float dx = m_Slots[k].x - cx, dy = m_Slots[k].y - cy;
+                if (dx * dx + dy * dy < r2) fn(m_Slots[k].index);
+            }
+        }
+    }
+
+    // Calls fn(index) for every point inside the box, edges included.
+    template <typename Fn>
+    void QueryAabb(float minX, float minY, float maxX, float maxY, Fn&& fn) const {
+        if (m_CellStart.empty()) return;
+        int x0 = CellX(minX), x1 = CellX(maxX);
+        int y0 = CellY(minY), y1 = CellY(maxY);
+        for (int row = y0; row <= y1; row++) {
+            uint32_t begin = m_CellStart[row * m_Columns + x0], end = m_CellStart[row * m_Columns + x1 + 1];
+            for (uint32_t k = begin; k < end; k++) {
+                const Slot& p = m_Slots[k];
+                if (p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY) fn(p.index);
+            }
+        }
+    }
+
+    // True as soon as any point is strictly closer than radius; the player's hit test.
+    bool AnyInCircle(float cx, float cy, float radius) const {
+        if (m_CellStart.empty()) return false;
+        float r2 = radius * radius;
+        int x0 = CellX(cx - radius), x1 = CellX(cx + radius);
+        int y0 = CellY(cy - radius), y1 = CellY(cy + radius);
+        for (int row = y0; row <= y1; row++) {
+            uint32_t begin = m_CellStart[row * m_Columns + x0], end = m_CellStart[row * m_Columns + x1 + 1];
+            for (uint32_t k = begin; k < end; k++) {
+                float dx = m_Slots[k].x - cx, dy = m_Slots[k].y - cy;
+                if (dx * dx + dy * dy < r2) return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static const int kMaxCellsAcross = 1 << 15;   // Keeps Columns * Rows within the offsets' range
+
+    // Cells along an axis of the given extent; a negative, NaN or huge extent is clamped, since
+    // converting those to int is undefined.
+    int CellsAcross(float extent) const {
+        float c = extent * m_InvCell;
+        return !(c >= 0.0f) ? 1 : (c >= (float)(kMaxCellsAcross - 1) ? kMaxCellsAcross : (int)c + 1);
+    }
+
+    // !(c >= 0) also sends NaN to the first cell, as the cast would be undefined for it.
+    int CellX(float x) const {
+        float c = (x - m_MinX) * m_InvCell;
+        return !(c >= 0.0f) ? 0 : (c >= (float)(m_Columns - 1) ? m_Columns - 1 : (int)c);
+    }
+    int CellY(float y) const {
+        float c = (y - m_MinY) * m_InvCell;
+        return !(c >= 0.0f) ? 0 : (c >= (float)(m_Rows - 1) ? m_Rows - 1 : (int)c);
+    }
+
+    float m_MinX = 0.0f, m_MinY = 0.0f, m_InvCell = 1.0f;
+    int m_Columns = 1, m_Rows = 1;
+    // A point in cell order: its position, copied so queries read memory linearly, and its input index.
+    struct Slot {
+        float x, y;
+        uint32_t index;
+    };
+
+    std::vector<uint32_t> m_CellStart;  // Columns * Rows + 1 offsets into m_Slots, row-major
+    std::vector<uint32_t> m_Fill;       // Build() scratch: next free slot per cell
+    std::vector<uint32_t> m_CellOf;     // Build() scratch: cell of each input point
+    std::vector<Slot> m_Slots;
+};
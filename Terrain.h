@@ -0,0 +1,291 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TERRAIN_SIMD 1
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+struct TerrainConfig {
+    float seedX, seedZ;
+};
+
+// The terrain is two layers of 2D gradient noise. The biome layer (wavelengths 256 and 128)
+// decides where mountains rise; it is smooth enough to be sampled on an 8-block lattice and
+// interpolated, and those lattice values are cached per 128-block region. The detail layer
+// (wavelengths 64 down to 8) is evaluated at every column.
+const int TERRAIN_BIOME_OCTAVES = 2;
+const int TERRAIN_DETAIL_OCTAVES = 4;
+const float TERRAIN_BIOME_FREQUENCY = 1.0f / 256.0f;
+const float TERRAIN_DETAIL_FREQUENCY = 1.0f / 64.0f;
+const int TERRAIN_LATTICE_STEP = 8;             // Blocks between cached biome samples
+const int TERRAIN_REGION_SHIFT = 4;             // 16 lattice cells per region side
+const int TERRAIN_REGION_CELLS = 1 << TERRAIN_REGION_SHIFT;
+const int TERRAIN_REGION_SAMPLES = TERRAIN_REGION_CELLS + 1;
+const uint32_t TERRAIN_HASH_X = 0x27D4EB2Du;
+const uint32_t TERRAIN_HASH_Z = 0x165667B1u;
+
+inline uint32_t TerrainMix(uint32_t h) {
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 16;
+    return h;
+}
+
+// Lattice seed of one octave (detail octaves first, then biome), derived from the two seeds a
+// world is saved with, so the same seeds always give the same world.
+inline uint32_t TerrainOctaveSeed(const TerrainConfig& terrain, int octave) {
+    uint32_t x, z;
+    memcpy(&x, &terrain.seedX, sizeof(x));
+    memcpy(&z, &terrain.seedZ, sizeof(z));
+    return TerrainMix(TerrainMix(x + 0x9E3779B9u * (uint32_t)(octave + 1)) ^ z);
+}
+
+inline float TerrainFade(float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); }
+
+// One of eight gradients of equal length, (+-1, +-0.5) or (+-0.5, +-1), dotted with (dx, dz).
+inline float TerrainGradDot(uint32_t h, float dx, float dz) {
+    float a = (h & 4) ? 0.5f : 1.0f, b = 1.5f - a;
+    float gx = (h & 1) ? -a : a, gz = (h & 2) ? -b : b;
+    return gx * dx + gz * dz;
+}
+
+// Gradient noise at (x, z) in lattice units, within about [-0.8, 0.8]. The corner hash is split
+// into a column part and a row part so the batched evaluator can hoist both out of its inner loop.
+inline float GradientNoise(uint32_t seed, float x, float z) {
+    float cx = floorf(x), cz = floorf(z);
+    float fx = x - cx, fz = z - cz;
+    uint32_t col = (uint32_t)(int)cx * TERRAIN_HASH_X;
+    uint32_t row0 = ((uint32_t)(int)cz * TERRAIN_HASH_Z) ^ seed;
+    uint32_t row1 = ((uint32_t)(int)cz * TERRAIN_HASH_Z + TERRAIN_HASH_Z) ^ seed;
+    float n00 = TerrainGradDot(TerrainMix(col + row0), fx, fz);
+    float n10 = TerrainGradDot(TerrainMix(col + TERRAIN_HASH_X + row0), fx - 1.0f, fz);
+    float n01 = TerrainGradDot(TerrainMix(col + row1), fx, fz - 1.0f);
+    float n11 = TerrainGradDot(TerrainMix(col + TERRAIN_HASH_X + row1), fx - 1.0f, fz - 1.0f);
+    float u = TerrainFade(fx), v = TerrainFade(fz);
+    float nx0 = n00 + u * (n10 - n00);
+    float nx1 = n01 + u * (n11 - n01);
+    return nx0 + v * (nx1 - nx0);
+}
+
+// Biome noise at a lattice point (kx, kz), i.e. at block (kx * 8, kz * 8).
+inline float TerrainBiomeSample(const TerrainConfig& terrain, int kx, int kz) {
+    float x = (float)(kx * TERRAIN_LATTICE_STEP), z = (float)(kz * TERRAIN_LATTICE_STEP);
+    float frequency = TERRAIN_BIOME_FREQUENCY, amplitude = 1.0f, sum = 0.0f;
+    for (int o = 0; o < TERRAIN_BIOME_OCTAVES; o++) {
+        sum += GradientNoise(TerrainOctaveSeed(terrain, TERRAIN_DETAIL_OCTAVES + o), x * frequency, z * frequency) * amplitude;
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+    return sum;
+}
+
+// Biome lattice values of recently used regions. Each thread has its own, so the builder's
+// workers never contend; neighbouring chunks land in the same region and hit.
+class TerrainBiomeCache {
+public:
+    size_t Hits = 0;
+    size_t Misses = 0;
+
+    // Lattice values of region (rx, rz): (TERRAIN_REGION_SAMPLES)^2 floats, row-major, covering
+    // lattice points rx * 16 .. rx * 16 + 16 so bilinear lookups never leave the region.
+    const float* Region(const TerrainConfig& terrain, int rx, int rz) {
+        for (Entry& e : m_Entries) {
+            if (e.valid && e.rx == rx && e.rz == rz && e.seedX == terrain.seedX && e.seedZ == terrain.seedZ) {
+                Hits++;
+                return e.values;
+            }
+        }
+        Misses++;
+        Entry& e = m_Entries[m_Next];
+        m_Next = (m_Next + 1) % REGIONS;
+        e.valid = true;
+        e.rx = rx; e.rz = rz;
+        e.seedX = terrain.seedX; e.seedZ = terrain.seedZ;
+        for (int j = 0; j < TERRAIN_REGION_SAMPLES; j++)
+            for (int i = 0; i < TERRAIN_REGION_SAMPLES; i++)
+                e.values[j * TERRAIN_REGION_SAMPLES + i] = TerrainBiomeSample(terrain, rx * TERRAIN_REGION_CELLS + i, rz * TERRAIN_REGION_CELLS + j);
+        return e.values;
+    }
+
+    static TerrainBiomeCache& ForThread() {
+        thread_local TerrainBiomeCache cache;
+        return cache;
+    }
+
+private:
+    static const int REGIONS = 8;
+    struct Entry {
+        bool valid = false;
+        int rx = 0, rz = 0;
+        float seedX = 0.0f, seedZ = 0.0f;
+        float values[TERRAIN_REGION_SAMPLES * TERRAIN_REGION_SAMPLES];
+    };
+    Entry m_Entries[REGIONS];
+    int m_Next = 0;
+};
+
+// Bilinear lookup of the biome lattice. (kx, kz) is the lattice cell, (tx, tz) the position in it.
+inline float TerrainBiomeLookup(const float* region, int kx, int kz, float tx, float tz) {
+    const float* p = region + (kz & (TERRAIN_REGION_CELLS - 1)) * TERRAIN_REGION_SAMPLES + (kx & (TERRAIN_REGION_CELLS - 1));
+    float b0 = p[0] + tx * (p[1] - p[0]);
+    float b1 = p[TERRAIN_REGION_SAMPLES] + tx * (p[TERRAIN_REGION_SAMPLES + 1] - p[TERRAIN_REGION_SAMPLES]);
+    return b0 + tz * (b1 - b0);
+}
+
+// Raw height from the two layers: gentle hills and lakes where the biome is low, mountains with
+// rougher detail where it is high. The top block of a column sits at floor(raw).
+inline float TerrainShape(float biome, float detail) {
+    float mountain = biome * 2.5f;
+    mountain = mountain < 0.0f ? 0.0f : (mountain > 1.0f ? 1.0f : mountain);
+    mountain = mountain * mountain;
+    return (detail * (3.0f + 6.0f * mountain) + mountain * 16.0f) - 0.5f;
+}
+
+// Surface height of the column at (worldX, worldZ). The top block of a column sits at GetTerrainHeight() - 1.
+inline float GetTerrainHeight(const TerrainConfig& terrain, float worldX, float worldZ) {
+    float gx = worldX * (1.0f / TERRAIN_LATTICE_STEP), gz = worldZ * (1.0f / TERRAIN_LATTICE_STEP);
+    float kx = floorf(gx), kz = floorf(gz);
+    const float* region = TerrainBiomeCache::ForThread().Region(terrain, (int)kx >> TERRAIN_REGION_SHIFT, (int)kz >> TERRAIN_REGION_SHIFT);
+    float biome = TerrainBiomeLookup(region, (int)kx, (int)kz, gx - kx, gz - kz);
+
+    float frequency = TERRAIN_DETAIL_FREQUENCY, amplitude = 1.0f, detail = 0.0f;
+    for (int o = 0; o < TERRAIN_DETAIL_OCTAVES; o++) {
+        detail += GradientNoise(TerrainOctaveSeed(terrain, o), worldX * frequency, worldZ * frequency) * amplitude;
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+    return floorf(TerrainShape(biome, detail)) + 1.0f;
+}
+
+#ifdef TERRAIN_SIMD
+// 32-bit lane multiply; SSE2 only has the 32x32->64 one, so do even and odd lanes separately.
+inline __m128i TerrainMul32(__m128i a, __m128i b) {
+#ifdef __SSE4_1__
+    return _mm_mullo_epi32(a, b);
+#else
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+inline __m128i TerrainMix4(__m128i h) {
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = TerrainMul32(h, _mm_set1_epi32((int)0x2C1B3C6Du));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+}
+
+// TerrainGradDot() for 4 lanes: pick the gradient's long axis from bit 2, flip signs from bits 0 and 1.
+inline __m128 TerrainGradDot4(__m128i h, __m128 dx, __m128 dz) {
+    __m128 half = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(h, _mm_set1_epi32(4)), _mm_set1_epi32(4)));
+    __m128 a = _mm_or_ps(_mm_and_ps(half, _mm_set1_ps(0.5f)), _mm_andnot_ps(half, _mm_set1_ps(1.0f)));
+    __m128 b = _mm_sub_ps(_mm_set1_ps(1.5f), a);
+    __m128 signX = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 signZ = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(_mm_mul_ps(a, dx), signX), _mm_xor_ps(_mm_mul_ps(b, dz), signZ));
+}
+#endif
+
+// Batched GetTerrainHeight() over a w x h tile: out[j * w + i] is the height at
+// (x0 + i * step, z0 + j * step). Per octave, the lattice cell, offset and fade of every column
+// are worked out once per tile and those of every row once per row, so the per-sample work is
+// the four corner hashes, gradients and lerps, which run 4 columns at a time with SSE2. The biome
+// layer comes from the thread's region cache. Heights match GetTerrainHeight() exactly.
+inline void GetTerrainHeights(const TerrainConfig& terrain, float x0, float z0, int w, int h, float* out, float step = 1.0f) {
+    const int BLOCK = 64; // Columns processed per pass, keeps the scratch on the stack
+    uint32_t seeds[TERRAIN_DETAIL_OCTAVES];
+    float frequencies[TERRAIN_DETAIL_OCTAVES], amplitudes[TERRAIN_DETAIL_OCTAVES];
+    float frequency = TERRAIN_DETAIL_FREQUENCY, amplitude = 1.0f;
+    for (int o = 0; o < TERRAIN_DETAIL_OCTAVES; o++) {
+        seeds[o] = TerrainOctaveSeed(terrain, o);
+        frequencies[o] = frequency; amplitudes[o] = amplitude;
+        frequency *= 2.0f; amplitude *= 0.5f;
+    }
+    TerrainBiomeCache& cache = TerrainBiomeCache::ForThread();
+
+    alignas(16) uint32_t colHash[TERRAIN_DETAIL_OCTAVES][BLOCK];
+    alignas(16) float colOffset[TERRAIN_DETAIL_OCTAVES][BLOCK], colFade[TERRAIN_DETAIL_OCTAVES][BLOCK];
+    alignas(16) float biome[BLOCK], detail[BLOCK];
+    int cellX[BLOCK];
+    float cellOffsetX[BLOCK];
+
+    for (int bx = 0; bx < w; bx += BLOCK) {
+        int n = (w - bx < BLOCK) ? w - bx : BLOCK;
+        int padded = (n + 3) & ~3;
+        for (int i = 0; i < padded; i++) {
+            float worldX = x0 + (float)(bx + (i < n ? i : n - 1)) * step;
+            for (int o = 0; o < TERRAIN_DETAIL_OCTAVES; o++) {
+                float x = worldX * frequencies[o], cx = floorf(x);
+                colHash[o][i] = (uint32_t)(int)cx * TERRAIN_HASH_X;
+                colOffset[o][i] = x - cx;
+                colFade[o][i] = TerrainFade(x - cx);
+            }
+            float gx = worldX * (1.0f / TERRAIN_LATTICE_STEP), kx = floorf(gx);
+            cellX[i] = (int)kx;
+            cellOffsetX[i] = gx - kx;
+        }
+
+        for (int j = 0; j < h; j++) {
+            float worldZ = z0 + (float)j * step;
+
+            float gz = worldZ * (1.0f / TERRAIN_LATTICE_STEP), kzf = floorf(gz);
+            int kz = (int)kzf, rz = kz >> TERRAIN_REGION_SHIFT;
+            float tz = gz - kzf;
+            const float* region = nullptr;
+            int regionX = 0;
+            for (int i = 0; i < n; i++) {
+                int rx = cellX[i] >> TERRAIN_REGION_SHIFT;
+                if (!region || rx != regionX) { region = cache.Region(terrain, rx, rz); regionX = rx; }
+                biome[i] = TerrainBiomeLookup(region, cellX[i], kz, cellOffsetX[i], tz);
+            }
+            for (int i = 0; i < padded; i++) detail[i] = 0.0f;
+
+            for (int o = 0; o < TERRAIN_DETAIL_OCTAVES; o++) {
+                float z = worldZ * frequencies[o], cz = floorf(z);
+                float fz = z - cz, v = TerrainFade(fz);
+                uint32_t row0 = ((uint32_t)(int)cz * TERRAIN_HASH_Z) ^ seeds[o];
+                uint32_t row1 = ((uint32_t)(int)cz * TERRAIN_HASH_Z + TERRAIN_HASH_Z) ^ seeds[o];
+                int i = 0;
+#ifdef TERRAIN_SIMD
+                __m128i r0 = _mm_set1_epi32((int)row0), r1 = _mm_set1_epi32((int)row1), stepX = _mm_set1_epi32((int)TERRAIN_HASH_X);
+                __m128 vz = _mm_set1_ps(fz), vz1 = _mm_set1_ps(fz - 1.0f), vv = _mm_set1_ps(v), one = _mm_set1_ps(1.0f);
+                __m128 amp = _mm_set1_ps(amplitudes[o]);
+                for (; i < padded; i += 4) {
+                    __m128i col = _mm_load_si128((const __m128i*)&colHash[o][i]);
+                    __m128i col1 = _mm_add_epi32(col, stepX);
+                    __m128 fx = _mm_load_ps(&colOffset[o][i]), fx1 = _mm_sub_ps(fx, one);
+                    __m128 n00 = TerrainGradDot4(TerrainMix4(_mm_add_epi32(col, r0)), fx, vz);
+                    __m128 n10 = TerrainGradDot4(TerrainMix4(_mm_add_epi32(col1, r0)), fx1, vz);
+                    __m128 n01 = TerrainGradDot4(TerrainMix4(_mm_add_epi32(col, r1)), fx, vz1);
+                    __m128 n11 = TerrainGradDot4(TerrainMix4(_mm_add_epi32(col1, r1)), fx1, vz1);
+                    __m128 u = _mm_load_ps(&colFade[o][i]);
+                    __m128 nx0 = _mm_add_ps(n00, _mm_mul_ps(u, _mm_sub_ps(n10, n00)));
+                    __m128 nx1 = _mm_add_ps(n01, _mm_mul_ps(u, _mm_sub_ps(n11, n01)));
+                    __m128 noise = _mm_add_ps(nx0, _mm_mul_ps(vv, _mm_sub_ps(nx1, nx0)));
+                    _mm_store_ps(&detail[i], _mm_add_ps(_mm_load_ps(&detail[i]), _mm_mul_ps(noise, amp)));
+                }
+#endif
+                for (; i < n; i++) {
+                    uint32_t col = colHash[o][i];
+                    float fx = colOffset[o][i], u = colFade[o][i];
+                    float n00 = TerrainGradDot(TerrainMix(col + row0), fx, fz);
+                    float n10 = TerrainGradDot(TerrainMix(col + TERRAIN_HASH_X + row0), fx - 1.0f, fz);
+                    float n01 = TerrainGradDot(TerrainMix(col + row1), fx, fz - 1.0f);
+                    float n11 = TerrainGradDot(TerrainMix(col + TERRAIN_HASH_X + row1), fx - 1.0f, fz - 1.0f);
+                    float nx0 = n00 + u * (n10 - n00);
+                    float nx1 = n01 + u * (n11 - n01);
+                    detail[i] += (nx0 + v * (nx1 - nx0)) * amplitudes[o];
+                }
+            }
+
+            float* row = out + (size_t)j * w + bx;
+            for (int i = 0; i < n; i++) row[i] = floorf(TerrainShape(biome[i], detail[i])) + 1.0f;
+        }
+    }
+}
@@ -0,0 +1,348 @@
+#pragma once
+#include "VoxelWorld.h"
+#include "JobSystem.h"
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+// A chunk and its eight neighbours copied out of the world for one lighting task: 48x48 columns at
+// full height. Light never spreads further than MAX_LIGHT blocks sideways, less than a chunk, so
+// whatever a task does to the centre chunk stays inside this volume. Tasks flood light in here and
+// the changes are copied back afterwards, which leaves the world read-only while tasks run.
+struct LightVolume {
+    static const int SX = 3 * CHUNK_SIZE, SZ = 3 * CHUNK_SIZE, SY = CHUNK_HEIGHT;
+    static const int STRIDE_Z = SX, STRIDE_Y = SX * SZ;
+    static const int CELLS = SX * SY * SZ;
+
+    ChunkCoord center = { 0, 0 };
+    const Chunk* chunks[9];     // [(dx + 1) * 3 + dz + 1], nullptr when not loaded
+    uint8_t block[CELLS];       // Missing chunks read as bedrock
+    uint8_t light[CELLS];
+
+    // x and z count from the origin of the (-1, -1) neighbour, y is the chunk-local ly.
+    static int Index(int x, int y, int z) { return (y * SZ + z) * SX + x; }
+
+    // Solid blocks hold no light of their own besides what they emit. Edits still waiting for their
+    // task may have left something else stored there; it is ignored here and kept in the world.
+    static uint8_t CanonicalLight(uint8_t block, uint8_t stored) {
+        return IsSolidBlock(block) ? (uint8_t)BlockEmission(block) : stored;
+    }
+
+    void Gather(const VoxelWorld& world, ChunkCoord c) {
+        center = c;
+        uint8_t raw[CHUNK_BLOCKS];
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dz = -1; dz <= 1; dz++) {
+                const Chunk* chunk = world.LookupChunk({ c.x + dx, c.z + dz });
+                chunks[(dx + 1) * 3 + dz + 1] = chunk;
+                if (chunk) chunk->blocks.Unpack(raw);
+                for (int ly = 0; ly < SY; ly++) {
+                    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                        int base = Index((dx + 1) * CHUNK_SIZE, ly, (dz + 1) * CHUNK_SIZE + lz);
+                        if (!chunk) {
+                            memset(&block[base], BLOCK_BEDROCK, CHUNK_SIZE);
+                            memset(&light[base], 0, CHUNK_SIZE);
+                            continue;
+                        }
+                        int src = Chunk::Index(0, ly, lz);
+                        memcpy(&block[base], &raw[src], CHUNK_SIZE);
+                        for (int lx = 0; lx < CHUNK_SIZE; lx++) light[base + lx] = CanonicalLight(raw[src + lx], chunk->light[src + lx]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Volume index of a world block, which must lie inside the volume.
+    int WorldIndex(int x, int y, int z) const {
+        return Index(x - (center.x - 1) * CHUNK_SIZE, y - WORLD_MIN_Y, z - (center.z - 1) * CHUNK_SIZE);
+    }
+};
+
+// Breadth-first flood fill of one light channel through a LightVolume: shift 4 is sky light, 0 is
+// block light. Light only enters air; sky light at full strength falls straight down for free.
+class LightFlood {
+public:
+    LightFlood(LightVolume& volume, int shift) : m_Volume(volume), m_Shift(shift), m_Sky(shift == 4) {}
+
+    int Get(int i) const { return (m_Volume.light[i] >> m_Shift) & 15; }
+    void Set(int i, int level) { m_Volume.light[i] = (uint8_t)((m_Volume.light[i] & ~(15 << m_Shift)) | (level << m_Shift)); }
+
+    // Spreads light outwards from every queued block.
+    void Propagate(std::vector<int>& queue) {
+        for (size_t head = 0; head < queue.size(); head++) {
+            int i = queue[head];
+            int level = Get(i);
+            if (level == 0) continue;
+            int neighbours[6];
+            int count = Neighbours(i, neighbours);
+            for (int k = 0; k < count; k++) {
+                int n = neighbours[k];
+                if (IsSolidBlock(m_Volume.block[n])) continue;
+                int reached = (m_Sky && level == MAX_LIGHT && n == i - LightVolume::STRIDE_Y) ? MAX_LIGHT : level - 1;
+                if (Get(n) < reached) {
+                    Set(n, reached);
+                    queue.push_back(n);
+                }
+            }
+        }
+    }
+
+    // Takes away the light that came from the queued blocks, given the level each one had. Blocks
+    // that are lit from elsewhere stop the removal and are added to sources, so a Propagate() of
+    // sources afterwards refills what was taken from another direction.
+    void Remove(std::vector<std::pair<int, int>>& queue, std::vector<int>& sources) {
+        for (size_t head = 0; head < queue.size(); head++) {
+            int i = queue[head].first, level = queue[head].second;
+            int neighbours[6];
+            int count = Neighbours(i, neighbours);
+            for (int k = 0; k < count; k++) {
+                int n = neighbours[k];
+                int stored = Get(n);
+                if (stored == 0) continue;
+                bool fedByThis = (stored < level) || (m_Sky && level == MAX_LIGHT && stored == MAX_LIGHT && n == i - LightVolume::STRIDE_Y);
+                if (!fedByThis) { sources.push_back(n); continue; }
+                int own = m_Sky ? 0 : BlockEmission(m_Volume.block[n]);
+                Set(n, own);
+                queue.push_back({ n, stored });
+                if (own > 0) sources.push_back(n);
+            }
+        }
+    }
+
+private:
+    int Neighbours(int i, int out[6]) const {
+        int x = i % LightVolume::SX, z = (i / LightVolume::SX) % LightVolume::SZ, y = i / LightVolume::STRIDE_Y;
+        int count = 0;
+        if (x > 0)                     out[count++] = i - 1;
+        if (x < LightVolume::SX - 1)   out[count++] = i + 1;
+        if (z > 0)                     out[count++] = i - LightVolume::STRIDE_Z;
+        if (z < LightVolume::SZ - 1)   out[count++] = i + LightVolume::STRIDE_Z;
+        if (y > 0)                     out[count++] = i - LightVolume::STRIDE_Y;
+        if (y < LightVolume::SY - 1)   out[count++] = i + LightVolume::STRIDE_Y;
+        return count;
+    }
+
+    LightVolume& m_Volume;
+    int m_Shift;
+    bool m_Sky;
+};
+
+// Sky and block light for the loaded chunks, kept current with flood fills:
+//
+// * A chunk inserted next to anything but plain generated terrain gets a full pass once its eight
+//   neighbours are loaded: its own light is reseeded and floods both into and out of it. Plain
+//   terrain is already lit exactly by Chunk::SeedLight().
+// * An edited block gets an incremental relight: the light it used to hold or pass on is removed
+//   breadth-first, then refilled from whatever still lights the area, including the new block if
+//   it is a lamp.
+//
+// Every task works on a chunk and its eight neighbours, so tasks whose chunks are three or more
+// chunks apart on some axis never touch the same data. Update() runs them in nine phases by
+// chunk coordinate modulo 3, each phase across the job system, and copies results back between
+// phases on the calling thread. Results do not depend on the thread count.
+class VoxelLighting {
+public:
+    size_t FullPasses = 0;
+    size_t EditPasses = 0;
+
+    void Clear() { m_Tasks.clear(); }
+    size_t Pending() const { return m_Tasks.size(); }
+
+    // Call with the chunks a ChunkBuilder::Poll() just inserted.
+    void ChunksInserted(const VoxelWorld& world, const std::vector<ChunkCoord>& coords) {
+        for (ChunkCoord c : coords) {
+            bool plain = true;
+            for (int dx = -1; dx <= 1 && plain; dx++)
+                for (int dz = -1; dz <= 1 && plain; dz++)
+                    if (const Chunk* chunk = world.FindChunk({ c.x + dx, c.z + dz })) plain = chunk->heightfield;
+            if (!plain) m_Tasks[c].full = true;
+        }
+    }
+
+    // Call after a VoxelWorld::SetBlock() that returned true; the light stored at the block is
+    // still what it held before the edit.
+    void BlockChanged(int x, int y, int z) {
+        m_Tasks[ChunkCoordOf(x, z)].cells.push_back({ { x, y, z } });
+    }
+
+    // Runs every task that can run and appends the chunks whose meshes now show outdated light.
+    // jobs may be nullptr to run everything on the calling thread. Returns the tasks run.
+    int Update(VoxelWorld& world, JobSystem* jobs, std::vector<ChunkCoord>& remesh) {
+        m_Ready.clear();
+        for (auto it = m_Tasks.begin(); it != m_Tasks.end(); ) {
+            ChunkCoord c = it->first;
+            if (!world.FindChunk(c)) { it = m_Tasks.erase(it); continue; }
+            if (it->second.full && !NeighboursLoaded(world, c)) { ++it; continue; }
+            m_Ready.push_back({ c, std::move(it->second) });
+            it = m_Tasks.erase(it);
+        }
+        if (m_Ready.empty()) return 0;
+
+        // Phase by coordinate modulo 3, then by coordinate so the order is the same every run.
+        auto phase = [](ChunkCoord c) { return ((c.x % 3 + 3) % 3) * 3 + (c.z % 3 + 3) % 3; };
+        std::sort(m_Ready.begin(), m_Ready.end(), [&phase](const ReadyTask& a, const ReadyTask& b) {
+            int pa = phase(a.coord), pb = phase(b.coord);
+            if (pa != pb) return pa < pb;
+            return (a.coord.x != b.coord.x) ? a.coord.x < b.coord.x : a.coord.z < b.coord.z;
+        });
+
+        std::unordered_map<ChunkCoord, bool, ChunkCoordHash> marked;
+        for (size_t begin = 0; begin < m_Ready.size(); ) {
+            size_t end = begin;
+            while (end < m_Ready.size() && phase(m_Ready[end].coord) == phase(m_Ready[begin].coord)) end++;
+            int count = (int)(end - begin);
+            m_Results.resize(count);
+            auto run = [this, &world, begin](int i) { RunTask(world, m_Ready[begin + i], m_Results[i]); };
+            if (jobs && count > 1) jobs->ParallelFor(count, run);
+            else for (int i = 0; i < count; i++) run(i);
+
+            for (int i = 0; i < count; i++) {
+                TaskResult& result = m_Results[i];
+                for (int k = 0; k < 9; k++) {
+                    if (result.light[k].empty()) continue;
+                    if (Chunk* chunk = world.EditChunk(result.coords[k])) memcpy(chunk->light, result.light[k].data(), CHUNK_BLOCKS);
+                    result.light[k].clear();
+                }
+                for (ChunkCoord c : result.remesh)
+                    if (!marked[c]) { marked[c] = true; remesh.push_back(c); }
+                result.remesh.clear();
+                if (m_Ready[begin + i].task.full) FullPasses++;
+                else EditPasses++;
+            }
+            begin = end;
+        }
+        return (int)m_Ready.size();
+    }
+
+private:
+    struct Task {
+        bool full = false;
+        std::vector<std::array<int, 3>> cells;  // Edited blocks, world coordinates
+    };
+    struct ReadyTask {
+        ChunkCoord coord;
+        Task task;
+    };
+    struct TaskResult {
+        ChunkCoord coords[9];
+        std::vector<uint8_t> light[9];          // New light of each chunk that changed
+        std::vector<ChunkCoord> remesh;
+    };
+
+    static bool NeighboursLoaded(const VoxelWorld& world, ChunkCoord c) {
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dz = -1; dz <= 1; dz++)
+                if (!world.FindChunk({ c.x + dx, c.z + dz })) return false;
+        return true;
+    }
+
+    static void RunTask(const VoxelWorld& world, const ReadyTask& ready, TaskResult& result) {
+        static thread_local LightVolume volume;
+        static thread_local std::vector<int> owned, skyQueue, blockQueue;
+        static thread_local std::vector<std::pair<int, int>> skyRemoval, blockRemoval;
+        volume.Gather(world, ready.coord);
+        owned.clear(); skyQueue.clear(); blockQueue.clear(); skyRemoval.clear(); blockRemoval.clear();
+        LightFlood sky(volume, 4), blockLight(volume, 0);
+
+        if (ready.task.full) {
+            // Reseed the centre chunk, then flood from it and from the blocks around it.
+            const int lo = CHUNK_SIZE, hi = 2 * CHUNK_SIZE;
+            for (int z = lo; z < hi; z++) {
+                for (int x = lo; x < hi; x++) {
+                    bool open = true;
+                    for (int y = LightVolume::SY - 1; y >= 0; y--) {
+                        int i = LightVolume::Index(x, y, z);
+                        open = open && !IsSolidBlock(volume.block[i]);
+                        volume.light[i] = (uint8_t)((open ? LIGHT_OPEN_SKY : 0) | BlockEmission(volume.block[i]));
+                        if (volume.light[i]) { skyQueue.push_back(i); blockQueue.push_back(i); }
+                    }
+                }
+            }
+            for (int y = 0; y < LightVolume::SY; y++) {
+                for (int k = lo; k < hi; k++) {
+                    const int ring[4] = { LightVolume::Index(lo - 1, y, k), LightVolume::Index(hi, y, k), LightVolume::Index(k, y, lo - 1), LightVolume::Index(k, y, hi) };
+                    for (int i : ring) if (volume.light[i]) { skyQueue.push_back(i); blockQueue.push_back(i); }
+                }
+            }
+        } else {
+            // Edits: take away what each edited block held or passed on, then refill.
+            for (const std::array<int, 3>& cell : ready.task.cells) {
+                int i = volume.WorldIndex(cell[0], cell[1], cell[2]);
+                if (std::find(owned.begin(), owned.end(), i) != owned.end()) continue;
+                owned.push_back(i);
+                const Chunk* chunk = volume.chunks[4];
+                uint8_t before = chunk->light[Chunk::Index(cell[0] - chunk->OriginX(), cell[1] - WORLD_MIN_Y, cell[2] - chunk->OriginZ())];
+                uint8_t block = volume.block[i];
+                volume.light[i] = (uint8_t)BlockEmission(block);
+                if (SkyLight(before)) skyRemoval.push_back({ i, SkyLight(before) });
+                if (BlockLight(before)) blockRemoval.push_back({ i, BlockLight(before) });
+                if (BlockEmission(block)) blockQueue.push_back(i);
+            }
+            sky.Remove(skyRemoval, skyQueue);
+            blockLight.Remove(blockRemoval, blockQueue);
+            // Air where a block was lets the light around it in.
+            for (int i : owned) {
+                if (IsSolidBlock(volume.block[i])) continue;
+                const int around[6] = { i - 1, i + 1, i - LightVolume::STRIDE_Z, i + LightVolume::STRIDE_Z, i - LightVolume::STRIDE_Y, i + LightVolume::STRIDE_Y };
+                int y = i / LightVolume::STRIDE_Y;
+                for (int n : around) {
+                    // Edited blocks are in the centre chunk, so only y can leave the volume.
+                    if ((n == i - LightVolume::STRIDE_Y && y == 0) || (n == i + LightVolume::STRIDE_Y && y == LightVolume::SY - 1)) continue;
+                    skyQueue.push_back(n);
+                    blockQueue.push_back(n);
+                }
+                if (y == LightVolume::SY - 1) { sky.Set(i, MAX_LIGHT); skyQueue.push_back(i); }   // Open sky above the top layer
+            }
+        }
+        sky.Propagate(skyQueue);
+        blockLight.Propagate(blockQueue);
+        WriteBack(volume, ready.task.full, owned, result);
+    }
+
+    // Copies out the chunks whose light changed, and lists every chunk whose mesh reads a changed
+    // block: the chunk itself, plus the neighbours beside a changed block on its border.
+    static void WriteBack(const LightVolume& volume, bool fullPass, const std::vector<int>& owned, TaskResult& result) {
+        result.remesh.clear();
+        bool remesh[5][5] = {};
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dz = -1; dz <= 1; dz++) {
+                int k = (dx + 1) * 3 + dz + 1;
+                const Chunk* chunk = volume.chunks[k];
+                result.coords[k] = { volume.center.x + dx, volume.center.z + dz };
+                result.light[k].clear();
+                if (!chunk) continue;
+                bool centre = (dx == 0 && dz == 0);
+                std::vector<uint8_t>& out = result.light[k];
+                for (int ly = 0; ly < CHUNK_HEIGHT; ly++) {
+                    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                        int base = LightVolume::Index((dx + 1) * CHUNK_SIZE, ly, (dz + 1) * CHUNK_SIZE + lz);
+                        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                            int i = base + lx, index = Chunk::Index(lx, ly, lz);
+                            if (volume.light[i] == chunk->light[index]) continue;
+                            bool mine = !IsSolidBlock(volume.block[i]) || (fullPass && centre) || (centre && std::find(owned.begin(), owned.end(), i) != owned.end());
+                            if (!mine) continue;
+                            if (out.empty()) out.assign(chunk->light, chunk->light + CHUNK_BLOCKS);
+                            out[index] = volume.light[i];
+                            int bx = (lx == 0) ? -1 : (lx == CHUNK_SIZE - 1) ? 1 : 0;
+                            int bz = (lz == 0) ? -1 : (lz == CHUNK_SIZE - 1) ? 1 : 0;
+                            remesh[dx + 2][dz + 2] = true;
+                            remesh[dx + 2 + bx][dz + 2] = true;
+                            remesh[dx + 2][dz + 2 + bz] = true;
+                            remesh[dx + 2 + bx][dz + 2 + bz] = true;
+                        }
+                    }
+                }
+            }
+        }
+        for (int x = 0; x < 5; x++)
+            for (int z = 0; z < 5; z++)
+                if (remesh[x][z]) result.remesh.push_back({ volume.center.x + x - 2, volume.center.z + z - 2 });
+    }
+
+    std::unordered_map<ChunkCoord, Task, ChunkCoordHash> m_Tasks;
+    std::vector<ReadyTask> m_Ready;
+    std::vector<TaskResult> m_Results;
+};
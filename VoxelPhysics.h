@@ -0,0 +1,225 @@
+#pragma once
+#include "VoxelWorld.h"
+#include <cmath>
+#include <algorithm>
+
+// Blocks are centred on integer coordinates, so cell i spans [i - 0.5, i + 0.5).
+inline int CellOf(float coord) { return (int)floor(coord + 0.5f); }
+
+struct Aabb {
+    float min[3], max[3];
+};
+
+struct SweepHit {
+    bool hit = false;
+    float t = 1.0f;                 // Fraction of the displacement covered before contact
+    int axis = -1;                  // 0 = X, 1 = Y, 2 = Z
+    float normal[3] = { 0, 0, 0 };  // Away from the block that was hit
+    int block[3] = { 0, 0, 0 };
+};
+
+// Sweeps a box through the block grid and reports the first solid block it runs into.
+// A DDA walks the leading corner from cell boundary to cell boundary; at each boundary only the
+// layer of cells the leading face enters is checked, so the cost depends on the distance and the
+// box size but nothing can be skipped at any speed. Cells the box overlaps at the start are
+// ignored, which lets a box resting against a wall slide along it.
+inline SweepHit SweepAabb(const VoxelWorld& world, const Aabb& box, const float delta[3]) {
+    const float EPS = 1e-4f;
+    SweepHit result;
+    float length = sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+    if (length <= 0.0f) return result;
+
+    float dir[3], tDelta[3], tNext[3];
+    int step[3], leadCell[3];
+    for (int a = 0; a < 3; a++) {
+        dir[a] = delta[a] / length;
+        step[a] = (dir[a] > 0.0f) ? 1 : (dir[a] < 0.0f) ? -1 : 0;
+        float lead = (step[a] > 0) ? box.max[a] : box.min[a];
+        // An edge sitting exactly on a boundary belongs to the cell it is about to leave.
+        leadCell[a] = CellOf(lead - step[a] * EPS);
+        if (step[a] != 0) {
+            tDelta[a] = 1.0f / fabs(dir[a]);
+            tNext[a] = ((leadCell[a] + 0.5f * step[a]) - lead) / dir[a];
+        } else {
+            tDelta[a] = tNext[a] = INFINITY;
+        }
+    }
+
+    for (;;) {
+        int axis = (tNext[0] < tNext[1]) ? ((tNext[0] < tNext[2]) ? 0 : 2) : ((tNext[1] < tNext[2]) ? 1 : 2);
+        float t = tNext[axis];
+        if (t > length) break;
+        leadCell[axis] += step[axis];
+        tNext[axis] += tDelta[axis];
+
+        // The layer of cells the leading face enters. Across it, the box spans from its trailing
+        // edge at distance t to the lead cell of that axis, which already includes any boundary
+        // crossed at the same t (a box moving off a corner enters both layers at once).
+        int lo[3], hi[3];
+        for (int a = 0; a < 3; a++) {
+            if (a == axis) { lo[a] = hi[a] = leadCell[a]; continue; }
+            if (step[a] == 0) {
+                lo[a] = CellOf(box.min[a] + EPS);
+                hi[a] = CellOf(box.max[a] - EPS);
+                continue;
+            }
+            float trail = ((step[a] > 0) ? box.min[a] : box.max[a]) + dir[a] * t;
+            int trailCell = CellOf(trail + step[a] * EPS);
+            lo[a] = std::min(trailCell, leadCell[a]);
+            hi[a] = std::max(trailCell, leadCell[a]);
+        }
+        for (int y = lo[1]; y <= hi[1]; y++) {
+            for (int z = lo[2]; z <= hi[2]; z++) {
+                for (int x = lo[0]; x <= hi[0]; x++) {
+                    if (!world.IsBlockSolid(x, y, z)) continue;
+                    result.hit = true;
+                    result.t = t / length;
+                    result.axis = axis;
+                    result.normal[axis] = (float)-step[axis];
+                    result.block[0] = x; result.block[1] = y; result.block[2] = z;
+                    return result;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+inline bool AabbOverlapsSolid(const VoxelWorld& world, const Aabb& box) {
+    const float EPS = 1e-4f;
+    for (int y = CellOf(box.min[1] + EPS); y <= CellOf(box.max[1] - EPS); y++)
+        for (int z = CellOf(box.min[2] + EPS); z <= CellOf(box.max[2] - EPS); z++)
+            for (int x = CellOf(box.min[0] + EPS); x <= CellOf(box.max[0] - EPS); x++)
+                if (world.IsBlockSolid(x, y, z)) return true;
+    return false;
+}
+
+struct MoveResult {
+    float moved[3] = { 0, 0, 0 };   // Displacement actually applied
+    SweepHit contacts[3];           // At most one per axis
+    int contactCount = 0;
+    bool blocked[3] = { false, false, false };
+    bool steppedUp = false;
+};
+
+// Moves a box by delta and slides along whatever it hits: after each contact the box is snapped
+// flush against the block face, the blocked component is dropped and the rest is swept again.
+inline MoveResult MoveAabb(const VoxelWorld& world, Aabb& box, const float delta[3]) {
+    MoveResult result;
+    float remaining[3] = { delta[0], delta[1], delta[2] };
+    for (int iteration = 0; iteration < 3; iteration++) {
+        SweepHit hit = SweepAabb(world, box, remaining);
+        float t = hit.hit ? hit.t : 1.0f;
+        float offset[3] = { remaining[0] * t, remaining[1] * t, remaining[2] * t };
+        if (hit.hit) {
+            // Snap the blocked face onto the block boundary so rounding never accumulates.
+            int a = hit.axis;
+            float face = hit.block[a] + 0.5f * hit.normal[a];
+            offset[a] = (hit.normal[a] < 0.0f) ? face - box.max[a] : face - box.min[a];
+        }
+        for (int a = 0; a < 3; a++) {
+            box.min[a] += offset[a]; box.max[a] += offset[a];
+            result.moved[a] += offset[a];
+        }
+        if (!hit.hit) break;
+
+        result.contacts[result.contactCount++] = hit;
+        result.blocked[hit.axis] = true;
+        for (int a = 0; a < 3; a++) remaining[a] = (a == hit.axis) ? 0.0f : remaining[a] * (1.0f - hit.t);
+        if (remaining[0] == 0.0f && remaining[1] == 0.0f && remaining[2] == 0.0f) break;
+    }
+    return result;
+}
+
+// An upright player-sized box. Position is the centre of the feet.
+struct PhysicsBody {
+    float pos[3] = { 0, 0, 0 };
+    float vel[3] = { 0, 0, 0 };
+    float halfWidth = 0.2f;
+    float height = 1.9f;
+    float stepHeight = 0.0f;        // Ledges up to this height are climbed without jumping
+    bool grounded = false;
+
+    Aabb Box() const {
+        return { { pos[0] - halfWidth, pos[1], pos[2] - halfWidth }, { pos[0] + halfWidth, pos[1] + height, pos[2] + halfWidth } };
+    }
+    void SetBox(const Aabb& box) {
+        pos[0] = (box.min[0] + box.max[0]) * 0.5f;
+        pos[1] = box.min[1];
+        pos[2] = (box.min[2] + box.max[2]) * 0.5f;
+    }
+};
+
+// Moves a body by delta with sliding. When a grounded body is blocked sideways, it also tries
+// the move lifted by stepHeight and settled back down, and keeps whichever got further. Velocity
+// along every blocked axis is cleared. A body that starts inside terrain (e.g. spawned before its
+// chunk existed) is lifted onto the column top first, like the old ground snap did.
+inline MoveResult MoveBody(const VoxelWorld& world, PhysicsBody& body, const float delta[3]) {
+    Aabb box = body.Box();
+    if (AabbOverlapsSolid(world, box)) {
+        int x = CellOf(body.pos[0]), z = CellOf(body.pos[2]);
+        int y = CellOf(box.min[1] + 1e-4f);
+        while (y <= WORLD_MAX_Y && world.IsBlockSolid(x, y, z)) y++;
+        float lift = (y - 0.5f) - box.min[1];
+        box.min[1] += lift; box.max[1] += lift;
+    }
+
+    Aabb start = box;
+    MoveResult result = MoveAabb(world, box, delta);
+
+    if (body.stepHeight > 0.0f && body.grounded && (result.blocked[0] || result.blocked[2])) {
+        Aabb stepped = start;
+        const float up[3] = { 0.0f, body.stepHeight, 0.0f };
+        MoveResult lift = MoveAabb(world, stepped, up);
+        const float across[3] = { delta[0], 0.0f, delta[2] };
+        MoveResult side = MoveAabb(world, stepped, across);
+        const float down[3] = { 0.0f, -lift.moved[1] + std::min(delta[1], 0.0f), 0.0f };
+        MoveResult settle = MoveAabb(world, stepped, down);
+
+        float plain = result.moved[0] * result.moved[0] + result.moved[2] * result.moved[2];
+        float climbed = side.moved[0] * side.moved[0] + side.moved[2] * side.moved[2];
+        if (climbed > plain + 1e-6f && settle.blocked[1]) {
+            box = stepped;
+            result = side;
+            result.moved[1] = stepped.min[1] - start.min[1];
+            result.blocked[1] = true;
+            for (int i = 0; i < settle.contactCount && result.contactCount < 3; i++) result.contacts[result.contactCount++] = settle.contacts[i];
+            result.steppedUp = true;
+        }
+    }
+
+    body.SetBox(box);
+    for (int a = 0; a < 3; a++) if (result.blocked[a]) body.vel[a] = 0.0f;
+    body.grounded = false;
+    for (int i = 0; i < result.contactCount; i++) if (result.contacts[i].normal[1] > 0.0f) body.grounded = true;
+    return result;
+}
+
+// Player movement as UpdateCamera() used to do it per frame, now per fixed tick.
+const float PLAYER_MOVE_SPEED = 10.0f;
+const float PLAYER_GRAVITY    = 25.0f;
+const float PLAYER_JUMP_SPEED = 9.0f;
+const float PLAYER_EYE_HEIGHT = 1.8f;
+
+struct PlayerInput {
+    float moveX = 0.0f, moveZ = 0.0f;   // Desired direction in world space, length <= 1 walks at full speed
+    bool jump = false;
+};
+
+// One tick of player physics, split into `substeps` equal sweeps. Only depends on its arguments,
+// so the same input stream always produces the same positions.
+inline void StepPlayer(const VoxelWorld& world, PhysicsBody& body, const PlayerInput& input, float dt, int substeps = 1) {
+    if (input.jump && body.grounded) {
+        body.vel[1] = PLAYER_JUMP_SPEED;
+        body.grounded = false;
+    }
+    body.vel[0] = input.moveX * PLAYER_MOVE_SPEED;
+    body.vel[2] = input.moveZ * PLAYER_MOVE_SPEED;
+
+    float h = dt / (float)substeps;
+    for (int i = 0; i < substeps; i++) {
+        body.vel[1] -= PLAYER_GRAVITY * h;
+        const float delta[3] = { body.vel[0] * h, body.vel[1] * h, body.vel[2] * h };
+        MoveBody(world, body, delta);
+    }
+}
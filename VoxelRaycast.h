@@ -0,0 +1,190 @@
+#pragma once
+#include "VoxelWorld.h"
+#include "JobSystem.h"
+#include <stdint.h>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+struct RaycastHit {
+    bool hit = false;
+    int block[3] = { 0, 0, 0 };
+    int normal[3] = { 0, 0, 0 };    // Face the ray entered through, all zero when it starts inside the block
+    float distance = 0.0f;          // Along the normalized direction
+    uint8_t type = BLOCK_AIR;
+};
+
+struct RaycastStats {
+    uint64_t cellsVisited = 0;      // Cells tested one by one
+    uint64_t spansSkipped = 0;      // Empty chunks and column spans crossed in a single jump
+};
+
+struct Ray {
+    float origin[3];
+    float dir[3];                   // Any length
+    float maxDistance;
+};
+
+// Cell a coordinate on a ray belongs to, with a point exactly on a boundary going to the cell the
+// ray is moving into.
+inline int RayCellOf(float coord, int step) {
+    return (step < 0) ? (int)ceil(coord - 0.5f) : (int)floor(coord + 0.5f);
+}
+
+// Amanatides-Woo DDA through the block grid. Blocks are only tested where they can exist: a chunk
+// that is not loaded, the part of a chunk above its highest column and the part of a column above
+// its top block are all air, so the ray leaves each such box in one jump instead of stepping
+// through it cell by cell. Unloaded chunks count as empty, and so does everything outside
+// [WORLD_MIN_Y, WORLD_MAX_Y]. Never generates chunks and never touches the world's lookup cache,
+// so any number of threads may cast into a world that is not being modified.
+inline RaycastHit RaycastBlocks(const VoxelWorld& world, const float origin[3], const float dir[3], float maxDistance, RaycastStats* stats = nullptr) {
+    RaycastHit result;
+    float length = sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    if (length <= 0.0f || !(maxDistance >= 0.0f)) return result;
+
+    float d[3], invDir[3], tDelta[3];
+    int step[3];
+    for (int a = 0; a < 3; a++) {
+        d[a] = dir[a] / length;
+        step[a] = (d[a] > 0.0f) ? 1 : (d[a] < 0.0f) ? -1 : 0;
+        invDir[a] = (step[a] != 0) ? 1.0f / d[a] : INFINITY;
+        tDelta[a] = fabs(invDir[a]);
+    }
+
+    // Clip to the vertical extent of the world.
+    const float yLow = WORLD_MIN_Y - 0.5f, yHigh = WORLD_MAX_Y + 0.5f;
+    float t = 0.0f, tEnd = maxDistance;
+    int enterAxis = -1;
+    if (step[1] == 0) {
+        if (origin[1] < yLow || origin[1] >= yHigh) return result;
+    } else {
+        float t0 = (yLow - origin[1]) * invDir[1], t1 = (yHigh - origin[1]) * invDir[1];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > 0.0f) { t = t0; enterAxis = 1; }
+        tEnd = std::min(tEnd, t1);
+    }
+    if (t > tEnd) return result;
+
+    int cell[3];
+    float tNext[3];
+    auto enterAt = [&](float tEnter) {
+        for (int a = 0; a < 3; a++) cell[a] = RayCellOf(origin[a] + d[a] * tEnter, step[a]);
+        cell[1] = std::min(std::max(cell[1], WORLD_MIN_Y), WORLD_MAX_Y);
+    };
+    auto resetBoundaries = [&]() {
+        for (int a = 0; a < 3; a++)
+            tNext[a] = (step[a] != 0) ? ((cell[a] + 0.5f * step[a]) - origin[a]) * invDir[a] : INFINITY;
+    };
+    enterAt(t);
+    resetBoundaries();
+
+    ChunkCoord chunkCoord = { INT_MIN, INT_MIN };
+    const Chunk* chunk = nullptr;
+    for (;;) {
+        ChunkCoord coord = ChunkCoordOf(cell[0], cell[2]);
+        if (!(coord == chunkCoord)) {
+            chunkCoord = coord;
+            chunk = world.LookupChunk(coord);
+        }
+
+        // Box of cells known to be air around the current one, if any.
+        int lo[3], hi[3];
+        bool empty = false;
+        int originX = coord.x * CHUNK_SIZE, originZ = coord.z * CHUNK_SIZE;
+        if (!chunk || cell[1] > chunk->maxTopY) {
+            lo[0] = originX; hi[0] = originX + CHUNK_SIZE - 1;
+            lo[2] = originZ; hi[2] = originZ + CHUNK_SIZE - 1;
+            lo[1] = chunk ? chunk->maxTopY + 1 : WORLD_MIN_Y;
+            hi[1] = WORLD_MAX_Y;
+            empty = true;
+        } else {
+            int top = chunk->topY[(cell[2] - originZ) * CHUNK_SIZE + (cell[0] - originX)];
+            if (cell[1] > top) {
+                lo[0] = hi[0] = cell[0];
+                lo[2] = hi[2] = cell[2];
+                lo[1] = top + 1; hi[1] = WORLD_MAX_Y;
+                empty = true;
+            }
+        }
+
+        if (empty) {
+            int axis = -1;
+            float tExit = INFINITY;
+            for (int a = 0; a < 3; a++) {
+                if (step[a] == 0) continue;
+                float boundary = (step[a] > 0) ? hi[a] + 0.5f : lo[a] - 0.5f;
+                float ta = (boundary - origin[a]) * invDir[a];
+                if (ta < tExit) { tExit = ta; axis = a; }
+            }
+            if (stats) stats->spansSkipped++;
+            if (tExit > tEnd) return result;
+            t = std::max(t, tExit);
+            enterAt(t);
+            // The exit face decides the next cell along its axis; the others stay inside the box.
+            for (int a = 0; a < 3; a++) {
+                if (a == axis) cell[a] = (step[a] > 0) ? hi[a] + 1 : lo[a] - 1;
+                else cell[a] = std::min(std::max(cell[a], lo[a]), hi[a]);
+            }
+            if (cell[1] < WORLD_MIN_Y || cell[1] > WORLD_MAX_Y) return result;
+            enterAxis = axis;
+            resetBoundaries();
+            continue;
+        }
+
+        if (stats) stats->cellsVisited++;
+        uint8_t block = chunk->Get(cell[0] - originX, cell[1] - WORLD_MIN_Y, cell[2] - originZ);
+        if (IsSolidBlock(block)) {
+            result.hit = true;
+            result.type = block;
+            result.distance = t;
+            for (int a = 0; a < 3; a++) result.block[a] = cell[a];
+            if (enterAxis >= 0) result.normal[enterAxis] = -step[enterAxis];
+            return result;
+        }
+
+        int axis = (tNext[0] < tNext[1]) ? ((tNext[0] < tNext[2]) ? 0 : 2) : ((tNext[1] < tNext[2]) ? 1 : 2);
+        t = tNext[axis];
+        if (t > tEnd) return result;
+        cell[axis] += step[axis];
+        tNext[axis] += tDelta[axis];
+        enterAxis = axis;
+        if (cell[1] < WORLD_MIN_Y || cell[1] > WORLD_MAX_Y) return result;
+    }
+}
+
+inline RaycastHit RaycastBlocks(const VoxelWorld& world, const Ray& ray, RaycastStats* stats = nullptr) {
+    return RaycastBlocks(world, ray.origin, ray.dir, ray.maxDistance, stats);
+}
+
+// True when no solid block lies between the two points. A target inside a block counts as hidden.
+inline bool HasLineOfSight(const VoxelWorld& world, const float from[3], const float to[3]) {
+    float delta[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+    float distance = sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+    if (distance <= 0.0f) return true;
+    return !RaycastBlocks(world, from, delta, distance).hit;
+}
+
+// Rays are handed out in slices of RAYCAST_BATCH_SLICE so small batches stay on the caller.
+const int RAYCAST_BATCH_SLICE = 256;
+
+inline void RaycastBatch(const VoxelWorld& world, const Ray* rays, size_t count, RaycastHit* hits, JobSystem* jobs = nullptr) {
+    int slices = (int)((count + RAYCAST_BATCH_SLICE - 1) / RAYCAST_BATCH_SLICE);
+    auto castSlice = [&](int slice) {
+        size_t end = std::min(count, (size_t)(slice + 1) * RAYCAST_BATCH_SLICE);
+        for (size_t i = (size_t)slice * RAYCAST_BATCH_SLICE; i < end; i++) hits[i] = RaycastBlocks(world, rays[i]);
+    };
+    if (jobs && slices > 1) jobs->ParallelFor(slices, castSlice);
+    else for (int s = 0; s < slices; s++) castSlice(s);
+}
+
+// Line-of-sight queries for AI: from and to hold count xyz triples, visible[i] is 1 when pair i
+// can see each other.
+inline void LineOfSightBatch(const VoxelWorld& world, const float* from, const float* to, size_t count, uint8_t* visible, JobSystem* jobs = nullptr) {
+    int slices = (int)((count + RAYCAST_BATCH_SLICE - 1) / RAYCAST_BATCH_SLICE);
+    auto testSlice = [&](int slice) {
+        size_t end = std::min(count, (size_t)(slice + 1) * RAYCAST_BATCH_SLICE);
+        for (size_t i = (size_t)slice * RAYCAST_BATCH_SLICE; i < end; i++) visible[i] = HasLineOfSight(world, from + i * 3, to + i * 3) ? 1 : 0;
+    };
+    if (jobs && slices > 1) jobs->ParallelFor(slices, testSlice);
+    else for (int s = 0; s < slices; s++) testSlice(s);
+}
@@ -0,0 +1,382 @@
+#pragma once
+#include "Terrain.h"
+#include "PalettedBlocks.h"
+#include <stdint.h>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+const int CHUNK_SIZE   = 16;                              // Blocks per chunk along X and Z
+const int CHUNK_HEIGHT = 32;                              // Blocks per column
+const int WORLD_MIN_Y  = -6;                              // Lowest block layer (the old floorLevel)
+const int WORLD_MAX_Y  = WORLD_MIN_Y + CHUNK_HEIGHT - 1;
+const int CHUNK_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_HEIGHT;
+
+enum BlockType : uint8_t {
+    BLOCK_AIR = 0,
+    BLOCK_BEDROCK,
+    BLOCK_DIRT,
+    BLOCK_WATER,
+    BLOCK_GRASS,
+    BLOCK_STONE,
+    BLOCK_SNOW,
+    BLOCK_LAMP,
+    BLOCK_TYPE_COUNT
+};
+
+inline bool IsSolidBlock(uint8_t block) { return block != BLOCK_AIR; }
+
+inline const char* BlockTypeName(uint8_t block) {
+    static const char* names[BLOCK_TYPE_COUNT] = { "Air", "Bedrock", "Dirt", "Water", "Grass", "Stone", "Snow", "Lamp" };
+    return block < BLOCK_TYPE_COUNT ? names[block] : "Unknown";
+}
+
+// Light levels run from 0 to MAX_LIGHT. Each block stores two: sky light in the high nibble, which
+// falls straight down from the open sky without fading, and block light from emitters in the low
+// one. Both lose a level per block they spread sideways or up; solid blocks stop both.
+const int MAX_LIGHT = 15;
+const uint8_t LIGHT_OPEN_SKY = MAX_LIGHT << 4;
+
+inline int SkyLight(uint8_t light) { return light >> 4; }
+inline int BlockLight(uint8_t light) { return light & 15; }
+inline int CombinedLight(uint8_t light) { return std::max(light >> 4, light & 15); }
+inline int BlockEmission(uint8_t block) { return (block == BLOCK_LAMP) ? MAX_LIGHT : 0; }
+
+// Same bands PS() used for the isTopBlock tint, evaluated at the block centre.
+inline uint8_t SurfaceBlockAt(int y) {
+    if (y <= -2) return BLOCK_WATER;
+    if (y <= 0)  return BLOCK_GRASS;
+    if (y <= 3)  return BLOCK_STONE;
+    return BLOCK_SNOW;
+}
+
+inline uint8_t FillBlockAt(int y) {
+    return (y < -3) ? BLOCK_BEDROCK : BLOCK_DIRT;
+}
+
+// Floor division, so that block -1 lands in chunk -1 rather than chunk 0.
+inline int FloorDiv(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+struct ChunkCoord {
+    int x, z;
+    bool operator==(const ChunkCoord& o) const { return x == o.x && z == o.z; }
+    bool operator!=(const ChunkCoord& o) const { return !(*this == o); }
+};
+
+struct ChunkCoordHash {
+    size_t operator()(const ChunkCoord& c) const {
+        uint64_t key = ((uint64_t)(uint32_t)c.x << 32) | (uint32_t)c.z;
+        key ^= key >> 33; key *= 0xff51afd7ed558ccdULL; key ^= key >> 33;
+        return (size_t)key;
+    }
+};
+
+inline ChunkCoord ChunkCoordOf(int blockX, int blockZ) {
+    return { FloorDiv(blockX, CHUNK_SIZE), FloorDiv(blockZ, CHUNK_SIZE) };
+}
+
+// Chebyshev distance in blocks from column (blockX, blockZ) to the nearest column of the chunk,
+// 0 when the column is inside it.
+inline int ChunkDistance(ChunkCoord coord, int blockX, int blockZ) {
+    int x0 = coord.x * CHUNK_SIZE, x1 = x0 + CHUNK_SIZE - 1;
+    int z0 = coord.z * CHUNK_SIZE, z1 = z0 + CHUNK_SIZE - 1;
+    int dx = (blockX < x0) ? x0 - blockX : (blockX > x1) ? blockX - x1 : 0;
+    int dz = (blockZ < z0) ? z0 - blockZ : (blockZ > z1) ? blockZ - z1 : 0;
+    return std::max(dx, dz);
+}
+
+// A 16x16 footprint of block columns spanning WORLD_MIN_Y..WORLD_MAX_Y.
+// Local coordinates: lx/lz in [0, CHUNK_SIZE), ly = worldY - WORLD_MIN_Y in [0, CHUNK_HEIGHT).
+struct Chunk {
+    ChunkCoord coord = { 0, 0 };
+    PalettedBlocks blocks{ CHUNK_BLOCKS };  // Indexed by Index()
+    int8_t topY[CHUNK_SIZE * CHUNK_SIZE];   // Highest solid block per column, WORLD_MIN_Y - 1 if empty
+    int8_t maxTopY = WORLD_MIN_Y - 1;       // Highest entry of topY
+    uint8_t light[CHUNK_BLOCKS];            // Sky << 4 | block light, indexed by Index(); see VoxelLight.h
+    bool heightfield = true;                // Plain generated terrain: the seed light is all the light there is
+    bool modified = false;                  // Edited since it was generated or loaded, i.e. needs saving
+
+    static int Index(int lx, int ly, int lz) { return (ly * CHUNK_SIZE + lz) * CHUNK_SIZE + lx; }
+    uint8_t Get(int lx, int ly, int lz) const { return blocks.Get(Index(lx, ly, lz)); }
+    void Set(int lx, int ly, int lz, uint8_t block) { blocks.Set(Index(lx, ly, lz), block); }  // Leaves topY alone
+    int TopY(int lx, int lz) const { return topY[lz * CHUNK_SIZE + lx]; }
+    int OriginX() const { return coord.x * CHUNK_SIZE; }
+    int OriginZ() const { return coord.z * CHUNK_SIZE; }
+
+    // Rebuilds topY, maxTopY and the seed light from blocks, for chunks filled by hand.
+    void RecomputeTopY() {
+        uint8_t raw[CHUNK_BLOCKS];
+        blocks.Unpack(raw);
+        RecomputeTopY(raw);
+    }
+
+    // Same, from the chunk's blocks already unpacked in Index() order.
+    void RecomputeTopY(const uint8_t raw[CHUNK_BLOCKS]) {
+        maxTopY = WORLD_MIN_Y - 1;
+        for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+            for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                int ly = CHUNK_HEIGHT - 1;
+                while (ly >= 0 && !IsSolidBlock(raw[Index(lx, ly, lz)])) ly--;
+                topY[lz * CHUNK_SIZE + lx] = (int8_t)(ly + WORLD_MIN_Y);
+                maxTopY = std::max(maxTopY, topY[lz * CHUNK_SIZE + lx]);
+            }
+        }
+        SeedLight(raw);
+    }
+
+    // Open sky above every column top and each emitter's own level, nothing spread yet. Exact for
+    // a heightfield; anything else (caves, overhangs, lamps) needs a VoxelLighting pass.
+    void SeedLight(const uint8_t raw[CHUNK_BLOCKS]) {
+        bool exact = true;
+        for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+            for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                int topLy = TopY(lx, lz) - WORLD_MIN_Y;
+                for (int ly = 0; ly < CHUNK_HEIGHT; ly++) {
+                    int index = Index(lx, ly, lz);
+                    uint8_t block = raw[index];
+                    light[index] = (ly > topLy) ? LIGHT_OPEN_SKY : (uint8_t)BlockEmission(block);
+                    exact = exact && (ly > topLy || IsSolidBlock(block)) && BlockEmission(block) == 0;
+                }
+            }
+        }
+        heightfield = exact;
+    }
+};
+
+inline void GenerateChunk(const TerrainConfig& terrain, ChunkCoord coord, Chunk& chunk) {
+    chunk.coord = coord;
+    uint8_t raw[CHUNK_BLOCKS];
+    float heights[CHUNK_SIZE * CHUNK_SIZE];
+    GetTerrainHeights(terrain, (float)chunk.OriginX(), (float)chunk.OriginZ(), CHUNK_SIZE, CHUNK_SIZE, heights);
+
+    for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+        for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+            int stackHeight = (int)(heights[lz * CHUNK_SIZE + lx] - 1.0f);
+            stackHeight = std::min(stackHeight, WORLD_MAX_Y);
+
+            for (int ly = 0; ly < CHUNK_HEIGHT; ly++) {
+                int y = ly + WORLD_MIN_Y;
+                uint8_t block = BLOCK_AIR;
+                if (y == stackHeight) block = SurfaceBlockAt(y);
+                else if (y < stackHeight) block = FillBlockAt(y);
+                raw[Chunk::Index(lx, ly, lz)] = block;
+                chunk.light[Chunk::Index(lx, ly, lz)] = (y > stackHeight) ? LIGHT_OPEN_SKY : 0;
+            }
+            chunk.topY[lz * CHUNK_SIZE + lx] = (int8_t)std::max(stackHeight, WORLD_MIN_Y - 1);
+        }
+    }
+    chunk.maxTopY = *std::max_element(chunk.topY, chunk.topY + CHUNK_SIZE * CHUNK_SIZE);
+    chunk.heightfield = true;
+    chunk.blocks.Assign(raw);
+}
+
+// Chunk store keyed by chunk coordinate. Chunks are generated on first use and kept until the
+// cache grows past MaxChunks, at which point the ones farthest from the camera are dropped.
+class VoxelWorld {
+public:
+    TerrainConfig Terrain = { 0.0f, 0.0f };
+    size_t MaxChunks;
+
+    size_t ChunksGenerated = 0;
+    size_t ChunksEvicted = 0;
+
+    VoxelWorld(size_t maxChunks = 256) : MaxChunks(maxChunks) {}
+
+    void Reset(const TerrainConfig& terrain) {
+        Terrain = terrain;
+        m_Chunks.clear();
+        m_LastChunk = nullptr;
+    }
+
+    const Chunk* FindChunk(ChunkCoord coord) const {
+        if (m_LastChunk && m_LastChunk->coord == coord) return m_LastChunk;
+        auto it = m_Chunks.find(coord);
+        if (it == m_Chunks.end()) return nullptr;
+        m_LastChunk = it->second.get();
+        return m_LastChunk;
+    }
+
+    // Same as FindChunk() without the lookup cache, so several threads may call it at once as long
+    // as nobody modifies the world meanwhile.
+    const Chunk* LookupChunk(ChunkCoord coord) const {
+        auto it = m_Chunks.find(coord);
+        return (it == m_Chunks.end()) ? nullptr : it->second.get();
+    }
+
+    // Shared handle for background jobs, which keeps the chunk alive even if it is evicted meanwhile.
+    std::shared_ptr<const Chunk> FindChunkShared(ChunkCoord coord) const {
+        auto it = m_Chunks.find(coord);
+        return (it == m_Chunks.end()) ? nullptr : it->second;
+    }
+
+    // Generates synchronously on a miss. The frame loop uses FindChunk() and the ChunkBuilder instead.
+    const Chunk& GetChunk(ChunkCoord coord) {
+        if (const Chunk* chunk = FindChunk(coord)) return *chunk;
+        std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+        GenerateChunk(Terrain, coord, *chunk);
+        InsertChunk(chunk);
+        return *chunk;
+    }
+
+    // Adds a chunk generated elsewhere, e.g. on a worker thread.
+    void InsertChunk(std::shared_ptr<Chunk> chunk) {
+        ChunksGenerated++;
+        m_LastChunk = chunk.get();
+        m_Chunks[chunk->coord] = std::move(chunk);
+    }
+
+    uint8_t GetBlock(int x, int y, int z) {
+        if (y < WORLD_MIN_Y || y > WORLD_MAX_Y) return BLOCK_AIR;
+        const Chunk& chunk = GetChunk(ChunkCoordOf(x, z));
+        return chunk.Get(x - chunk.OriginX(), y - WORLD_MIN_Y, z - chunk.OriginZ());
+    }
+
+    // Changes one block of a loaded chunk and keeps its column tops current; the light around it is
+    // left to VoxelLighting::BlockChanged(). Returns false when nothing changed: chunk not loaded,
+    // y outside the world or same block.
+    bool SetBlock(int x, int y, int z, uint8_t block) {
+        if (y < WORLD_MIN_Y || y > WORLD_MAX_Y) return false;
+        ChunkCoord coord = ChunkCoordOf(x, z);
+        const Chunk* current = FindChunk(coord);
+        if (!current) return false;
+        int lx = x - current->OriginX(), ly = y - WORLD_MIN_Y, lz = z - current->OriginZ();
+        if (current->Get(lx, ly, lz) == block) return false;
+        Chunk& chunk = *EditChunk(coord);
+        chunk.Set(lx, ly, lz, block);
+        chunk.modified = true;
+        chunk.heightfield = false;
+
+        int8_t& top = chunk.topY[lz * CHUNK_SIZE + lx];
+        if (IsSolidBlock(block) && y > top) {
+            top = (int8_t)y;
+            chunk.maxTopY = std::max(chunk.maxTopY, top);
+        } else if (!IsSolidBlock(block) && y == top) {
+            int newTop = y - 1;
+            while (newTop >= WORLD_MIN_Y && !IsSolidBlock(chunk.Get(lx, newTop - WORLD_MIN_Y, lz))) newTop--;
+            bool wasHighest = (top == chunk.maxTopY);
+            top = (int8_t)newTop;
+            if (wasHighest) chunk.maxTopY = *std::max_element(chunk.topY, chunk.topY + CHUNK_SIZE * CHUNK_SIZE);
+        }
+        return true;
+    }
+
+    // Writable access to a loaded chunk, nullptr if it is not loaded. Meshing jobs may still be
+    // reading it, so a chunk anyone else holds is replaced by a copy first. Call from the thread
+    // that owns the world.
+    Chunk* EditChunk(ChunkCoord coord) {
+        auto it = m_Chunks.find(coord);
+        if (it == m_Chunks.end()) return nullptr;
+        std::shared_ptr<Chunk>& slot = it->second;
+        if (slot.use_count() > 1) {
+            slot = std::make_shared<Chunk>(*slot);
+            m_LastChunk = nullptr;
+        }
+        return slot.get();
+    }
+
+    int GetTopBlockY(int x, int z) {
+        const Chunk& chunk = GetChunk(ChunkCoordOf(x, z));
+        return chunk.TopY(x - chunk.OriginX(), z - chunk.OriginZ());
+    }
+
+    // Drop-in for GetTerrainHeight() on the collision path. Blocks are centred on integer
+    // coordinates, so the column under a point is the nearest integer one. Never generates:
+    // columns that are not loaded yet report a wall, so the player cannot walk into them.
+    float GetGroundHeight(float worldX, float worldZ) const {
+        int x = (int)floor(worldX + 0.5f);
+        int z = (int)floor(worldZ + 0.5f);
+        const Chunk* chunk = FindChunk(ChunkCoordOf(x, z));
+        if (!chunk) return (float)WORLD_MAX_Y + 2.0f;
+        return (float)chunk->TopY(x - chunk->OriginX(), z - chunk->OriginZ()) + 1.0f;
+    }
+
+    // Collision query that never generates. Unloaded chunks and everything below the world floor
+    // read as solid, everything above the top as air.
+    bool IsBlockSolid(int x, int y, int z) const {
+        if (y < WORLD_MIN_Y) return true;
+        if (y > WORLD_MAX_Y) return false;
+        const Chunk* chunk = FindChunk(ChunkCoordOf(x, z));
+        if (!chunk) return true;
+        return IsSolidBlock(chunk->Get(x - chunk->OriginX(), y - WORLD_MIN_Y, z - chunk->OriginZ()));
+    }
+
+    // Light stored at a block, see Chunk::light. Never generates: unloaded chunks and everything
+    // below the world floor are dark, everything above the top is open sky.
+    uint8_t GetLight(int x, int y, int z) const {
+        if (y < WORLD_MIN_Y) return 0;
+        if (y > WORLD_MAX_Y) return LIGHT_OPEN_SKY;
+        const Chunk* chunk = FindChunk(ChunkCoordOf(x, z));
+        if (!chunk) return 0;
+        return chunk->light[Chunk::Index(x - chunk->OriginX(), y - WORLD_MIN_Y, z - chunk->OriginZ())];
+    }
+
+    bool IsColumnLoaded(float worldX, float worldZ) const {
+        return FindChunk(ChunkCoordOf((int)floor(worldX + 0.5f), (int)floor(worldZ + 0.5f))) != nullptr;
+    }
+
+    // Evicts the chunks farthest from (camX, camZ) until the cache fits in MaxChunks. Evicted chunks
+    // that were modified are appended to unsaved, if given, so the caller can write them out.
+    void EvictFarthest(float camX, float camZ, std::vector<std::shared_ptr<Chunk>>* unsaved = nullptr) {
+        if (m_Chunks.size() <= MaxChunks) return;
+
+        float camChunkX = camX / CHUNK_SIZE;
+        float camChunkZ = camZ / CHUNK_SIZE;
+        std::vector<std::pair<float, ChunkCoord>> byDistance;
+        byDistance.reserve(m_Chunks.size());
+        for (auto& entry : m_Chunks) {
+            float dx = entry.first.x + 0.5f - camChunkX;
+            float dz = entry.first.z + 0.5f - camChunkZ;
+            byDistance.push_back({ dx * dx + dz * dz, entry.first });
+        }
+        size_t excess = m_Chunks.size() - MaxChunks;
+        std::nth_element(byDistance.begin(), byDistance.begin() + excess, byDistance.end(),
+            [](const std::pair<float, ChunkCoord>& a, const std::pair<float, ChunkCoord>& b) { return a.first > b.first; });
+        for (size_t i = 0; i < excess; i++) {
+            auto it = m_Chunks.find(byDistance[i].second);
+            if (unsaved && it->second->modified) unsaved->push_back(it->second);
+            m_Chunks.erase(it);
+        }
+
+        ChunksEvicted += excess;
+        m_LastChunk = nullptr;
+    }
+
+    // Drops one chunk and hands it back, e.g. to save it; nullptr if it was not loaded.
+    std::shared_ptr<Chunk> RemoveChunk(ChunkCoord coord) {
+        auto it = m_Chunks.find(coord);
+        if (it == m_Chunks.end()) return nullptr;
+        std::shared_ptr<Chunk> chunk = std::move(it->second);
+        m_Chunks.erase(it);
+        ChunksEvicted++;
+        m_LastChunk = nullptr;
+        return chunk;
+    }
+
+    size_t ChunkCount() const { return m_Chunks.size(); }
+
+    template <typename Fn>
+    void ForEachChunk(Fn fn) const {
+        for (const auto& entry : m_Chunks) fn(entry.second);
+    }
+
+    // Bytes held by block storage across all resident chunks.
+    size_t BlockMemoryBytes() const {
+        size_t bytes = 0;
+        for (const auto& entry : m_Chunks) bytes += entry.second->blocks.MemoryBytes();
+        return bytes;
+    }
+
+    // Bytes held by resident chunks altogether: block storage plus light and column tops.
+    size_t ChunkMemoryBytes() const {
+        return BlockMemoryBytes() + m_Chunks.size() * (sizeof(Chunk) - sizeof(PalettedBlocks));
+    }
+
+private:
+    std::unordered_map<ChunkCoord, std::shared_ptr<Chunk>, ChunkCoordHash> m_Chunks;
+    mutable const Chunk* m_LastChunk = nullptr;
+};
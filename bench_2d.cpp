@@ -0,0 +1,546 @@
+// Headless benchmarks for the GalleDodge game code. No window or GPU needed; ImGui runs without a
+// backend for the sprite section:
+//   g++ -O2 -std=gnu++17 bench_2d.cpp imgui.cpp imgui_draw.cpp imgui_tables.cpp imgui_widgets.cpp -o bench_2d.exe
+//   bench_2d.exe            (runs everything)
+//   bench_2d.exe swarm      (runs one section)
+#include "EnemySwarm.h"
+#include "SpatialGrid.h"
+#include "GalleDodgeSim.h"
+#include "DodgeRunner.h"
+#include "FixedTimestep.h"
+#include "CircleSprite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <new>
+#include <vector>
+
+// Every heap allocation in the process goes through here, so a section can count them. Worker
+// threads allocate too, hence the atomic. Kept out of line: once GCC inlines them it sees malloc()
+// paired with operator delete, or operator new with free(), and warns about a mismatch.
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+static std::atomic<uint64_t> g_Allocations{ 0 };
+BENCH_NOINLINE void* operator new(size_t size) {
+    g_Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+BENCH_NOINLINE void operator delete(void* p) noexcept { free(p); }
+BENCH_NOINLINE void operator delete(void* p, size_t) noexcept { free(p); }
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Same arena as the game window at its default size, player in the middle.
+static SwarmArena BenchArena() {
+    SwarmArena arena;
+    arena.width = 960.0f; arena.height = 600.0f; arena.margin = 100.0f;
+    arena.playerX = 480.0f; arena.playerY = 300.0f;
+    arena.hitRadius = 30.0f * 0.4f + 20.0f;
+    return arena;
+}
+
+struct BenchRng {
+    unsigned int state;
+    explicit BenchRng(unsigned int seed) : state(seed) {}
+    float Next01() { state = state * 1664525u + 1013904223u; return (float)(state >> 8) / (float)(1 << 24); }
+};
+
+// An enemy somewhere in the arena heading at 500 px/s in a random direction, like the ones the game
+// spawns at the edges a moment later.
+static void AddRandomEnemy(EnemySwarm& swarm, const SwarmArena& arena, BenchRng& rng) {
+    float angle = rng.Next01() * 6.2831853f;
+    swarm.Add(rng.Next01() * arena.width, rng.Next01() * arena.height, cosf(angle) * 500.0f, sinf(angle) * 500.0f);
+}
+
+// The enemy loop main.cpp had before EnemySwarm: array of structs, sqrt per enemy and an erase
+// from the middle of the vector for every enemy that leaves.
+struct OldEnemy { float x, y, vx, vy; };
+static SwarmStepResult OldStepEnemies(std::vector<OldEnemy>& enemies, float dt, const SwarmArena& arena) {
+    SwarmStepResult result;
+    for (int i = (int)enemies.size() - 1; i >= 0; i--) {
+        enemies[i].x += enemies[i].vx * dt;
+        enemies[i].y += enemies[i].vy * dt;
+        float dx = arena.playerX - enemies[i].x, dy = arena.playerY - enemies[i].y;
+        if (sqrtf(dx * dx + dy * dy) < arena.hitRadius) result.playerHit = true;
+        if (enemies[i].x < -arena.margin || enemies[i].x > arena.width + arena.margin ||
+            enemies[i].y < -arena.margin || enemies[i].y > arena.height + arena.margin) {
+            result.escaped++;
+            enemies.erase(enemies.begin() + i);
+        }
+    }
+    return result;
+}
+
+// Steps the SoA swarm against the old loop until everyone has left and compares the survivors
+// (as sorted sets, since swap-and-pop reorders), escapes and hits each frame. Then times a frame
+// in which half of 20k enemies leave at once, and the steady state at a million enemies, topping
+// the swarm back up after every step so the count stays put.
+static void BenchSwarm() {
+    SwarmArena arena = BenchArena();
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[swarm] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const float dt = 1.0f / 60.0f;
+
+    BenchRng rng(7);
+    EnemySwarm swarm;
+    std::vector<OldEnemy> old;
+    for (int i = 0; i < 5003; i++) {
+        AddRandomEnemy(swarm, arena, rng);
+        old.push_back({ swarm.x[i], swarm.y[i], swarm.vx[i], swarm.vy[i] });
+    }
+    int frameMismatches = 0, frames = 0, hits = 0;
+    auto sortedState = [](std::vector<OldEnemy> v) {
+        std::sort(v.begin(), v.end(), [](const OldEnemy& a, const OldEnemy& b) { return memcmp(&a, &b, sizeof(a)) < 0; });
+        return v;
+    };
+    while (!old.empty() || swarm.Count() > 0) {
+        SwarmStepResult a = StepEnemies(swarm, dt, arena), b = OldStepEnemies(old, dt, arena);
+        std::vector<OldEnemy> now;
+        for (size_t i = 0; i < swarm.Count(); i++) now.push_back({ swarm.x[i], swarm.y[i], swarm.vx[i], swarm.vy[i] });
+        std::vector<OldEnemy> x = sortedState(now), y = sortedState(old);
+        bool same = a.playerHit == b.playerHit && a.escaped == b.escaped && x.size() == y.size() &&
+                    (x.empty() || memcmp(x.data(), y.data(), x.size() * sizeof(OldEnemy)) == 0);
+        if (!same) frameMismatches++;
+        hits += a.playerHit;
+        if (++frames > 1000) break;
+    }
+    printf("[swarm] 5003 enemies against the old loop: %d frames until all escaped, %d frames with a hit\n", frames, hits);
+
+    // Half of 20k leave in the same frame: the old loop erases 10k times from the middle.
+    const int burst = 20000;
+    EnemySwarm burstSwarm;
+    std::vector<OldEnemy> burstOld;
+    for (int i = 0; i < burst; i++) {
+        float x = (i & 1) ? arena.width + arena.margin - 1.0f : arena.width * 0.5f;
+        burstSwarm.Add(x, 10.0f, 500.0f, 0.0f);
+        burstOld.push_back({ x, 10.0f, 500.0f, 0.0f });
+    }
+    double start = NowSeconds();
+    SwarmStepResult burstNew = StepEnemies(burstSwarm, dt, arena);
+    double newBurstMs = (NowSeconds() - start) * 1000.0;
+    start = NowSeconds();
+    SwarmStepResult burstOldResult = OldStepEnemies(burstOld, dt, arena);
+    double oldBurstMs = (NowSeconds() - start) * 1000.0;
+    printf("[swarm] %d enemies, %d leaving in one frame: SoA %.3f ms, old loop %.1f ms\n", burst, burstNew.escaped, newBurstMs, oldBurstMs);
+
+    // Steady state at a million.
+    const int million = 1000000, steps = 120;
+    EnemySwarm big;
+    for (int i = 0; i < million; i++) AddRandomEnemy(big, arena, rng);
+    std::vector<double> stepMs;
+    long long escaped = 0;
+    for (int s = 0; s < steps; s++) {
+        start = NowSeconds();
+        escaped += StepEnemies(big, dt, arena).escaped;
+        stepMs.push_back((NowSeconds() - start) * 1000.0);
+        while ((int)big.Count() < million) AddRandomEnemy(big, arena, rng);
+    }
+    std::sort(stepMs.begin(), stepMs.end());
+    double median = stepMs[steps / 2], worst = stepMs.back();
+#if defined(__AVX__)
+    const char* isa = "AVX";
+#elif defined(SWARM_SIMD)
+    const char* isa = "SSE";
+#else
+    const char* isa = "scalar";
+#endif
+    printf("[swarm] 1M enemies (%s): step p50 %.2f ms, max %.2f ms, %.0f M enemies/s, %.1f escapes per frame\n",
+        isa, median, worst, million / median / 1000.0, (double)escaped / steps);
+
+    check("matches the old loop every frame", frameMismatches == 0 && frames <= 1000);
+    check("the test swarm hit the player at least once", hits > 0);
+    check("burst frame removes the same enemies as the old loop", burstNew.escaped == burstOldResult.escaped && burstNew.escaped == burst / 2);
+    check("1M enemies step within a 60 Hz frame on one core", median < 1000.0 / 60.0);
+    printf("[swarm] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Builds the grid over 1k to 1M random points spread over the arena and its margins, runs 1000
+// circle queries of the player's hit radius and 1000 64x64 box queries, and compares their results
+// with brute force over every point, then reports build and per-query times against brute force.
+// 1000 queries per frame stand in for projectiles or several players, the O(n*m) case.
+static void BenchGrid() {
+    SwarmArena arena = BenchArena();
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[grid] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const float minX = -arena.margin, minY = -arena.margin, maxX = arena.width + arena.margin, maxY = arena.height + arena.margin;
+    const float cellSize = 40.0f; // Enemy diameter
+    const int queries = 1000;
+
+    int wrong = 0;
+    double buildMs[4] = {}, circleUs[4] = {}, bruteUs[4] = {};
+    const int sizes[4] = { 1000, 10000, 100000, 1000000 };
+    for (int s = 0; s < 4; s++) {
+        int n = sizes[s];
+        BenchRng rng(11 + s);
+        std::vector<float> x(n), y(n);
+        for (int i = 0; i < n; i++) { x[i] = minX + rng.Next01() * (maxX - minX); y[i] = minY + rng.Next01() * (maxY - minY); }
+        std::vector<float> qx(queries), qy(queries);
+        for (int q = 0; q < queries; q++) { qx[q] = minX + rng.Next01() * (maxX - minX); qy[q] = minY + rng.Next01() * (maxY - minY); }
+
+        SpatialGrid grid;
+        const int builds = 9;
+        std::vector<double> times;
+        for (int b = 0; b < builds; b++) {
+            double start = NowSeconds();
+            grid.Build(x.data(), y.data(), n, minX, minY, maxX, maxY, cellSize);
+            times.push_back(NowSeconds() - start);
+        }
+        std::sort(times.begin(), times.end());
+        buildMs[s] = times[builds / 2] * 1000.0;
+
+        long long circleHits = 0, boxHits = 0;
+        double start = NowSeconds();
+        for (int q = 0; q < queries; q++) grid.QueryCircle(qx[q], qy[q], arena.hitRadius, [&circleHits](uint32_t) { circleHits++; });
+        circleUs[s] = (NowSeconds() - start) * 1e6 / queries;
+        start = NowSeconds();
+        for (int q = 0; q < queries; q++) grid.QueryAabb(qx[q] - 32.0f, qy[q] - 32.0f, qx[q] + 32.0f, qy[q] + 32.0f, [&boxHits](uint32_t) { boxHits++; });
+        double boxUs = (NowSeconds() - start) * 1e6 / queries;
+
+        // Brute force on as many queries as fit in ~1e8 point tests, results compared as sorted sets.
+        int checked = std::max(10, std::min(queries, 100000000 / n));
+        std::vector<uint32_t> fromGrid, fromBrute;
+        double bruteTime = 0.0;
+        for (int q = 0; q < checked; q++) {
+            fromGrid.clear(); fromBrute.clear();
+            float r2 = arena.hitRadius * arena.hitRadius;
+            start = NowSeconds();
+            for (int i = 0; i < n; i++) {
+                float dx = x[i] - qx[q], dy = y[i] - qy[q];
+                if (dx * dx + dy * dy < r2) fromBrute.push_back((uint32_t)i);
+            }
+            bruteTime += NowSeconds() - start;
+            grid.QueryCircle(qx[q], qy[q], arena.hitRadius, [&fromGrid](uint32_t i) { fromGrid.push_back(i); });
+            std::sort(fromGrid.begin(), fromGrid.end());
+            if (fromGrid != fromBrute || grid.AnyInCircle(qx[q], qy[q], arena.hitRadius) != !fromBrute.empty()) wrong++;
+
+            fromGrid.clear(); fromBrute.clear();
+            float b0x = qx[q] - 32.0f, b0y = qy[q] - 32.0f, b1x = qx[q] + 32.0f, b1y = qy[q] + 32.0f;
+            for (int i = 0; i < n; i++) if (x[i] >= b0x && x[i] <= b1x && y[i] >= b0y && y[i] <= b1y) fromBrute.push_back((uint32_t)i);
+            grid.QueryAabb(b0x, b0y, b1x, b1y, [&fromGrid](uint32_t i) { fromGrid.push_back(i); });
+            std::sort(fromGrid.begin(), fromGrid.end());
+            if (fromGrid != fromBrute) wrong++;
+        }
+        bruteUs[s] = bruteTime * 1e6 / checked;
+
+        printf("[grid] %7d points, %dx%d cells: build %.3f ms; per query: circle %.2f us (%.1f hits), box %.2f us (%.1f hits), brute-force circle %.1f us, %.0fx\n",
+            n, grid.Columns(), grid.Rows(), buildMs[s], circleUs[s], (double)circleHits / queries, boxUs, (double)boxHits / queries,
+            bruteUs[s], bruteUs[s] / circleUs[s]);
+    }
+
+    // An unbuilt grid finds nothing; NaN points and queries stay in range and find nothing spurious.
+    SpatialGrid empty;
+    int unbuiltHits = 0;
+    empty.QueryCircle(0.0f, 0.0f, 100.0f, [&unbuiltHits](uint32_t) { unbuiltHits++; });
+    empty.QueryAabb(-100.0f, -100.0f, 100.0f, 100.0f, [&unbuiltHits](uint32_t) { unbuiltHits++; });
+    if (empty.AnyInCircle(0.0f, 0.0f, 100.0f)) unbuiltHits++;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float oddX[3] = { 100.0f, nan, 300.0f }, oddY[3] = { 100.0f, 200.0f, nan };
+    SpatialGrid odd;
+    odd.Build(oddX, oddY, 3, minX, minY, maxX, maxY, cellSize);
+    std::vector<uint32_t> oddHits;
+    odd.QueryCircle(100.0f, 100.0f, 10.0f, [&oddHits](uint32_t i) { oddHits.push_back(i); });
+    odd.QueryCircle(nan, 0.0f, 10.0f, [&oddHits](uint32_t i) { oddHits.push_back(i); });
+    odd.QueryAabb(nan, nan, 1e30f, 1e30f, [&oddHits](uint32_t i) { oddHits.push_back(i); });
+
+    check("circle and box queries match brute force at every size", wrong == 0);
+    check("queries before Build() find nothing", unbuiltHits == 0);
+    check("NaN points and queries match nothing else", oddHits.size() == 1 && oddHits[0] == 0 && !odd.AnyInCircle(nan, nan, 10.0f));
+    // 10k points fit in cache, 1M do not, so compare against 100k and allow 3x per point.
+    check("build time grows about linearly from 100k to 1M", buildMs[3] < buildMs[2] * 10.0 * 3.0);
+    check("1M points: circle queries beat brute force by 10x", bruteUs[3] > circleUs[3] * 10.0);
+    check("10k points: build plus 1000 circle queries under 1 ms", buildMs[1] + circleUs[1] * queries / 1000.0 < 1.0);
+    printf("[grid] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Runs games back to back until `tickCount` ticks have been stepped, seeding game g with g + 1, and
+// hashes every final score and position in order. One random bot plays them all.
+struct DodgeRun {
+    uint64_t hash = 14695981039346656037ull;
+    int games = 0;
+    long long totalScore = 0;
+    int bestScore = 0;
+};
+static void HashDodge(DodgeRun& run, const DodgeGame& game) {
+    uint32_t words[3] = { (uint32_t)game.score, 0, 0 };
+    memcpy(&words[1], &game.posX, 4);
+    memcpy(&words[2], &game.posY, 4);
+    const unsigned char* bytes = (const unsigned char*)words;
+    for (size_t i = 0; i < sizeof(words); i++) run.hash = (run.hash ^ bytes[i]) * 1099511628211ull;
+}
+static void FinishDodge(DodgeRun& run, const DodgeGame& game) {
+    HashDodge(run, game);
+    run.games++;
+    run.totalScore += game.score;
+    run.bestScore = std::max(run.bestScore, game.score);
+}
+static DodgeRun RunDodgeGames(DodgeGame& game, uint64_t tickCount, float dt) {
+    DodgeRun run;
+    DodgeBotMemory bot;
+    game.Reset(1);
+    for (uint64_t tick = 0; tick < tickCount; tick++) {
+        StepDodge(game, DodgeRandomPolicy(game, bot), dt);
+        if (game.over) {
+            FinishDodge(run, game);
+            game.Reset((uint32_t)run.games + 1);
+        }
+    }
+    return run;
+}
+
+// The headless game: checks the sprint and spawn rules against the numbers main.cpp had, replays
+// the same seeds twice and once through a FixedTimestep fed random frame lengths (all three must
+// hash the same), then times millions of random-bot ticks and counts heap allocations per tick.
+static void BenchSim() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[sim] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const float dt = 1.0f / 120.0f;
+    DodgeGame game;
+
+    // Sprint from rest until overheated, then count the cooldown. Enemies are cleared every tick
+    // so nothing ends the game.
+    game.Reset(1);
+    int sprintTicks = 0, cooldownTicks = 0;
+    while (game.cooldownTimer <= 0.0f && sprintTicks < 10000) { StepDodge(game, DODGE_RIGHT | DODGE_SPRINT, dt); game.enemies.Clear(); sprintTicks++; }
+    while (game.cooldownTimer > 0.0f && cooldownTicks < 10000) { StepDodge(game, DODGE_RIGHT | DODGE_SPRINT, dt); game.enemies.Clear(); cooldownTicks++; }
+    printf("[sim] sprint lasts %d ticks (%.3f s), cooldown %d ticks (%.3f s)\n", sprintTicks, sprintTicks * dt, cooldownTicks, cooldownTicks * dt);
+
+    // Spawn rate: one spawn every spawnRate seconds, 2% faster each time, never below 0.2 s.
+    game.Reset(1);
+    int spawns = 0, spawnsToFloor = 0;
+    bool rateOk = true;
+    for (int tick = 0; tick < 120 * 600; tick++) {
+        float before = game.spawnRate;
+        StepDodge(game, 0, dt);
+        if (game.enemies.Count() > 0) {
+            spawns++;
+            float expected = std::max(before * SPAWN_RATE_DECAY, MIN_SPAWN_RATE);
+            rateOk = rateOk && game.spawnRate == expected;
+            if (game.spawnRate == MIN_SPAWN_RATE && spawnsToFloor == 0) spawnsToFloor = spawns;
+        }
+        game.enemies.Clear();
+    }
+    printf("[sim] %d spawns in 600 s, spawn rate reaches %.2f s after %d spawns\n", spawns, MIN_SPAWN_RATE, spawnsToFloor);
+
+    // Replays.
+    const uint64_t replayTicks = 200000;
+    DodgeRun first = RunDodgeGames(game, replayTicks, dt);
+    DodgeRun second = RunDodgeGames(game, replayTicks, dt);
+    DodgeRun framed;
+    {
+        FixedTimestep clock(dt);
+        unsigned int rng = 99;
+        DodgeBotMemory bot;
+        uint64_t tick = 0;
+        game.Reset(1);
+        while (tick < replayTicks) {
+            rng = rng * 1664525u + 1013904223u;
+            int ticks = clock.Advance(0.001f + (float)(rng >> 8) / (float)(1 << 24) * 0.05f); // 1 ms to 51 ms frames
+            for (int i = 0; i < ticks && tick < replayTicks; i++, tick++) {
+                StepDodge(game, DodgeRandomPolicy(game, bot), clock.Step);
+                if (game.over) {
+                    FinishDodge(framed, game);
+                    game.Reset((uint32_t)framed.games + 1);
+                }
+            }
+        }
+    }
+    printf("[sim] %llu ticks replayed: %d games, hash %016llx / %016llx / %016llx (variable frames)\n", (unsigned long long)replayTicks,
+        first.games, (unsigned long long)first.hash, (unsigned long long)second.hash, (unsigned long long)framed.hash);
+
+    // Throughput. The first run above already grew the enemy arrays, so this one should not allocate.
+    const uint64_t tickCount = 5000000;
+    uint64_t allocationsBefore = g_Allocations.load(std::memory_order_relaxed);
+    double start = NowSeconds();
+    DodgeRun run = RunDodgeGames(game, tickCount, dt);
+    double elapsed = NowSeconds() - start;
+    uint64_t allocations = g_Allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    printf("[sim] %llu random-bot ticks: %.1f M ticks/s, %.3f us/tick, %d games, mean score %.1f, best %d, %.6f allocations/tick\n",
+        (unsigned long long)tickCount, tickCount / elapsed / 1e6, elapsed * 1e6 / tickCount, run.games,
+        run.games ? (double)run.totalScore / run.games : 0.0, run.bestScore, (double)allocations / tickCount);
+
+    // Summing dt in floats can land just short of the limit, costing one extra tick.
+    check("sprint overheats after MAX_SPRINT_TIME", fabsf(sprintTicks * dt - MAX_SPRINT_TIME) <= dt * 1.5f);
+    check("cooldown lasts COOLDOWN_TIME", fabsf(cooldownTicks * dt - COOLDOWN_TIME) <= dt * 1.5f);
+    check("spawn rate decays 2% per spawn down to MIN_SPAWN_RATE", rateOk && spawnsToFloor > 0 && game.spawnRate >= MIN_SPAWN_RATE);
+    check("same seeds and inputs replay bit for bit", first.games > 0 && first.hash == second.hash);
+    check("random frame lengths through FixedTimestep replay the same", first.hash == framed.hash && first.games == framed.games);
+    check("no heap allocations once the enemy arrays have grown", allocations == 0);
+    printf("[sim] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Plays the same seeds with the random and the fleeing policy serially and on 2, 4, ... threads up
+// to the core count, checks every thread count gives the same per-seed results, prints both score
+// distributions and the throughput per thread count.
+static void BenchRunner() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[runner] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const float dt = 1.0f / 120.0f;
+    const uint64_t maxTicks = 120 * 600;
+    const int games = 4000;
+    int cores = std::max(1, (int)std::thread::hardware_concurrency());
+
+    struct Policy { const char* name; DodgePolicy fn; DodgeScoreStats stats; };
+    Policy policies[2] = { { "random", DodgeRandomPolicy, {} }, { "flee", DodgeFleePolicy, {} } };
+    bool sameEverywhere = true;
+    double efficiency = 1.0;    // Speedup per thread at the most threads that fit the cores, worst policy
+    for (Policy& policy : policies) {
+        std::vector<DodgeResult> serial(games);
+        DodgeGame game;
+        double start = NowSeconds();
+        for (int i = 0; i < games; i++) serial[i] = PlayDodge(game, 1 + (uint32_t)i, policy.fn, dt, maxTicks);
+        double serialSeconds = NowSeconds() - start;
+        policy.stats = SummarizeDodge(serial, dt);
+        const DodgeScoreStats& st = policy.stats;
+        printf("[runner] %-6s %d games: score mean %.1f sd %.1f, min %d p10 %d median %d p90 %d max %d, %.1f s per game\n",
+            policy.name, st.games, st.mean, st.stddev, st.minScore, st.p10, st.median, st.p90, st.maxScore, st.meanSeconds);
+        printf("[runner] %-6s  1 thread : %.1f M ticks/s\n", policy.name, st.ticks / serialSeconds / 1e6);
+
+        for (int threads = 2; threads <= std::max(2, cores); threads *= 2) {
+            JobSystem jobs(threads - 1);    // The calling thread plays too
+            std::vector<DodgeResult> parallel;
+            start = NowSeconds();
+            RunDodgeSeeds(jobs, 1, games, policy.fn, dt, maxTicks, parallel);
+            double seconds = NowSeconds() - start;
+            for (int i = 0; i < games; i++)
+                sameEverywhere = sameEverywhere && parallel[i].seed == serial[i].seed && parallel[i].score == serial[i].score && parallel[i].ticks == serial[i].ticks;
+            printf("[runner] %-6s %2d threads: %.1f M ticks/s, %.2fx\n", policy.name, threads, st.ticks / seconds / 1e6, serialSeconds / seconds);
+            if (threads <= cores && threads * 2 > cores) efficiency = std::min(efficiency, serialSeconds / seconds / threads);
+        }
+    }
+
+    check("every thread count gives the same per-seed results", sameEverywhere);
+    check("the fleeing policy outscores the random one", policies[1].stats.mean > policies[0].stats.mean);
+    if (cores < 2) printf("[runner] only one core here, so scaling cannot be measured\n");
+    else check("throughput scales near-linearly with the core count", efficiency >= 0.7);
+    printf("[runner] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Draws 100k enemy circles into a headless ImGui frame with AddCircleFilled() and with the atlas
+// sprite, checks the baked texels and the vertex and draw command counts, and times both paths.
+static void BenchSprites() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[sprites] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;                                   // Leave the game's imgui.ini alone
+    io.DisplaySize = ImVec2(960.0f, 600.0f);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;   // Texture uploads are requested and never done
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // As the DX11 backend: over 64k vertices start a new command
+
+    SwarmArena arena = BenchArena();
+    BenchRng rng(11);
+    EnemySwarm swarm;
+    const int circles = 100000, frames = 5;
+    for (int i = 0; i < circles; i++) AddRandomEnemy(swarm, arena, rng);
+    const ImU32 red = IM_COL32(255, 0, 0, 255);
+
+    CircleSprite sprite;
+    bool texelsMatch = false;
+    double filledMs[frames], spriteMs[frames];
+    int filledVtx = 0, filledCmds = 0, spriteVtx = 0, spriteIdx = 0, spriteCmds = 0;
+    for (int frame = 0; frame < frames * 2; frame++) {
+        ImGui::NewFrame();
+        if (!sprite.IsBaked()) {
+            sprite.Bake(io.Fonts);
+            // Read the rectangle back through its UVs, the way the quads will sample it.
+            ImTextureData* tex = io.Fonts->TexData;
+            ImVec2 uv0, uv1;
+            texelsMatch = sprite.GetUv(uv0, uv1);
+            int x0 = (int)(uv0.x * tex->Width + 0.5f), y0 = (int)(uv0.y * tex->Height + 0.5f);
+            for (int y = 0; y < CircleSprite::kSize; y++)
+                for (int x = 0; x < CircleSprite::kSize; x++) {
+                    const void* texel = tex->GetPixelsAt(x0 + x, y0 + y);
+                    unsigned char alpha = tex->Format == ImTextureFormat_Alpha8 ? *(const ImU8*)texel : (unsigned char)(*(const ImU32*)texel >> IM_COL32_A_SHIFT);
+                    texelsMatch = texelsMatch && alpha == CircleSprite::Coverage(x, y);
+                }
+        }
+        ImDrawList* drawList = ImGui::GetBackgroundDrawList();
+        int cmdsBefore = drawList->CmdBuffer.Size, vtxBefore = drawList->VtxBuffer.Size, idxBefore = drawList->IdxBuffer.Size;
+        bool useSprites = frame % 2 == 1;
+        double start = NowSeconds();
+        if (useSprites) AddCircleSprites(drawList, sprite, swarm.x.data(), swarm.y.data(), swarm.Count(), ENEMY_RADIUS, red);
+        else for (int i = 0; i < circles; i++) drawList->AddCircleFilled(ImVec2(swarm.x[i], swarm.y[i]), ENEMY_RADIUS, red);
+        double ms = (NowSeconds() - start) * 1000.0;
+        if (useSprites) {
+            spriteMs[frame / 2] = ms;
+            spriteVtx = drawList->VtxBuffer.Size - vtxBefore;
+            spriteIdx = drawList->IdxBuffer.Size - idxBefore;
+            spriteCmds = drawList->CmdBuffer.Size - cmdsBefore + 1;
+        } else {
+            filledMs[frame / 2] = ms;
+            filledVtx = drawList->VtxBuffer.Size - vtxBefore;
+            filledCmds = drawList->CmdBuffer.Size - cmdsBefore + 1;
+        }
+        ImGui::Render();
+    }
+    ImGui::DestroyContext();
+
+    std::sort(filledMs, filledMs + frames);
+    std::sort(spriteMs, spriteMs + frames);
+    printf("[sprites] %d circles, AddCircleFilled: %.2f ms, %.1f vertices per circle, %d draw commands\n",
+        circles, filledMs[frames / 2], (double)filledVtx / circles, filledCmds);
+    printf("[sprites] %d circles, atlas sprite:    %.2f ms, %.1f vertices per circle, %d draw commands, %.1fx faster\n",
+        circles, spriteMs[frames / 2], (double)spriteVtx / circles, spriteCmds, filledMs[frames / 2] / spriteMs[frames / 2]);
+
+    check("baked texels match the disc's coverage", texelsMatch);
+    check("4 vertices and 6 indices per circle", spriteVtx == circles * 4 && spriteIdx == circles * 6);
+    check("one draw command per 16k circles", spriteCmds <= (circles + 16382) / 16383);
+    check("sprites draw faster than AddCircleFilled", spriteMs[frames / 2] < filledMs[frames / 2]);
+    printf("[sprites] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+struct BenchEntry {
+    const char* name;
+    void (*fn)();
+};
+
+static const BenchEntry kBenches[] = {
+    { "swarm", BenchSwarm },
+    { "grid", BenchGrid },
+    { "sim", BenchSim },
+    { "runner", BenchRunner },
+    { "sprites", BenchSprites },
+};
+
+int main(int argc, char** argv) {
+    bool ranAny = false;
+    for (const BenchEntry& bench : kBenches) {
+        if (argc > 1 && strcmp(argv[1], bench.name) != 0) continue;
+        bench.fn();
+        ranAny = true;
+    }
+    if (!ranAny) {
+        printf("Unknown benchmark '%s'. Available:", argv[1]);
+        for (const BenchEntry& bench : kBenches) printf(" %s", bench.name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,2020 @@
+// Headless benchmarks for the 3DEngine world code. No window, GPU or ImGui needed:
+//   g++ -O2 -std=gnu++17 bench_3d.cpp -o bench_3d.exe
+//   bench_3d.exe            (runs everything)
+//   bench_3d.exe mesher     (runs one section)
+#include "VoxelWorld.h"
+#include "ChunkMesher.h"
+#include "Frustum.h"
+#include "ChunkBuilder.h"
+#include "LodMesher.h"
+#include "OcclusionCuller.h"
+#include "VoxelPhysics.h"
+#include "FixedTimestep.h"
+#include "VoxelRaycast.h"
+#include "RegionFile.h"
+#include "DirtyChunks.h"
+#include "SoftwareRasterizer.h"
+#include "CameraMath.h"
+#include "VoxelLight.h"
+#include "ChunkStreamer.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static TerrainConfig BenchTerrainConfig() { return { 42.0f, 17.5f }; }
+
+// Meshes a square of chunks and compares against what the old per-block renderer would have drawn.
+// Also checks that the merged quads cover exactly the faces the hidden-face pass kept.
+static void BenchMesher() {
+    const int radius = 4;
+    VoxelWorld world(1024);
+    world.Reset(BenchTerrainConfig());
+    for (int cx = -radius - 1; cx <= radius; cx++)
+        for (int cz = -radius - 1; cz <= radius; cz++) world.GetChunk({ cx, cz });
+
+    ChunkMesh mesh;
+    long long quads = 0, vertices = 0, kept = 0, culled = 0;
+    double coveredArea = 0.0;
+    int chunks = 0;
+    double start = NowSeconds();
+    for (int cx = -radius; cx < radius; cx++) {
+        for (int cz = -radius; cz < radius; cz++) {
+            MeshChunk(GetNeighborhood(world, { cx, cz }), mesh);
+            quads += mesh.quadCount;
+            vertices += (long long)mesh.vertices.size();
+            kept += mesh.cull.facesKept;
+            culled += mesh.cull.facesCulled;
+            for (size_t i = 0; i < mesh.vertices.size(); i += 6) {
+                const Vertex& a = mesh.vertices[i]; const Vertex& b = mesh.vertices[i + 1]; const Vertex& c = mesh.vertices[i + 2];
+                float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+                float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+                float cxp = uy * vz - uz * vy, cyp = uz * vx - ux * vz, czp = ux * vy - uy * vx;
+                coveredArea += sqrt(cxp * cxp + cyp * cyp + czp * czp);
+            }
+            chunks++;
+        }
+    }
+    double elapsed = NowSeconds() - start;
+
+    long long blocks = (kept + culled) / 6;
+    printf("[mesher] %d chunks, %lld solid blocks (old path: %lld draw calls, %lld vertices)\n", chunks, blocks, blocks, blocks * 36);
+    printf("[mesher] hidden-face pass: %lld faces kept, %lld culled (%.1f%% culled)\n", kept, culled, 100.0 * culled / (kept + culled));
+    printf("[mesher] greedy quads %lld, %lld vertices, %d draw calls\n", quads, vertices, chunks);
+    printf("[mesher] %.3f ms/chunk, area check %s (%.0f vs %lld)\n", elapsed * 1000.0 / chunks,
+        (long long)(coveredArea + 0.5) == kept ? "OK" : "MISMATCH", coveredArea, kept);
+}
+
+// Ambient occlusion: every corner of every merged quad against the three-neighbour rule evaluated
+// straight on the world, including corners on chunk borders and in chunk corners, and the cost of
+// the extra pass against meshing without it.
+static void BenchAo() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[ao] %-56s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const int radius = 4;
+    VoxelWorld world(1024);
+    world.Reset(BenchTerrainConfig());
+    for (int cx = -radius - 1; cx <= radius; cx++)
+        for (int cz = -radius - 1; cz <= radius; cz++) world.GetChunk({ cx, cz });
+    // A pillar in a chunk corner column and an overhang across the chunk corner, so the diagonal
+    // neighbours matter; the overhang shades the ground under it, so smooth light varies there too.
+    VoxelLighting lighting;
+    int pillarBase = world.GetTopBlockY(-1, -1);
+    for (int y = pillarBase + 1; y < pillarBase + 4; y++)
+        if (world.SetBlock(-1, y, -1, BLOCK_STONE)) lighting.BlockChanged(-1, y, -1);
+    int roof = std::max(std::max(world.GetTopBlockY(15, 15), world.GetTopBlockY(16, 16)), std::max(world.GetTopBlockY(15, 16), world.GetTopBlockY(16, 15))) + 2;
+    for (int x = 14; x <= 17; x++)
+        for (int z = 14; z <= 17; z++)
+            if (world.SetBlock(x, roof, z, BLOCK_STONE)) lighting.BlockChanged(x, roof, z);
+    std::vector<ChunkCoord> relit;
+    lighting.Update(world, nullptr, relit);
+
+    std::vector<ChunkNeighborhood> areas;
+    for (int cx = -radius; cx < radius; cx++)
+        for (int cz = -radius; cz < radius; cz++) areas.push_back(GetNeighborhood(world, { cx, cz }));
+
+    // Back-to-back runs of the three shading modes, so each ratio compares the same machine state;
+    // a cost is the median ratio. Flat meshing samples no corners, as before ambient occlusion.
+    ChunkMesh mesh;
+    const MeshShading modes[3] = { MESH_FLAT, MESH_AO_ONLY, MESH_AO_AND_LIGHT };
+    double best[3] = { 1e9, 1e9, 1e9 };
+    long long quadsOf[3] = { 0, 0, 0 };
+    std::vector<double> aoRatios, lightRatios;
+    for (int rep = 0; rep < 25; rep++) {
+        double elapsed[3];
+        for (int m = 0; m < 3; m++) {
+            long long quads = 0;
+            double start = NowSeconds();
+            for (const ChunkNeighborhood& n : areas) {
+                MeshChunk(n, mesh, modes[m]);
+                quads += mesh.quadCount;
+            }
+            elapsed[m] = NowSeconds() - start;
+            best[m] = std::min(best[m], elapsed[m]);
+            quadsOf[m] = quads;
+        }
+        aoRatios.push_back(elapsed[1] / elapsed[0]);
+        lightRatios.push_back(elapsed[2] / elapsed[1]);
+    }
+    auto medianCost = [](std::vector<double>& ratios) {
+        std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2, ratios.end());
+        return ratios[ratios.size() / 2] - 1.0;
+    };
+    double aoCost = medianCost(aoRatios), lightCost = medianCost(lightRatios);
+
+    auto solid = [&world](int x, int y, int z) { return world.IsBlockSolid(x, y, z) ? 1 : 0; };
+    auto lightAt = [&world](const int p[3]) { return CombinedLight(world.GetLight(p[0], p[1], p[2])); };
+    long long corners = 0, wrong = 0, wrongSplit = 0, unitCells = 0;
+    long long levels[4] = { 0, 0, 0, 0 };
+    for (const ChunkNeighborhood& n : areas) {
+        MeshChunk(n, mesh);
+        for (size_t q = 0; q < mesh.vertices.size(); q += 6) {
+            // The quad's four distinct corners and its box.
+            const Vertex* corner[4];
+            int count = 0;
+            for (int i = 0; i < 6; i++) {
+                const Vertex& v = mesh.vertices[q + i];
+                bool seen = false;
+                for (int k = 0; k < count; k++) seen = seen || (corner[k]->x == v.x && corner[k]->y == v.y && corner[k]->z == v.z);
+                if (!seen && count < 4) corner[count++] = &v;
+            }
+            float lo[3] = { corner[0]->x, corner[0]->y, corner[0]->z }, hi[3] = { lo[0], lo[1], lo[2] };
+            for (int k = 1; k < count; k++) {
+                const float p[3] = { corner[k]->x, corner[k]->y, corner[k]->z };
+                for (int a = 0; a < 3; a++) { lo[a] = std::min(lo[a], p[a]); hi[a] = std::max(hi[a], p[a]); }
+            }
+            int axis = (lo[0] == hi[0]) ? 0 : (lo[1] == hi[1]) ? 1 : 2;
+            int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+            int back[3], frontCell[3];
+            back[axis] = (int)floorf(lo[axis]);      // The two cells the face separates
+            frontCell[axis] = back[axis] + 1;
+            back[uAxis] = frontCell[uAxis] = (int)floorf(lo[uAxis] + 0.5f);
+            back[vAxis] = frontCell[vAxis] = (int)floorf(lo[vAxis] + 0.5f);
+            int dir = solid(back[0], back[1], back[2]) ? +1 : -1;
+            int face = 0;
+            while (kVoxelFaces[face].axis != axis || kVoxelFaces[face].dir != dir) face++;
+            const int* block = (dir > 0) ? back : frontCell;
+            float tint[3];
+            BlockTint(world.GetBlock(block[0], block[1], block[2]), tint);
+            float shade = kVoxelFaces[face].shade;
+
+            float brightnessOf[4];
+            for (int k = 0; k < count; k++) {
+                const float p[3] = { corner[k]->x, corner[k]->y, corner[k]->z };
+                int su = (p[uAxis] == hi[uAxis]) ? 1 : -1, sv = (p[vAxis] == hi[vAxis]) ? 1 : -1;
+                // Every unit face of the quad must want the same value at this corner of itself,
+                // or interpolating across the merged quad would shade differently.
+                int cellsU = (int)(hi[uAxis] - lo[uAxis]), cellsV = (int)(hi[vAxis] - lo[vAxis]);
+                for (int cu = 0; cu < cellsU; cu++) {
+                    for (int cv = 0; cv < cellsV; cv++) {
+                        int f[3];
+                        f[axis] = block[axis] + dir;
+                        f[uAxis] = block[uAxis] + cu;
+                        f[vAxis] = block[vAxis] + cv;
+                        int s1[3] = { f[0], f[1], f[2] }, s2[3] = { f[0], f[1], f[2] }, c[3] = { f[0], f[1], f[2] };
+                        s1[uAxis] += su; s2[vAxis] += sv; c[uAxis] += su; c[vAxis] += sv;
+                        int side1 = solid(s1[0], s1[1], s1[2]), side2 = solid(s2[0], s2[1], s2[2]), diagonal = solid(c[0], c[1], c[2]);
+                        int ao = (side1 && side2) ? 0 : 3 - (side1 + side2 + diagonal);
+                        // Smooth light: the mean over the open cells of the four around the corner.
+                        int sum = lightAt(f), count = 1;
+                        if (!side1) { sum += lightAt(s1); count++; }
+                        if (!side2) { sum += lightAt(s2); count++; }
+                        if (!diagonal && !(side1 && side2)) { sum += lightAt(c); count++; }
+                        float light = kAoLight[ao] * kLightCurve[sum / count];
+                        bool same = corner[k]->r == (shade * 0.4f + tint[0] * 0.6f) * light
+                                 && corner[k]->g == (shade * 0.4f + tint[1] * 0.6f) * light
+                                 && corner[k]->b == (shade * 0.4f + tint[2] * 0.6f) * light;
+                        if (!same) wrong++;
+                        if (cu == 0 && cv == 0) { brightnessOf[k] = light; levels[ao]++; }
+                        if (k == 0) unitCells++;
+                    }
+                }
+                corners++;
+            }
+
+            // The split diagonal is the one shared by both triangles; its corners must be the lighter pair.
+            int shared[2], sharedCount = 0;
+            for (int i = 0; i < 3; i++)
+                for (int j = 3; j < 6; j++)
+                    if (memcmp(&mesh.vertices[q + i], &mesh.vertices[q + j], sizeof(Vertex)) == 0 && sharedCount < 2) {
+                        for (int k = 0; k < count; k++)
+                            if (memcmp(corner[k], &mesh.vertices[q + i], sizeof(Vertex)) == 0) shared[sharedCount++] = k;
+                    }
+            if (sharedCount != 2 || count != 4) { wrongSplit++; continue; }
+            int opposite[2], oppositeCount = 0;
+            for (int k = 0; k < 4; k++)
+                if (k != shared[0] && k != shared[1]) opposite[oppositeCount++] = k;
+            if (brightnessOf[shared[0]] + brightnessOf[shared[1]] < brightnessOf[opposite[0]] + brightnessOf[opposite[1]]) wrongSplit++;
+        }
+    }
+
+    DirtyChunks dirty;
+    dirty.MarkBlock(CHUNK_SIZE - 1, CHUNK_SIZE - 1, 0.0);
+
+    printf("[ao] %d chunks: %.3f ms/chunk flat, %.3f ms/chunk with AO (median %+.1f%%), %.3f ms/chunk with AO and light (median %+.1f%% more)\n",
+        (int)areas.size(), best[0] * 1000.0 / areas.size(), best[1] * 1000.0 / areas.size(), aoCost * 100.0,
+        best[2] * 1000.0 / areas.size(), lightCost * 100.0);
+    printf("[ao] greedy quads %lld flat -> %lld with AO (%+.1f%%) -> %lld with light, %lld quad corners over %lld unit faces\n",
+        quadsOf[0], quadsOf[1], 100.0 * (quadsOf[1] - quadsOf[0]) / quadsOf[0], quadsOf[2], corners, unitCells);
+    printf("[ao] corner levels 0..3: %lld / %lld / %lld / %lld\n", levels[0], levels[1], levels[2], levels[3]);
+    check("quad corners match AO and light of every face they cover", wrong == 0);
+    check("all four occlusion levels occur", levels[0] > 0 && levels[1] > 0 && levels[2] > 0 && levels[3] > 0);
+    check("quads split along the brighter diagonal", wrongSplit == 0);
+    check("corner edit marks the diagonal chunk as well", dirty.Pending() == 4);
+    check("AO costs under 10% extra meshing time over flat", aoCost < 0.10);
+    printf("[ao] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// The sin/cos height function the terrain used before gradient noise, kept as the throughput
+// baseline: batched chunk generation must not be slower than this was per column.
+static float LegacyTerrainHeight(const TerrainConfig& terrain, float worldX, float worldZ) {
+    float biome = sin((worldX + terrain.seedX) * 0.05f) * cos((worldZ + terrain.seedZ) * 0.05f);
+    float base = sin(worldX * 0.15f) + cos(worldZ * 0.15f);
+    float detail = sin(worldX * 0.6f) * cos(worldZ * 0.6f);
+    float mountainFactor = biome < 0.0f ? 0.0f : biome * biome;
+    return floor((base + detail) * mountainFactor * 5.0f) + 1.0f;
+}
+
+// Columns per second of the old scalar function, the new scalar GetTerrainHeight() and the
+// batched evaluator on chunk tiles, which must agree exactly. Then checks that the seeds are
+// honoured, that the terrain does not repeat the way the sines did, and that its heights fit
+// the world with both water and snow on them.
+static void BenchTerrain() {
+    TerrainConfig terrain = BenchTerrainConfig();
+    const int size = 1024;
+    std::vector<float> legacy(size * size), scalar(size * size), batched(size * size);
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[terrain] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+
+    double start = NowSeconds();
+    for (int j = 0; j < size; j++)
+        for (int i = 0; i < size; i++) legacy[j * size + i] = LegacyTerrainHeight(terrain, (float)(i - size / 2), (float)(j - size / 2));
+    double legacyTime = NowSeconds() - start;
+
+    start = NowSeconds();
+    for (int j = 0; j < size; j++)
+        for (int i = 0; i < size; i++) scalar[j * size + i] = GetTerrainHeight(terrain, (float)(i - size / 2), (float)(j - size / 2));
+    double scalarTime = NowSeconds() - start;
+
+    // Chunk tiles in generation order: a row of chunks at a time, as the rings grow outwards.
+    const int tile = CHUNK_SIZE;
+    TerrainBiomeCache& cache = TerrainBiomeCache::ForThread();
+    size_t hits = cache.Hits, misses = cache.Misses;
+    start = NowSeconds();
+    float tileHeights[tile * tile];
+    for (int tz = 0; tz < size; tz += tile) {
+        for (int tx = 0; tx < size; tx += tile) {
+            GetTerrainHeights(terrain, (float)(tx - size / 2), (float)(tz - size / 2), tile, tile, tileHeights);
+            for (int j = 0; j < tile; j++) memcpy(&batched[(tz + j) * size + tx], &tileHeights[j * tile], tile * sizeof(float));
+        }
+    }
+    double batchedTime = NowSeconds() - start;
+    hits = cache.Hits - hits; misses = cache.Misses - misses;
+
+    int mismatches = 0;
+    for (int i = 0; i < size * size; i++) if (scalar[i] != batched[i]) mismatches++;
+
+    double columns = (double)size * size;
+#if defined(__SSE4_1__)
+    const char* isa = "SSE4.1";
+#elif defined(TERRAIN_SIMD)
+    const char* isa = "SSE2";
+#else
+    const char* isa = "scalar";
+#endif
+    printf("[terrain] sin/cos scalar (old): %.1f M columns/s\n", columns / legacyTime / 1e6);
+    printf("[terrain] noise scalar:         %.1f M columns/s\n", columns / scalarTime / 1e6);
+    printf("[terrain] noise batched:        %.1f M columns/s (%s, 16x16 tiles), %.2fx the old scalar\n", columns / batchedTime / 1e6, isa, legacyTime / batchedTime);
+    printf("[terrain] biome region cache: %zu hits, %zu misses\n", hits, misses);
+
+    int lowest = 1 << 30, highest = -(1 << 30);
+    for (float h : batched) { lowest = std::min(lowest, (int)h - 1); highest = std::max(highest, (int)h - 1); }
+    printf("[terrain] top blocks from y=%d to y=%d\n", lowest, highest);
+
+    // Same seeds give the same heights, and either seed on its own changes them.
+    TerrainConfig otherX = terrain, otherZ = terrain;
+    otherX.seedX += 0.1f; otherZ.seedZ += 0.1f;
+    float again[tile * tile], movedX[tile * tile], movedZ[tile * tile];
+    GetTerrainHeights(terrain, 0.0f, 0.0f, tile, tile, tileHeights);
+    GetTerrainHeights(terrain, 0.0f, 0.0f, tile, tile, again);
+    int sameX = 0, sameZ = 0;
+    for (int i = 0; i < size; i += 16) {
+        for (int j = 0; j < size; j += 16) {
+            float x = (float)(i - size / 2), z = (float)(j - size / 2), h = GetTerrainHeight(terrain, x, z);
+            sameX += GetTerrainHeight(otherX, x, z) == h;
+            sameZ += GetTerrainHeight(otherZ, x, z) == h;
+        }
+    }
+    GetTerrainHeights(otherX, 0.0f, 0.0f, tile, tile, movedX);
+    GetTerrainHeights(otherZ, 0.0f, 0.0f, tile, tile, movedZ);
+
+    // The old terrain repeated every 2 pi / 0.05 blocks; count columns that match one period on.
+    const int period = 126;
+    int repeats = 0, legacyRepeats = 0;
+    for (int j = 0; j < size; j += 4) {
+        for (int i = 0; i + period < size; i += 4) {
+            repeats += scalar[j * size + i] == scalar[j * size + i + period];
+            legacyRepeats += legacy[j * size + i] == legacy[j * size + i + period];
+        }
+    }
+    int pairs = (size / 4) * ((size - period + 3) / 4);
+    printf("[terrain] heights equal one old period apart: %.0f%% (old %.0f%%)\n", 100.0 * repeats / pairs, 100.0 * legacyRepeats / pairs);
+
+    check("batched heights match GetTerrainHeight() exactly", mismatches == 0);
+    check("batched is at least as fast as the old scalar function", batchedTime <= legacyTime);
+    check("same seeds regenerate identical heights", memcmp(tileHeights, again, sizeof(again)) == 0);
+    check("changing either seed changes the terrain", memcmp(tileHeights, movedX, sizeof(movedX)) != 0 &&
+        memcmp(tileHeights, movedZ, sizeof(movedZ)) != 0 && sameX < 4096 / 2 && sameZ < 4096 / 2);
+    check("heights fit the world with water and snow", lowest >= WORLD_MIN_Y && highest <= WORLD_MAX_Y &&
+        lowest <= -2 && highest > 3);
+    check("region cache hits for neighbouring chunks", misses > 0 && hits > misses * 8);
+    printf("[terrain] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Frustum test throughput on random boxes (SIMD vs one-at-a-time, which must agree), then the
+// visible/culled split for the render range around a camera turning in place.
+static void BenchFrustum() {
+    Frustum frustum = Frustum::FromCamera(0.0f, 10.0f, 0.0f, 0.3f, 0.4f, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+
+    AabbBatch boxes;
+    unsigned int rng = 12345;
+    auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return (float)(rng >> 8) / (float)(1 << 24); };
+    const int count = 1 << 16;
+    for (int i = 0; i < count; i++) {
+        float lo[3] = { next() * 512.0f - 256.0f, next() * 32.0f - 6.0f, next() * 512.0f - 256.0f };
+        float hi[3] = { lo[0] + 16.0f, lo[1] + next() * 16.0f, lo[2] + 16.0f };
+        boxes.Add(lo, hi);
+    }
+
+    std::vector<uint8_t> visible(count);
+    CullStats stats;
+    const int reps = 200;
+    double start = NowSeconds();
+    for (int r = 0; r < reps; r++) CullAabbs(frustum, boxes, visible.data(), stats);
+    double simdTime = NowSeconds() - start;
+
+    int disagreements = 0;
+    volatile int scalarVisible = 0;
+    start = NowSeconds();
+    for (int r = 0; r < reps; r++) {
+        int n = 0;
+        for (int i = 0; i < count; i++) n += AabbInFrustum(frustum, boxes, i) ? 1 : 0;
+        scalarVisible = n;
+    }
+    double scalarTime = NowSeconds() - start;
+    for (int i = 0; i < count; i++) if ((AabbInFrustum(frustum, boxes, i) ? 1 : 0) != visible[i]) disagreements++;
+
+    printf("[frustum] %d boxes: SIMD %.1f M boxes/s, scalar %.1f M boxes/s, %d disagreements\n", count,
+        (double)count * reps / simdTime / 1e6, (double)count * reps / scalarTime / 1e6, disagreements);
+    printf("[frustum] random boxes: %d visible, %d culled (scalar %d visible)\n", stats.visible, stats.culled, (int)scalarVisible);
+
+    // Chunk boxes for range 32 around the origin, as RenderGraphics() would submit them.
+    AabbBatch chunks;
+    for (int cx = -3; cx <= 2; cx++) {
+        for (int cz = -3; cz <= 2; cz++) {
+            float lo[3] = { cx * 16.0f - 0.5f, WORLD_MIN_Y - 0.5f, cz * 16.0f - 0.5f };
+            float hi[3] = { lo[0] + 16.0f, WORLD_MAX_Y + 0.5f, lo[2] + 16.0f };
+            chunks.Add(lo, hi);
+        }
+    }
+    visible.resize(chunks.Count());
+    for (int step = 0; step < 4; step++) {
+        float yaw = step * 1.5707963f;
+        Frustum f = Frustum::FromCamera(0.0f, 10.0f, 0.0f, yaw, 0.4f, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+        CullAabbs(f, chunks, visible.data(), stats);
+        printf("[frustum] range-32 chunks, yaw %.2f: %d visible, %d culled\n", yaw, stats.visible, stats.culled);
+    }
+}
+
+// Top block of the cell covering column (x, z) in a tile at `level`; level 0 reads the real chunk.
+static int LodSurfaceAt(VoxelWorld& world, int level, int x, int z) {
+    if (level == 0) return world.GetTopBlockY(x, z);
+    int step = 1 << level;
+    float cellX = (float)(FloorDiv(x, step) * step + step / 2), cellZ = (float)(FloorDiv(z, step) * step + step / 2);
+    float height;
+    GetTerrainHeights(world.Terrain, cellX, cellZ, 1, 1, &height);
+    return LodTopY(height);
+}
+
+// Meshes every ring around a few camera positions and reports triangles per ring against what
+// full-resolution chunks would cost over the same area. Then walks every edge between two tiles
+// and checks that wherever the far side stands higher, its walls facing the camera reach all the
+// way down to the near side's surface, i.e. there is no crack to see through.
+static void BenchLod() {
+    const int camPositions[][2] = { { 0, 0 }, { 37, -81 }, { 503, 260 } };
+    for (const auto& cam : camPositions) {
+        VoxelWorld world(1 << 16);
+        world.Reset(BenchTerrainConfig());
+        const int reach = kLodRingRadius[LOD_LEVELS - 1] / CHUNK_SIZE + 1;
+        ChunkCoord camChunk = ChunkCoordOf(cam[0], cam[1]);
+        bool fullRes = (cam[0] == 0 && cam[1] == 0); // Only worth generating the whole area once
+
+        std::map<std::pair<int, int>, ChunkMesh> meshes;
+        std::map<std::pair<int, int>, int> levels;
+        int tiles[LOD_LEVELS] = {};
+        long long tris[LOD_LEVELS] = {}, fullTris[LOD_LEVELS] = {};
+        double meshTime[LOD_LEVELS] = {};
+        ChunkMesh full;
+        for (int cx = camChunk.x - reach; cx <= camChunk.x + reach; cx++) {
+            for (int cz = camChunk.z - reach; cz <= camChunk.z + reach; cz++) {
+                int level = LodLevelForChunk({ cx, cz }, cam[0], cam[1]);
+                if (level < 0) continue;
+                levels[{ cx, cz }] = level;
+                ChunkMesh& mesh = meshes[{ cx, cz }];
+                double start = NowSeconds();
+                if (level == 0) MeshChunk(GetNeighborhood(world, { cx, cz }), mesh);
+                else MeshLodTile(world.Terrain, { cx, cz }, level, mesh);
+                meshTime[level] += NowSeconds() - start;
+                tiles[level]++;
+                tris[level] += mesh.quadCount * 2;
+                if (fullRes) {
+                    if (level == 0) fullTris[level] += mesh.quadCount * 2;
+                    else { MeshChunk(GetNeighborhood(world, { cx, cz }), full); fullTris[level] += full.quadCount * 2; }
+                }
+            }
+        }
+
+        printf("[lod] camera (%d, %d):\n", cam[0], cam[1]);
+        long long total = 0, fullTotal = 0;
+        for (int level = 0; level < LOD_LEVELS; level++) {
+            total += tris[level]; fullTotal += fullTris[level];
+            printf("[lod]   ring %d (step %d, <= %3d blocks): %4d tiles, %6lld triangles, %.3f ms/tile", level, 1 << level,
+                kLodRingRadius[level], tiles[level], tris[level], tiles[level] ? meshTime[level] * 1000.0 / tiles[level] : 0.0);
+            if (fullRes) printf(", full res %7lld (%.1fx)", fullTris[level], tris[level] ? (double)fullTris[level] / tris[level] : 0.0);
+            printf("\n");
+        }
+        printf("[lod]   total %lld triangles out to %d blocks", total, kLodRingRadius[LOD_LEVELS - 1]);
+        if (fullRes) printf(" (full res %lld, ring 0 alone %lld)", fullTotal, tris[0]);
+        printf("\n");
+
+        // Crack check over every tile edge.
+        long long checked = 0, cracks = 0;
+        for (const auto& entry : levels) {
+            for (int axis = 0; axis < 2; axis++) {
+                std::pair<int, int> a = entry.first, b = a;
+                if (axis == 0) b.first++; else b.second++;
+                auto other = levels.find(b);
+                if (other == levels.end()) continue;
+                int plane = (axis == 0 ? b.first : b.second) * CHUNK_SIZE;  // First block column of b
+                for (int side = 0; side < 2; side++) {
+                    // high = the tile whose wall must cover the step, low = the one next to it.
+                    std::pair<int, int> high = side ? b : a, low = side ? a : b;
+                    int highLevel = levels[high], lowLevel = levels[low];
+                    if (highLevel == 0) continue;                             // Real chunks are meshed exactly
+                    int camAcross = (axis == 0) ? cam[0] : cam[1];
+                    bool camOnLowSide = side ? (camAcross < plane) : (camAcross >= plane);
+                    if (!camOnLowSide) continue;                              // Wall faces away from the camera
+
+                    int highColumn = side ? plane : plane - 1, lowColumn = side ? plane - 1 : plane;
+                    float wallPlane = plane - 0.5f;
+                    const ChunkMesh& mesh = meshes[high];
+                    int alongOrigin = (axis == 0 ? a.second : a.first) * CHUNK_SIZE;
+                    for (int t = 0; t < CHUNK_SIZE; t++) {
+                        int along = alongOrigin + t;
+                        int hx = axis == 0 ? highColumn : along, hz = axis == 0 ? along : highColumn;
+                        int lx = axis == 0 ? lowColumn : along, lz = axis == 0 ? along : lowColumn;
+                        int highTop = LodSurfaceAt(world, highLevel, hx, hz);
+                        int lowTop = LodSurfaceAt(world, lowLevel, lx, lz);
+                        if (highTop <= lowTop) continue;
+                        checked++;
+
+                        std::vector<std::pair<float, float>> spans;
+                        for (size_t v = 0; v < mesh.vertices.size(); v += 6) {
+                            float mn[3] = { 1e9f, 1e9f, 1e9f }, mx[3] = { -1e9f, -1e9f, -1e9f };
+                            for (int k = 0; k < 6; k++) {
+                                const Vertex& vtx = mesh.vertices[v + k];
+                                const float p[3] = { vtx.x, vtx.y, vtx.z };
+                                for (int d = 0; d < 3; d++) { mn[d] = std::min(mn[d], p[d]); mx[d] = std::max(mx[d], p[d]); }
+                            }
+                            int across = axis == 0 ? 0 : 2, alongAxis = axis == 0 ? 2 : 0;
+                            if (mn[across] != wallPlane || mx[across] != wallPlane) continue;
+                            if (along < mn[alongAxis] || along > mx[alongAxis]) continue;
+                            spans.push_back({ mn[1], mx[1] });
+                        }
+                        std::sort(spans.begin(), spans.end());
+                        float covered = lowTop + 0.5f;
+                        for (const auto& span : spans) if (span.first <= covered) covered = std::max(covered, span.second);
+                        if (covered < highTop + 0.5f) cracks++;
+                    }
+                }
+            }
+        }
+        printf("[lod]   crack check: %lld exposed steps along tile edges, %lld cracks\n", checked, cracks);
+    }
+}
+
+static std::vector<float> MeshPositions(const ChunkMesh& mesh) {
+    std::vector<float> xyz;
+    xyz.reserve(mesh.vertices.size() * 3);
+    for (const Vertex& v : mesh.vertices) { xyz.push_back(v.x); xyz.push_back(v.y); xyz.push_back(v.z); }
+    return xyz;
+}
+
+// Stands in a valley looking at the highest peak nearby, with every LOD ring meshed, and runs the
+// frame's culling: frustum, then Hi-Z against the nearest chunks. To check the result, the whole
+// scene is rasterized into a reference buffer and every occluded chunk is drawn against it; any
+// pixel where it would be in front counts as a false cull.
+static void BenchOcclusion() {
+    VoxelWorld world(1 << 16);
+    world.Reset(BenchTerrainConfig());
+
+    // Highest column within 160 blocks, then the lowest dry one 40 to 80 blocks away from it.
+    float heights[321 * 321];
+    GetTerrainHeights(world.Terrain, -160.0f, -160.0f, 321, 321, heights);
+    int peak = (int)(std::max_element(heights, heights + 321 * 321) - heights);
+    int peakX = peak % 321 - 160, peakZ = peak / 321 - 160;
+    int valleyX = peakX, valleyZ = peakZ;
+    float valleyH = 1e9f;
+    for (int z = -160; z <= 160; z += 2) {
+        for (int x = -160; x <= 160; x += 2) {
+            float d = sqrtf((float)((x - peakX) * (x - peakX) + (z - peakZ) * (z - peakZ)));
+            float h = heights[(z + 160) * 321 + (x + 160)];
+            if (d >= 40.0f && d <= 80.0f && h >= 0.0f && h < valleyH) { valleyH = h; valleyX = x; valleyZ = z; }
+        }
+    }
+    float camX = (float)valleyX, camZ = (float)valleyZ;
+    float camY = world.GetGroundHeight(camX, camZ) + 1.3f; // Eye 1.8 above the top surface, as UpdateCamera() puts it
+    float yaw = atan2f((float)(peakX - valleyX), (float)(peakZ - valleyZ)), pitch = 0.0f;
+    if (!world.IsColumnLoaded(camX, camZ)) { world.GetChunk(ChunkCoordOf(valleyX, valleyZ)); camY = world.GetGroundHeight(camX, camZ) + 1.3f; }
+
+    std::vector<ChunkMesh> meshes;
+    const int reach = kLodRingRadius[LOD_LEVELS - 1] / CHUNK_SIZE + 1;
+    ChunkCoord camChunk = ChunkCoordOf(valleyX, valleyZ);
+    for (int cx = camChunk.x - reach; cx <= camChunk.x + reach; cx++) {
+        for (int cz = camChunk.z - reach; cz <= camChunk.z + reach; cz++) {
+            int level = LodLevelForChunk({ cx, cz }, valleyX, valleyZ);
+            if (level < 0) continue;
+            meshes.emplace_back();
+            if (level == 0) MeshChunk(GetNeighborhood(world, { cx, cz }), meshes.back());
+            else MeshLodTile(world.Terrain, { cx, cz }, level, meshes.back());
+        }
+    }
+    std::vector<std::vector<float>> positions;
+    for (const ChunkMesh& mesh : meshes) positions.push_back(MeshPositions(mesh));
+
+    CameraMatrices camera = CameraMatrices::FromCamera(camX, camY, camZ, yaw, pitch, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+    Frustum frustum = Frustum::FromCamera(camera);
+    AabbBatch boxes;
+    for (const ChunkMesh& mesh : meshes) boxes.Add(mesh.boundsMin, mesh.boundsMax);
+    std::vector<uint8_t> visible(boxes.Count());
+    CullStats frustumStats;
+    CullAabbs(frustum, boxes, visible.data(), frustumStats);
+
+    // Occluders: nearest visible chunks first, up to a triangle budget.
+    const size_t budget = 16384;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < meshes.size(); i++) if (visible[i]) order.push_back(i);
+    auto distance = [&](size_t i) {
+        float dx = (meshes[i].boundsMin[0] + meshes[i].boundsMax[0]) * 0.5f - camX;
+        float dz = (meshes[i].boundsMin[2] + meshes[i].boundsMax[2]) * 0.5f - camZ;
+        return dx * dx + dz * dz;
+    };
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return distance(a) < distance(b); });
+
+    OcclusionCuller culler;
+    JobSystem jobs;
+    int occluderChunks = 0;
+    const int reps = 200;
+    double addTime = 0.0, rasterTime = 0.0, rasterTimeMt = 0.0, testTime = 0.0;
+    std::vector<uint8_t> result;
+    for (int r = 0; r < reps; r++) {
+        double start = NowSeconds();
+        culler.BeginFrame(camera);
+        occluderChunks = 0;
+        size_t triangles = 0;
+        for (size_t i : order) {
+            triangles += meshes[i].quadCount * 2;
+            if (triangles > budget) break;
+            culler.AddOccluder(positions[i].data(), positions[i].size() / 3);
+            occluderChunks++;
+        }
+        double mid = NowSeconds();
+        if (r & 1) culler.Rasterize(&jobs);
+        else culler.Rasterize();
+        double rastered = NowSeconds();
+        result = visible;
+        culler.CullOccluded(boxes, result.data());
+        double end = NowSeconds();
+        addTime += mid - start;
+        ((r & 1) ? rasterTimeMt : rasterTime) += rastered - mid;
+        testTime += end - rastered;
+    }
+    const OcclusionStats& stats = culler.Stats;
+
+    // Reference: every chunk drawn, then each occluded chunk alone compared against it.
+    OcclusionCuller reference, single;
+    reference.BeginFrame(camera);
+    for (size_t i = 0; i < meshes.size(); i++) if (visible[i]) reference.AddOccluder(positions[i].data(), positions[i].size() / 3);
+    reference.Rasterize();
+    int falseCulls = 0, leakedPixels = 0;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        if (!visible[i] || result[i]) continue;
+        single.BeginFrame(camera);
+        single.AddOccluder(positions[i].data(), positions[i].size() / 3);
+        single.Rasterize();
+        int pixels = 0;
+        for (int p = 0; p < OcclusionCuller::WIDTH * OcclusionCuller::HEIGHT; p++) {
+            float mine = single.DepthBuffer()[p];
+            if (mine > 0.0f && mine >= reference.DepthBuffer()[p] * 0.99999f) pixels++;
+        }
+        if (pixels) falseCulls++;
+        leakedPixels += pixels;
+    }
+
+    int drawn = 0;
+    long long drawnTris = 0, frustumTris = 0;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        if (visible[i]) frustumTris += meshes[i].quadCount * 2;
+        if (result[i]) { drawn++; drawnTris += meshes[i].quadCount * 2; }
+    }
+    printf("[occlusion] camera (%.0f, %.1f, %.0f) looking at the peak at (%d, %d), %d chunks/tiles in range\n", camX, camY, camZ, peakX, peakZ, (int)meshes.size());
+    printf("[occlusion] frustum: %d visible, %d culled; occluders: %d chunks, %d triangles after near clip and back-face cull\n",
+        frustumStats.visible, frustumStats.culled, occluderChunks, stats.occluderTriangles);
+    printf("[occlusion] Hi-Z: %d tested, %d occluded; drawing %d chunks, %lld triangles (frustum only: %lld)\n",
+        stats.tested, stats.occluded, drawn, drawnTris, frustumTris);
+    printf("[occlusion] per frame: setup %.3f ms, raster %.3f ms (1 thread) / %.3f ms (%d workers), box tests %.3f ms\n",
+        addTime * 1000.0 / reps, rasterTime * 2000.0 / reps, rasterTimeMt * 2000.0 / reps, jobs.ThreadCount(), testTime * 1000.0 / reps);
+    printf("[occlusion] reference check: %d falsely culled chunks, %d pixels\n", falseCulls, leakedPixels);
+}
+
+// FNV-1a over the exact bits of position and velocity, chained across bodies.
+static unsigned long long HashBody(const PhysicsBody& body, unsigned long long hash = 1469598103934665603ULL) {
+    unsigned char bytes[sizeof(body.pos) + sizeof(body.vel)];
+    memcpy(bytes, body.pos, sizeof(body.pos)); memcpy(bytes + sizeof(body.pos), body.vel, sizeof(body.vel));
+    for (unsigned char b : bytes) { hash ^= b; hash *= 1099511628211ULL; }
+    return hash;
+}
+
+// Flat test world: floor with its top at y = 0, a 3-high wall at x = 5 and a 1-high ledge at x <= -5.
+static void BuildPhysicsTestWorld(VoxelWorld& world) {
+    world.Reset(BenchTerrainConfig());
+    for (int cx = -2; cx <= 1; cx++) {
+        for (int cz = -2; cz <= 1; cz++) {
+            std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+            chunk->coord = { cx, cz };
+            for (int lz = 0; lz < CHUNK_SIZE; lz++) {
+                for (int lx = 0; lx < CHUNK_SIZE; lx++) {
+                    int x = chunk->OriginX() + lx;
+                    int top = (x == 5) ? 3 : (x <= -5) ? 1 : 0;
+                    for (int ly = 0; ly < CHUNK_HEIGHT; ly++) chunk->Set(lx, ly, lz, (ly + WORLD_MIN_Y <= top) ? BLOCK_STONE : BLOCK_AIR);
+                }
+            }
+            chunk->RecomputeTopY();
+            world.InsertChunk(chunk);
+        }
+    }
+}
+
+// One tick walking at `walk` blocks per second, for the scripted checks below.
+static void StepBody(const VoxelWorld& world, PhysicsBody& body, const float walk[2], float dt, bool* steppedUp = nullptr) {
+    PlayerInput input;
+    input.moveX = walk[0] / PLAYER_MOVE_SPEED;
+    input.moveZ = walk[1] / PLAYER_MOVE_SPEED;
+    float before = body.pos[1];
+    StepPlayer(world, body, input, dt);
+    if (steppedUp && body.pos[1] > before + 0.5f) *steppedUp = true;
+}
+
+// Scripted collision cases with exact expected results, then thousands of bodies wandering over
+// generated terrain: throughput, a penetration check after every tick and a bitwise replay.
+static void BenchPhysics() {
+    const float dt = 1.0f / 60.0f;
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        printf("[physics] %-52s %s\n", what, ok ? "OK" : "FAILED");
+        if (!ok) failures++;
+    };
+
+    VoxelWorld flat(64);
+    BuildPhysicsTestWorld(flat);
+    {
+        PhysicsBody body; body.pos[1] = 10.0f;
+        const float still[2] = { 0.0f, 0.0f };
+        for (int i = 0; i < 120; i++) StepBody(flat, body, still, dt);
+        check(body.grounded && body.pos[1] == 0.5f && body.vel[1] == 0.0f, "falling body rests on the floor top (y = 0.5)");
+    }
+    {
+        PhysicsBody body; body.pos[1] = 0.5f;
+        const float walk[2] = { 10.0f, 0.0f };
+        for (int i = 0; i < 120; i++) StepBody(flat, body, walk, dt);
+        const float push[3] = { 0.1f, 0.0f, 0.0f };
+        MoveResult r = MoveBody(flat, body, push);
+        check(body.pos[0] == 5.0f - 0.5f - body.halfWidth && r.contactCount == 1 && r.contacts[0].normal[0] == -1.0f && r.contacts[0].t == 0.0f,
+            "walking into the wall stops flush, normal -X");
+    }
+    {
+        PhysicsBody body; body.pos[1] = 0.5f; body.pos[0] = 4.0f;
+        const float walk[2] = { 10.0f, 10.0f };
+        for (int i = 0; i < 30; i++) StepBody(flat, body, walk, dt);
+        check(body.pos[0] == 4.3f && fabs(body.pos[2] - 5.0f) < 1e-3f, "diagonal walk slides along the wall");
+    }
+    {
+        PhysicsBody body; body.pos[1] = 0.5f; body.grounded = true;
+        const float delta[3] = { 1000.0f, 0.0f, 0.0f };
+        MoveResult r = MoveBody(flat, body, delta);
+        check(body.pos[0] == 4.3f && r.contactCount == 1 && r.contacts[0].t < 0.01f, "1000-block move in one step does not tunnel");
+        const float fall[3] = { 0.0f, -1000.0f, 0.0f };
+        body.pos[0] = 0.0f; body.pos[1] = 20.0f;
+        r = MoveBody(flat, body, fall);
+        check(body.pos[1] == 0.5f && body.grounded && r.contacts[0].normal[1] == 1.0f, "1000-block fall lands with normal +Y");
+    }
+    {
+        PhysicsBody body; body.pos[1] = 0.5f; body.grounded = true;
+        const float walk[2] = { -10.0f, 0.0f };
+        for (int i = 0; i < 60; i++) StepBody(flat, body, walk, dt);
+        check(body.pos[0] == -4.3f && body.pos[1] == 0.5f, "no step height: the 1-block ledge blocks");
+        body.stepHeight = 1.05f;
+        bool stepped = false;
+        for (int i = 0; i < 60; i++) StepBody(flat, body, walk, dt, &stepped);
+        check(stepped && body.pos[1] == 1.5f && body.pos[0] < -6.0f && body.grounded, "step height 1.05: climbs the ledge and walks on");
+    }
+
+    // Wandering crowd over real terrain.
+    VoxelWorld world(1024);
+    world.Reset(BenchTerrainConfig());
+    const int radius = 4;
+    for (int cx = -radius; cx < radius; cx++)
+        for (int cz = -radius; cz < radius; cz++) world.GetChunk({ cx, cz });
+
+    const int bodies = 4096, ticks = 600;
+    auto runCrowd = [&](double& seconds, int& penetrations) {
+        std::vector<PhysicsBody> crowd(bodies);
+        std::vector<float> walk(bodies * 2);
+        unsigned int rng = 2024;
+        auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return (float)(rng >> 8) / (float)(1 << 24); };
+        for (PhysicsBody& body : crowd) {
+            body.pos[0] = next() * 120.0f - 60.0f; body.pos[2] = next() * 120.0f - 60.0f; body.pos[1] = 20.0f;
+            body.stepHeight = (next() < 0.5f) ? 1.05f : 0.0f;
+        }
+        penetrations = 0;
+        seconds = 0.0;
+        for (int tick = 0; tick < ticks; tick++) {
+            if (tick % 30 == 0) {
+                for (int i = 0; i < bodies; i++) {
+                    float angle = next() * 6.2831853f, speed = next() * 12.0f;
+                    walk[i * 2] = sinf(angle) * speed; walk[i * 2 + 1] = cosf(angle) * speed;
+                    if (crowd[i].grounded && next() < 0.2f) crowd[i].vel[1] = PLAYER_JUMP_SPEED;
+                }
+            }
+            double start = NowSeconds();
+            for (int i = 0; i < bodies; i++) StepBody(world, crowd[i], &walk[i * 2], dt);
+            seconds += NowSeconds() - start;
+            for (const PhysicsBody& body : crowd) if (AabbOverlapsSolid(world, body.Box())) penetrations++;
+        }
+        unsigned long long hash = 1469598103934665603ULL;
+        for (const PhysicsBody& body : crowd) hash = HashBody(body, hash);
+        return hash;
+    };
+    double seconds = 0.0, replaySeconds = 0.0;
+    int penetrations = 0, replayPenetrations = 0;
+    unsigned long long hash = runCrowd(seconds, penetrations);
+    unsigned long long replay = runCrowd(replaySeconds, replayPenetrations);
+    printf("[physics] %d bodies x %d ticks: %.3f ms/tick, %.1f M body-steps/s\n", bodies, ticks,
+        seconds * 1000.0 / ticks, (double)bodies * ticks / seconds / 1e6);
+    check(penetrations == 0, "no body inside a block after any tick");
+    check(hash == replay, "replay from the same seed is bit-identical");
+    printf("[physics] %s\n", failures ? "FAILURES" : "all checks passed");
+}
+
+// Scripted player input as a pure function of the tick number: walk in a slow circle, jump now and then.
+static PlayerInput ScriptedInput(uint64_t tick) {
+    PlayerInput input;
+    float angle = (float)(tick % 6283) * 0.001f * 10.0f;
+    input.moveX = sinf(angle);
+    input.moveZ = cosf(angle);
+    input.jump = (tick % 90) == 0;
+    return input;
+}
+
+// Headless fixed-step runner: a million player ticks at 60 Hz with two substeps, once straight
+// through and once driven by a FixedTimestep fed random frame times. Both must end bit-identical.
+static void BenchTicks() {
+    VoxelWorld world(1024);
+    world.Reset(BenchTerrainConfig());
+    for (int cx = -4; cx < 4; cx++)
+        for (int cz = -4; cz < 4; cz++) world.GetChunk({ cx, cz });
+
+    const uint64_t tickCount = 1000000;
+    const float step = 1.0f / 60.0f;
+    const int substeps = 2;
+
+    PhysicsBody direct;
+    direct.pos[1] = 20.0f;
+    double start = NowSeconds();
+    for (uint64_t tick = 0; tick < tickCount; tick++) StepPlayer(world, direct, ScriptedInput(tick), step, substeps);
+    double elapsed = NowSeconds() - start;
+
+    PhysicsBody framed;
+    framed.pos[1] = 20.0f;
+    FixedTimestep clock(step);
+    unsigned int rng = 99;
+    uint64_t tick = 0;
+    int frames = 0;
+    while (tick < tickCount) {
+        rng = rng * 1664525u + 1013904223u;
+        float frameDt = 0.001f + (float)(rng >> 8) / (float)(1 << 24) * 0.1f; // 1 ms to 100 ms frames
+        int ticks = clock.Advance(frameDt);
+        for (int i = 0; i < ticks && tick < tickCount; i++, tick++) StepPlayer(world, framed, ScriptedInput(tick), step, substeps);
+        frames++;
+    }
+
+    printf("[ticks] %llu ticks (%d substeps): %.0f ticks/s, %.2f us/tick, ended at (%.2f, %.2f, %.2f)\n", (unsigned long long)tickCount, substeps,
+        tickCount / elapsed, elapsed * 1e6 / tickCount, direct.pos[0], direct.pos[1], direct.pos[2]);
+    printf("[ticks] same ticks over %d variable-length frames: %s\n", frames, HashBody(direct) == HashBody(framed) ? "bit-identical" : "DIFFERENT");
+}
+
+// Plain Amanatides-Woo walk that tests every cell, as the reference for RaycastBlocks().
+static RaycastHit ReferenceRaycast(const VoxelWorld& world, const Ray& ray) {
+    RaycastHit result;
+    float length = sqrtf(ray.dir[0] * ray.dir[0] + ray.dir[1] * ray.dir[1] + ray.dir[2] * ray.dir[2]);
+    float d[3], tNext[3], tDelta[3];
+    int cell[3], step[3];
+    for (int a = 0; a < 3; a++) {
+        d[a] = ray.dir[a] / length;
+        step[a] = (d[a] > 0.0f) ? 1 : (d[a] < 0.0f) ? -1 : 0;
+        cell[a] = RayCellOf(ray.origin[a], step[a]);
+        tDelta[a] = step[a] ? fabsf(1.0f / d[a]) : INFINITY;
+        tNext[a] = step[a] ? ((cell[a] + 0.5f * step[a]) - ray.origin[a]) / d[a] : INFINITY;
+    }
+    float t = 0.0f;
+    int enterAxis = -1;
+    while (t <= ray.maxDistance) {
+        if (cell[1] >= WORLD_MIN_Y && cell[1] <= WORLD_MAX_Y) {
+            const Chunk* chunk = world.LookupChunk(ChunkCoordOf(cell[0], cell[2]));
+            uint8_t block = chunk ? chunk->Get(cell[0] - chunk->OriginX(), cell[1] - WORLD_MIN_Y, cell[2] - chunk->OriginZ()) : (uint8_t)BLOCK_AIR;
+            if (IsSolidBlock(block)) {
+                result.hit = true;
+                result.type = block;
+                result.distance = t;
+                for (int a = 0; a < 3; a++) result.block[a] = cell[a];
+                if (enterAxis >= 0) result.normal[enterAxis] = -step[enterAxis];
+                return result;
+            }
+        }
+        int axis = (tNext[0] < tNext[1]) ? ((tNext[0] < tNext[2]) ? 0 : 2) : ((tNext[1] < tNext[2]) ? 1 : 2);
+        t = tNext[axis];
+        cell[axis] += step[axis];
+        tNext[axis] += tDelta[axis];
+        enterAxis = axis;
+    }
+    return result;
+}
+
+// Casts camera-like rays (from just above the ground, mostly level or looking down) and AI
+// line-of-sight pairs over a loaded square of chunks. Every ray is checked against the plain DDA,
+// then timed single-threaded and through the job system.
+static void BenchRaycast() {
+    const int radius = 8;
+    VoxelWorld world(4096);
+    world.Reset(BenchTerrainConfig());
+    for (int cx = -radius; cx < radius; cx++)
+        for (int cz = -radius; cz < radius; cz++) world.GetChunk({ cx, cz });
+
+    const int rayCount = 200000;
+    const float span = (float)(radius * CHUNK_SIZE - 8);
+    std::vector<Ray> rays(rayCount);
+    unsigned int rng = 7;
+    auto random01 = [&rng]() { rng = rng * 1664525u + 1013904223u; return (float)(rng >> 8) / (float)(1 << 24); };
+    for (Ray& ray : rays) {
+        float x = (random01() * 2.0f - 1.0f) * span, z = (random01() * 2.0f - 1.0f) * span;
+        float yaw = random01() * 6.2831853f, pitch = -1.0f + random01() * 1.35f;
+        ray.origin[0] = x; ray.origin[1] = world.GetGroundHeight(x, z) + 1.3f + random01() * 4.0f; ray.origin[2] = z;
+        ray.dir[0] = sinf(yaw) * cosf(pitch); ray.dir[1] = sinf(pitch); ray.dir[2] = cosf(yaw) * cosf(pitch);
+        ray.maxDistance = 64.0f;
+    }
+
+    std::vector<RaycastHit> hits(rayCount), reference(rayCount);
+    RaycastStats stats;
+    int mismatches = 0, hitCount = 0;
+    double start = NowSeconds();
+    for (int i = 0; i < rayCount; i++) reference[i] = ReferenceRaycast(world, rays[i]);
+    double referenceTime = NowSeconds() - start;
+    start = NowSeconds();
+    for (int i = 0; i < rayCount; i++) hits[i] = RaycastBlocks(world, rays[i], &stats);
+    double fastTime = NowSeconds() - start;
+    for (int i = 0; i < rayCount; i++) {
+        const RaycastHit& a = hits[i];
+        const RaycastHit& b = reference[i];
+        bool same = a.hit == b.hit;
+        if (same && a.hit) {
+            same = fabsf(a.distance - b.distance) < 1e-3f;
+            for (int k = 0; k < 3; k++) same = same && a.block[k] == b.block[k] && a.normal[k] == b.normal[k];
+        }
+        if (!same) mismatches++;
+        if (a.hit) hitCount++;
+    }
+    printf("[raycast] %d rays up to 64 blocks: %d hit, %d differ from the plain DDA\n", rayCount, hitCount, mismatches);
+    printf("[raycast] plain DDA %.2f M rays/s, with skipping %.2f M rays/s (%.2fx), %.1f cells tested and %.1f spans skipped per ray\n",
+        rayCount / referenceTime * 1e-6, rayCount / fastTime * 1e-6, referenceTime / fastTime,
+        (double)stats.cellsVisited / rayCount, (double)stats.spansSkipped / rayCount);
+
+    // Line of sight between random pairs of eyes up to 48 blocks apart.
+    const int pairCount = 200000;
+    std::vector<float> from(pairCount * 3), to(pairCount * 3);
+    for (int i = 0; i < pairCount; i++) {
+        float x = (random01() * 2.0f - 1.0f) * span, z = (random01() * 2.0f - 1.0f) * span;
+        float angle = random01() * 6.2831853f, distance = random01() * 48.0f;
+        float tx = std::min(std::max(x + sinf(angle) * distance, -span), span);
+        float tz = std::min(std::max(z + cosf(angle) * distance, -span), span);
+        from[i * 3 + 0] = x;  from[i * 3 + 1] = world.GetGroundHeight(x, z) + 1.3f;   from[i * 3 + 2] = z;
+        to[i * 3 + 0] = tx;   to[i * 3 + 1] = world.GetGroundHeight(tx, tz) + 1.3f;   to[i * 3 + 2] = tz;
+    }
+    std::vector<uint8_t> visible(pairCount), visibleThreaded(pairCount);
+    start = NowSeconds();
+    LineOfSightBatch(world, from.data(), to.data(), pairCount, visible.data());
+    double serialTime = NowSeconds() - start;
+
+    JobSystem jobs;
+    start = NowSeconds();
+    LineOfSightBatch(world, from.data(), to.data(), pairCount, visibleThreaded.data(), &jobs);
+    double threadedTime = NowSeconds() - start;
+    int seen = 0;
+    for (int i = 0; i < pairCount; i++) seen += visible[i];
+    printf("[raycast] line of sight: %d of %d pairs visible, %.2f M checks/s on 1 thread, %.2f M checks/s on %d threads, results %s\n",
+        seen, pairCount, pairCount / serialTime * 1e-6, pairCount / threadedTime * 1e-6, jobs.ThreadCount() + 1,
+        visible == visibleThreaded ? "identical" : "DIFFERENT");
+}
+
+// Paletted block storage: a long run of random edits checked against a plain array (forcing the
+// palette to widen and narrow), memory per generated chunk, and Get/Set throughput next to a raw
+// byte array.
+static void BenchBlocks() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[blocks] %-54s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+
+    PalettedBlocks storage(CHUNK_BLOCKS);
+    std::vector<uint8_t> shadow(CHUNK_BLOCKS, BLOCK_AIR);
+    unsigned int rng = 3;
+    auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return rng >> 8; };
+    bool matches = true;
+    int widest = 0;
+    for (int phase = 0; phase < 4; phase++) {
+        int types = (phase == 1) ? 200 : (phase == 2) ? 5 : 2;   // Grow to 8 bits, then back down
+        for (int i = 0; i < 200000; i++) {
+            int index = (int)(next() % CHUNK_BLOCKS);
+            uint8_t block = (uint8_t)(next() % types);
+            storage.Set(index, block);
+            shadow[index] = block;
+            widest = std::max(widest, storage.Bits());
+        }
+        for (int i = 0; i < CHUNK_BLOCKS; i++) matches = matches && storage.Get(i) == shadow[i];
+    }
+    std::vector<uint8_t> unpacked(CHUNK_BLOCKS);
+    storage.Unpack(unpacked.data());
+    check("800k random edits read back like a plain array", matches && unpacked == shadow);
+    // Two live types keep a spare slot, so the indices stay at 2 bits rather than 1.
+    check("palette widened to 8 bits and narrowed back to 2", widest == 8 && storage.Bits() == 2 && storage.PaletteSize() == 2);
+    for (int i = 0; i < CHUNK_BLOCKS; i++) storage.Set(i, BLOCK_STONE);
+    check("uniform chunk stores no indices", storage.Bits() == 0 && storage.Get(123) == BLOCK_STONE);
+
+    // Memory over a square of generated terrain.
+    VoxelWorld world(4096);
+    world.Reset(BenchTerrainConfig());
+    const int radius = 8;
+    int widthCount[9] = {};
+    for (int cx = -radius; cx < radius; cx++) {
+        for (int cz = -radius; cz < radius; cz++) {
+            const Chunk& chunk = world.GetChunk({ cx, cz });
+            widthCount[chunk.blocks.Bits()]++;
+        }
+    }
+    int chunkCount = (int)world.ChunkCount();
+    double perChunk = (double)world.BlockMemoryBytes() / chunkCount;
+    printf("[blocks] %d generated chunks: %.0f bytes/chunk vs %d raw (%.1fx smaller), index widths:", chunkCount, perChunk, CHUNK_BLOCKS, CHUNK_BLOCKS / perChunk);
+    for (int b = 0; b <= 8; b++) if (widthCount[b]) printf(" %d bits x%d", b, widthCount[b]);
+    printf("\n");
+
+    // Throughput on a typical chunk.
+    const Chunk& sample = world.GetChunk({ 0, 0 });
+    PalettedBlocks packed = sample.blocks;
+    std::vector<uint8_t> raw(CHUNK_BLOCKS);
+    packed.Unpack(raw.data());
+    const int rounds = 400;
+    std::vector<int> order(CHUNK_BLOCKS);
+    for (int i = 0; i < CHUNK_BLOCKS; i++) order[i] = (int)(next() % CHUNK_BLOCKS);
+
+    volatile unsigned sink = 0;
+    auto timeGets = [&](bool random, bool usePacked) {
+        unsigned sum = 0;
+        double start = NowSeconds();
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < CHUNK_BLOCKS; i++) {
+                int index = random ? order[i] : i;
+                sum += usePacked ? packed.Get(index) : raw[index];
+            }
+        sink = sink + sum;
+        return (double)rounds * CHUNK_BLOCKS / (NowSeconds() - start) * 1e-6;
+    };
+    auto timeSets = [&](bool random, bool usePacked) {
+        double start = NowSeconds();
+        for (int r = 0; r < rounds; r++)
+            for (int i = 0; i < CHUNK_BLOCKS; i++) {
+                int index = random ? order[i] : i;
+                uint8_t block = (uint8_t)((r + i) & 1 ? BLOCK_DIRT : BLOCK_STONE);
+                if (usePacked) packed.Set(index, block); else raw[index] = block;
+            }
+        sink = sink + raw[0];
+        return (double)rounds * CHUNK_BLOCKS / (NowSeconds() - start) * 1e-6;
+    };
+    printf("[blocks] %d-bit chunk, M ops/s (paletted / raw): sequential get %.0f / %.0f, random get %.0f / %.0f\n", packed.Bits(),
+        timeGets(false, true), timeGets(false, false), timeGets(true, true), timeGets(true, false));
+    printf("[blocks] sequential set %.0f / %.0f, random set %.0f / %.0f\n",
+        timeSets(false, true), timeSets(false, false), timeSets(true, true), timeSets(true, false));
+
+    double start = NowSeconds();
+    for (int r = 0; r < rounds; r++) sample.blocks.Unpack(raw.data());
+    printf("[blocks] unpack for meshing: %.2f us/chunk\n", (NowSeconds() - start) * 1e6 / rounds);
+    printf("[blocks] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+static bool SameBlocks(const Chunk& a, const Chunk& b) {
+    for (int i = 0; i < CHUNK_BLOCKS; i++) if (a.blocks.Get(i) != b.blocks.Get(i)) return false;
+    return memcmp(a.topY, b.topY, sizeof(a.topY)) == 0 && a.maxTopY == b.maxTopY;
+}
+
+// Saves a 64x64 chunk world (four regions) with some blocks dug out, reopens it cold and loads
+// every chunk back, then keeps overwriting one region until it compacts. Round trips are compared
+// block for block; load speed is compared with generating the same chunks.
+static void BenchRegions() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[regions] %-54s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    std::error_code ec;
+    std::string directory = (std::filesystem::temp_directory_path(ec) / "bench_3d_regions").string();
+    std::filesystem::remove_all(directory, ec);
+
+    const int side = 64;
+    const TerrainConfig terrain = BenchTerrainConfig();
+    std::vector<Chunk> chunks(side * side);
+    double start = NowSeconds();
+    for (int i = 0; i < side * side; i++) GenerateChunk(terrain, { i % side - side / 2, i / side - side / 2 }, chunks[i]);
+    double generateTime = NowSeconds() - start;
+    unsigned int rng = 11;
+    for (Chunk& chunk : chunks) {
+        for (int hole = 0; hole < 16; hole++) {
+            rng = rng * 1664525u + 1013904223u;
+            int lx = (rng >> 8) % CHUNK_SIZE, lz = (rng >> 12) % CHUNK_SIZE, ly = (rng >> 16) % CHUNK_HEIGHT;
+            chunk.Set(lx, ly, lz, (rng >> 24) & 1 ? BLOCK_AIR : BLOCK_STONE);
+        }
+        chunk.RecomputeTopY();
+    }
+
+    RegionStoreStats saved;
+    {
+        RegionStore store(directory);
+        start = NowSeconds();
+        for (const Chunk& chunk : chunks) ok = store.SaveChunk(chunk) && ok;
+        double saveTime = NowSeconds() - start;
+        saved = store.Stats();
+        printf("[regions] saved %d chunks in %.1f ms (%.0f chunks/s, %.1f MB/s), %.0f bytes/chunk on disk vs %d raw\n",
+            (int)saved.chunksSaved, saveTime * 1000.0, saved.chunksSaved / saveTime, saved.bytesWritten / saveTime / 1e6,
+            (double)saved.bytesWritten / saved.chunksSaved, CHUNK_BLOCKS);
+    }
+
+    {
+        start = NowSeconds();
+        RegionStore store(directory, 2);
+        Chunk first;
+        bool loadedFirst = store.LoadChunk(chunks[0].coord, first);
+        double openTime = NowSeconds() - start;
+        printf("[regions] cold open + first chunk: %.3f ms\n", openTime * 1000.0);
+
+        int same = 0, read = 0;
+        Chunk loaded;
+        start = NowSeconds();
+        for (const Chunk& chunk : chunks) read += store.LoadChunk(chunk.coord, loaded) ? 1 : 0;
+        double loadTime = NowSeconds() - start;
+        for (const Chunk& chunk : chunks) if (store.LoadChunk(chunk.coord, loaded) && SameBlocks(loaded, chunk)) same++;
+        check("every chunk reads back identical", loadedFirst && read == side * side && same == side * side);
+        check("at most 2 regions mapped at once", store.OpenRegions() <= 2);
+        check("unsaved chunk reports missing", !store.LoadChunk({ 1000, 1000 }, loaded));
+        printf("[regions] loaded %d chunks in %.1f ms: %.0f chunks/s vs %.0f chunks/s generating\n", read, loadTime * 1000.0,
+            side * side / loadTime, side * side / generateTime);
+    }
+
+    {
+        RegionStore store(directory);
+        uint64_t before = std::filesystem::file_size(store.RegionPath({ 0, 0 }), ec);
+        std::vector<Chunk*> region;
+        for (Chunk& chunk : chunks) if (RegionCoordOf(chunk.coord) == RegionCoord{ 0, 0 }) region.push_back(&chunk);
+        uint64_t largest = before;
+        for (int round = 0; round < 3; round++) {
+            for (Chunk* chunk : region) {
+                chunk->Set(round, CHUNK_HEIGHT - 1, 0, BLOCK_SNOW);
+                chunk->RecomputeTopY();
+                store.SaveChunk(*chunk);
+                largest = std::max(largest, (uint64_t)std::filesystem::file_size(store.RegionPath({ 0, 0 }), ec));
+            }
+        }
+        uint64_t after = std::filesystem::file_size(store.RegionPath({ 0, 0 }), ec);
+        int same = 0;
+        Chunk loaded;
+        for (Chunk* chunk : region) if (store.LoadChunk(chunk->coord, loaded) && SameBlocks(loaded, *chunk)) same++;
+        printf("[regions] 3 rewrites of region (0, 0): %llu KB -> peak %llu KB -> %llu KB, %d compactions\n",
+            (unsigned long long)(before / 1024), (unsigned long long)(largest / 1024), (unsigned long long)(after / 1024), (int)store.Stats().compactions);
+        check("compaction keeps the file under twice its live size", store.Stats().compactions > 0 && after < before * 2);
+        check("latest version of every chunk reads back", same == (int)region.size());
+    }
+    std::filesystem::remove_all(directory, ec);
+    printf("[regions] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Edit storm: with a 12x12 chunk area meshed, three diggers tear through the terrain at 60 frames
+// per second, a burst of edits each per frame (many on chunk borders), while DirtyChunks feeds at
+// most four remeshes per frame into the builder. Reports how long edits wait for their mesh, then
+// checks the last mesh of every touched chunk against a fresh mesh of its final blocks.
+static void BenchEdits() {
+    const int radius = 6;
+    VoxelWorld world(4096);
+    world.Reset(BenchTerrainConfig());
+    ChunkBuilder builder;
+    std::unordered_map<ChunkCoord, ChunkMesh, ChunkCoordHash> meshes;
+    std::vector<ChunkMesh> finished;
+    std::vector<ChunkRequest> requests;
+    while ((int)meshes.size() < (2 * radius - 2) * (2 * radius - 2)) {
+        finished.clear();
+        builder.Poll(world, finished);
+        for (ChunkMesh& mesh : finished) meshes[mesh.coord] = std::move(mesh);
+        requests.clear();
+        for (int cx = -radius + 1; cx < radius - 1; cx++)
+            for (int cz = -radius + 1; cz < radius - 1; cz++)
+                if (!meshes.count({ cx, cz })) requests.push_back({ { cx, cz }, (float)(cx * cx + cz * cz) });
+        builder.Schedule(world, requests);
+        std::this_thread::yield();
+    }
+
+    DirtyChunks dirty(4, 1 << 16);     // Window large enough to keep every sample of the storm
+    VoxelLighting lighting;
+    std::vector<ChunkCoord> relit;
+    const int frames = 240, editsPerFrame = 12;
+    const double frameTime = 1.0 / 60.0;
+    float diggers[3][2] = { { -40.0f, -30.0f }, { 30.0f, -10.0f }, { 0.0f, 40.0f } };
+    unsigned int rng = 5;
+    auto random01 = [&rng]() { rng = rng * 1664525u + 1013904223u; return (float)(rng >> 8) / (float)(1 << 24); };
+    std::unordered_map<ChunkCoord, int, ChunkCoordHash> touched;
+    int edits = 0, remeshes = 0, worstStarted = 0;
+    double busiest = 0.0;
+    double start = NowSeconds();
+    for (int frame = 0; frame < frames || dirty.Pending() > 0 || dirty.InFlight() > 0; frame++) {
+        double frameStart = NowSeconds();
+        if (frame < frames) {
+            for (int e = 0; e < editsPerFrame; e++) {
+                float* d = diggers[e % 3];
+                d[0] = std::min(std::max(d[0] + (random01() - 0.5f) * 3.0f, -70.0f), 70.0f);
+                d[1] = std::min(std::max(d[1] + (random01() - 0.5f) * 3.0f, -70.0f), 70.0f);
+                int x = (int)floorf(d[0] + 0.5f), z = (int)floorf(d[1] + 0.5f);
+                int y = world.GetTopBlockY(x, z) - (int)(random01() * 2.0f);
+                if (world.SetBlock(x, y, z, (e & 3) ? BLOCK_AIR : BLOCK_STONE)) {
+                    lighting.BlockChanged(x, y, z);
+                    dirty.MarkBlock(x, z, NowSeconds());
+                    touched[ChunkCoordOf(x, z)]++;
+                    edits++;
+                }
+            }
+        }
+        // Same order as RenderGraphics(): collect finished meshes, relight, then start new remeshes.
+        finished.clear();
+        builder.Poll(world, finished);
+        for (ChunkMesh& mesh : finished) {
+            dirty.Finished(mesh.coord, NowSeconds());
+            meshes[mesh.coord] = std::move(mesh);
+        }
+        relit.clear();
+        lighting.Update(world, &builder.Jobs(), relit);
+        for (ChunkCoord c : relit) dirty.MarkChunk(c, NowSeconds());
+        int started = dirty.Flush(world, builder);
+        worstStarted = std::max(worstStarted, started);
+        remeshes += started;
+        busiest = std::max(busiest, NowSeconds() - frameStart);
+        while (NowSeconds() - frameStart < frameTime) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double elapsed = NowSeconds() - start;
+
+    // Every mesh, not just the edited chunks: a border edit must have rebuilt the neighbour too.
+    int chunksWithEdits = (int)touched.size(), correct = 0;
+    for (const auto& entry : meshes) {
+        ChunkMesh fresh;
+        MeshChunk(GetNeighborhood(world, entry.first), fresh);
+        const ChunkMesh& last = entry.second;
+        if (fresh.vertices.size() == last.vertices.size() && memcmp(fresh.vertices.data(), last.vertices.data(), fresh.vertices.size() * sizeof(Vertex)) == 0) correct++;
+    }
+    printf("[edits] %d edits in %d chunks over %.1f s: %d remeshes (%.1f edits merged per remesh), at most %d started per frame\n",
+        edits, chunksWithEdits, elapsed, remeshes, (double)dirty.EditsMarked / std::max(remeshes, 1), worstStarted);
+    const double percentiles[4] = { 50.0, 90.0, 99.0, 100.0 };
+    double latency[4];
+    dirty.LatencyPercentiles(percentiles, latency, 4);
+    printf("[edits] edit-to-mesh latency: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms; busiest frame %.2f ms of CPU on the frame thread\n",
+        latency[0] * 1000.0, latency[1] * 1000.0, latency[2] * 1000.0, latency[3] * 1000.0, busiest * 1000.0);
+    printf("[edits] final meshes match a fresh rebuild in %d of %d chunks %s\n", correct, (int)meshes.size(), correct == (int)meshes.size() ? "OK" : "FAILED");
+}
+
+// From-scratch light for chunks [lo, hi] on both axes: seeds every column and emitter, then one
+// breadth-first flood per channel. Everything outside the square is treated as absent.
+static void ReferenceLight(const VoxelWorld& world, int lo, int hi, std::vector<uint8_t>& light) {
+    const int size = (hi - lo + 1) * CHUNK_SIZE, origin = lo * CHUNK_SIZE;
+    auto index = [size](int x, int y, int z) { return (y * size + z) * size + x; };
+    std::vector<uint8_t> solid(size * size * CHUNK_HEIGHT);
+    light.assign(solid.size(), 0);
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            const Chunk* chunk = world.FindChunk(ChunkCoordOf(origin + x, origin + z));
+            int lx = origin + x - chunk->OriginX(), lz = origin + z - chunk->OriginZ();
+            bool open = true;
+            for (int y = CHUNK_HEIGHT - 1; y >= 0; y--) {
+                uint8_t block = chunk->Get(lx, y, lz);
+                solid[index(x, y, z)] = IsSolidBlock(block);
+                open = open && !IsSolidBlock(block);
+                light[index(x, y, z)] = (uint8_t)((open ? LIGHT_OPEN_SKY : 0) | BlockEmission(block));
+            }
+        }
+    }
+    for (int shift = 4; shift >= 0; shift -= 4) {
+        std::vector<int> queue;
+        for (int i = 0; i < (int)light.size(); i++) if ((light[i] >> shift) & 15) queue.push_back(i);
+        for (size_t head = 0; head < queue.size(); head++) {
+            int i = queue[head], level = (light[i] >> shift) & 15;
+            int x = i % size, z = (i / size) % size, y = i / (size * size);
+            const int step[6][3] = { { -1, 0, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, -1, 0 }, { 0, 1, 0 } };
+            for (const int* d : step) {
+                int nx = x + d[0], ny = y + d[1], nz = z + d[2];
+                if (nx < 0 || nx >= size || nz < 0 || nz >= size || ny < 0 || ny >= CHUNK_HEIGHT) continue;
+                int n = index(nx, ny, nz);
+                if (solid[n]) continue;
+                int reached = (shift == 4 && level == MAX_LIGHT && d[1] == -1) ? MAX_LIGHT : level - 1;
+                if (((light[n] >> shift) & 15) < reached) {
+                    light[n] = (uint8_t)((light[n] & ~(15 << shift)) | reached << shift);
+                    queue.push_back(n);
+                }
+            }
+        }
+    }
+}
+
+// Blocks in chunks [lo, hi] whose stored light differs from ReferenceLight().
+static int CountLightMismatches(const VoxelWorld& world, int lo, int hi) {
+    std::vector<uint8_t> reference;
+    ReferenceLight(world, lo, hi, reference);
+    const int size = (hi - lo + 1) * CHUNK_SIZE, origin = lo * CHUNK_SIZE;
+    int wrong = 0;
+    for (int y = 0; y < CHUNK_HEIGHT; y++)
+        for (int z = 0; z < size; z++)
+            for (int x = 0; x < size; x++)
+                if (world.GetLight(origin + x, y + WORLD_MIN_Y, origin + z) != reference[(y * size + z) * size + x]) wrong++;
+    return wrong;
+}
+
+// One random edit of the kind that needs a flood fill: a cave dug under the surface, a floating
+// block that casts a shadow, or a lamp placed or taken away.
+static bool RandomLightEdit(VoxelWorld& world, VoxelLighting& lighting, unsigned int& rng, int lo, int hi, int* editedX = nullptr, int* editedZ = nullptr) {
+    auto next = [&rng](int n) { rng = rng * 1664525u + 1013904223u; return (int)((rng >> 8) % (unsigned)n); };
+    int span = (hi - lo + 1) * CHUNK_SIZE;
+    int x = lo * CHUNK_SIZE + next(span), z = lo * CHUNK_SIZE + next(span);
+    int top = world.GetTopBlockY(x, z);
+    int kind = next(4);
+    int y = 0;
+    uint8_t block = BLOCK_AIR;
+    if (kind == 0)      { y = top - 1 - next(5); block = BLOCK_AIR; }
+    else if (kind == 1) { y = top + 2 + next(3); block = BLOCK_STONE; }
+    else if (kind == 2) { y = top - 1 - next(4); block = BLOCK_LAMP; }
+    else                { y = top - 1 - next(5); block = (next(2) == 0) ? BLOCK_LAMP : BLOCK_AIR; }
+    if (y < WORLD_MIN_Y + 1 || y > WORLD_MAX_Y || !world.SetBlock(x, y, z, block)) return false;
+    lighting.BlockChanged(x, y, z);
+    if (editedX) *editedX = x;
+    if (editedZ) *editedZ = z;
+    return true;
+}
+
+// Flood-fill light: incremental relights after edits and full passes over loaded chunks, both
+// against a from-scratch flood of the whole area, the same light whatever the thread count, and
+// the latency of relighting after a single edit.
+static void BenchLight() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[light] %-56s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    const int lo = -4, hi = 3;              // Loaded chunks
+    const int editLo = -3, editHi = 2;      // Edited chunks, so light stays inside the loaded ones
+    int threads = std::max(4, (int)std::thread::hardware_concurrency());
+    JobSystem jobs(threads);
+
+    // The same edit stream on two worlds, relit on the calling thread and across the job system.
+    VoxelWorld serialWorld(1024), parallelWorld(1024);
+    serialWorld.Reset(BenchTerrainConfig());
+    parallelWorld.Reset(BenchTerrainConfig());
+    for (int cx = lo; cx <= hi; cx++)
+        for (int cz = lo; cz <= hi; cz++) { serialWorld.GetChunk({ cx, cz }); parallelWorld.GetChunk({ cx, cz }); }
+    VoxelLighting serial, parallel;
+    std::vector<ChunkCoord> remesh;
+    unsigned int serialRng = 3, parallelRng = 3;
+    int edits = 0, batches = 0, mismatchedBatches = 0, worstMismatch = 0;
+    bool sameLight = true;
+    double serialTime = 0.0, parallelTime = 0.0;
+    for (int batch = 0; batch < 40; batch++) {
+        int count = (batch < 20) ? 1 + batch : 200;     // Growing batches, then storms across every chunk
+        for (int e = 0; e < count; e++) {
+            edits += RandomLightEdit(serialWorld, serial, serialRng, editLo, editHi);
+            RandomLightEdit(parallelWorld, parallel, parallelRng, editLo, editHi);
+        }
+        double start = NowSeconds();
+        serial.Update(serialWorld, nullptr, remesh);
+        serialTime += NowSeconds() - start;
+        start = NowSeconds();
+        parallel.Update(parallelWorld, &jobs, remesh);
+        parallelTime += NowSeconds() - start;
+        batches++;
+        if (batch % 4 == 3 || batch == 39) {
+            int wrong = CountLightMismatches(serialWorld, lo, hi);
+            if (wrong) mismatchedBatches++;
+            worstMismatch = std::max(worstMismatch, wrong);
+        }
+        for (int cx = lo; cx <= hi && sameLight; cx++)
+            for (int cz = lo; cz <= hi && sameLight; cz++)
+                sameLight = memcmp(serialWorld.FindChunk({ cx, cz })->light, parallelWorld.FindChunk({ cx, cz })->light, CHUNK_BLOCKS) == 0;
+    }
+    printf("[light] %d edits in %d batches: %.2f ms relighting on one thread, %.2f ms across %d workers (%zu tasks)\n",
+        edits, batches, serialTime * 1000.0, parallelTime * 1000.0, jobs.ThreadCount(), serial.EditPasses);
+    check("incremental relights match a flood from scratch", mismatchedBatches == 0);
+    check("same light on one thread and across the job system", sameLight);
+    if (worstMismatch) printf("[light] worst batch: %d blocks differ\n", worstMismatch);
+
+    // The edited chunks reloaded as if from disk: seed light only, then full passes.
+    VoxelWorld reloaded(1024);
+    reloaded.Reset(BenchTerrainConfig());
+    std::vector<ChunkCoord> inserted;
+    for (int cx = lo; cx <= hi; cx++) {
+        for (int cz = lo; cz <= hi; cz++) {
+            std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+            chunk->coord = { cx, cz };
+            chunk->blocks = serialWorld.FindChunk({ cx, cz })->blocks;
+            chunk->RecomputeTopY();
+            reloaded.InsertChunk(chunk);
+            inserted.push_back(chunk->coord);
+        }
+    }
+    VoxelLighting fresh;
+    fresh.ChunksInserted(reloaded, inserted);
+    double start = NowSeconds();
+    fresh.Update(reloaded, &jobs, remesh);
+    double fullTime = NowSeconds() - start;
+    printf("[light] %zu full passes over reloaded chunks in %.2f ms (%zu waiting on unloaded neighbours)\n", fresh.FullPasses, fullTime * 1000.0, fresh.Pending());
+    check("full passes over reloaded chunks match a flood from scratch", CountLightMismatches(reloaded, lo, hi) == 0);
+
+    // A sealed cave in untouched terrain: a lamp lights it one level less per block, and taking it
+    // away leaves it dark.
+    VoxelWorld caveWorld(64);
+    caveWorld.Reset(BenchTerrainConfig());
+    for (int cx = -1; cx <= 1; cx++)
+        for (int cz = -1; cz <= 1; cz++) caveWorld.GetChunk({ cx, cz });
+    VoxelLighting caveLight;
+    int caveX = 5, caveZ = 5, caveY = WORLD_MAX_Y;
+    for (int dx = -1; dx <= 5; dx++)
+        for (int dz = -1; dz <= 1; dz++) caveY = std::min(caveY, caveWorld.GetTopBlockY(caveX + dx, caveZ + dz) - 2);
+    for (int dx = 0; dx < 5; dx++)
+        if (caveWorld.SetBlock(caveX + dx, caveY, caveZ, BLOCK_AIR)) caveLight.BlockChanged(caveX + dx, caveY, caveZ);
+    caveLight.Update(caveWorld, nullptr, remesh);
+    bool dark = caveWorld.GetLight(caveX + 2, caveY, caveZ) == 0;
+    caveWorld.SetBlock(caveX, caveY, caveZ, BLOCK_LAMP);
+    caveLight.BlockChanged(caveX, caveY, caveZ);
+    caveLight.Update(caveWorld, nullptr, remesh);
+    bool lit = caveWorld.GetLight(caveX + 4, caveY, caveZ) == MAX_LIGHT - 4;
+    caveWorld.SetBlock(caveX, caveY, caveZ, BLOCK_AIR);
+    caveLight.BlockChanged(caveX, caveY, caveZ);
+    caveLight.Update(caveWorld, nullptr, remesh);
+    bool darkAgain = caveWorld.GetLight(caveX + 4, caveY, caveZ) == 0 && caveWorld.GetLight(caveX, caveY, caveZ) == 0;
+    check("sealed cave: dark, lit by a lamp, dark again without it", dark && lit && darkAgain);
+
+    // Latency of one edit: relight, then remesh every chunk whose light changed.
+    std::vector<double> relight, total;
+    std::vector<size_t> relitCounts;
+    ChunkMesh mesh;
+    unsigned int rng = 17;
+    for (int sample = 0; sample < 300; sample++) {
+        int x = 0, z = 0;
+        if (!RandomLightEdit(serialWorld, serial, rng, editLo, editHi, &x, &z)) continue;
+        remesh.clear();
+        double editStart = NowSeconds();
+        serial.Update(serialWorld, nullptr, remesh);
+        relight.push_back(NowSeconds() - editStart);
+        for (ChunkCoord c : remesh)
+            if (serialWorld.FindChunk(c)) MeshChunk(GetNeighborhood(serialWorld, c), mesh);
+        total.push_back(NowSeconds() - editStart);
+        relitCounts.push_back(remesh.size());
+    }
+    auto percentile = [](std::vector<double> v, double p) { std::sort(v.begin(), v.end()); return v[std::min(v.size() - 1, (size_t)(p / 100.0 * (v.size() - 1) + 0.5))]; };
+    double meanRelit = 0.0;
+    for (size_t n : relitCounts) meanRelit += (double)n / relitCounts.size();
+    printf("[light] single edit (%zu samples): relight p50 %.3f ms, p99 %.3f ms, max %.3f ms; with remeshing %.1f chunks: p50 %.3f ms, p99 %.3f ms\n",
+        relight.size(), percentile(relight, 50) * 1000.0, percentile(relight, 99) * 1000.0, percentile(relight, 100) * 1000.0,
+        meanRelit, percentile(total, 50) * 1000.0, percentile(total, 99) * 1000.0);
+    check("relight after the latency run still matches from scratch", CountLightMismatches(serialWorld, lo, hi) == 0);
+    printf("[light] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Flies a camera over the world the way main_3d.cpp streams it: builder Poll(), then the
+// streamer's Update() each 60 Hz frame. Warm-up at the origin after an edit there, a 10 s flight
+// away from it, pacing back and forth over a chunk border, a flight back to check the edit came
+// back from the region files, and a teleport. Reports the Update() times against the budget, the
+// worst overrun and the resident set, and checks the camera never stands in an unloaded chunk.
+static void BenchStreaming() {
+    VoxelWorld world(1 << 16);   // Never evicts by count; the streamer unloads
+    world.Reset(BenchTerrainConfig());
+    std::error_code ec;
+    std::string directory = (std::filesystem::temp_directory_path(ec) / "bench_3d_streaming").string();
+    std::filesystem::remove_all(directory, ec);
+    RegionStore store(directory);
+    ChunkBuilder builder;
+    builder.Store = &store;
+    ChunkStreamer streamer;
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[streaming] %-58s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+
+    std::vector<ChunkMesh> finished;
+    std::vector<double> updateMs;
+    size_t maxResident = 0, maxMemory = 0;
+    int framesMissing = 0, frames = 0;
+    auto frame = [&](float x, float z, float forwardX, float forwardZ) {
+        double frameStart = NowSeconds();
+        finished.clear();
+        builder.Poll(world, finished);
+        streamer.Update(world, builder, &store, x, z, forwardX, forwardZ);
+        updateMs.push_back(streamer.Stats.updateMs);
+        maxResident = std::max(maxResident, streamer.Stats.resident);
+        maxMemory = std::max(maxMemory, streamer.Stats.memoryBytes);
+        frames++;
+        while (NowSeconds() - frameStart < 1.0 / 60.0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    };
+    auto settle = [&](float x, float z, float forwardX, float forwardZ) {
+        int n = 0;
+        do { frame(x, z, forwardX, forwardZ); n++; } while (streamer.Stats.pending > 0 || streamer.Stats.loadsStarted > 0);
+        return n;
+    };
+    auto cameraChunkLoaded = [&world](float x, float z) { return world.FindChunk(ChunkCoordOf((int)floorf(x + 0.5f), (int)floorf(z + 0.5f))) != nullptr; };
+
+    int warmup = settle(0.0f, 0.0f, 1.0f, 0.0f);
+    const int editX = 3, editZ = 5;
+    int editY = world.GetTopBlockY(editX, editZ) + 1;
+    bool edited = world.SetBlock(editX, editY, editZ, BLOCK_LAMP);
+    printf("[streaming] warm-up: %d chunks resident after %d frames\n", (int)streamer.Stats.resident, warmup);
+
+    // Out along +x at 24 blocks/s, weaving in z.
+    float x = 0.0f, z = 0.0f;
+    size_t loadsBefore = streamer.Stats.totalLoads;
+    for (int f = 0; f < 600; f++) {
+        float forwardZ = 0.5f * cosf(f * 0.01f);
+        x += 24.0f / 60.0f;
+        z += forwardZ * 24.0f / 60.0f;
+        frame(x, z, 1.0f, forwardZ);
+        if (!cameraChunkLoaded(x, z)) framesMissing++;
+    }
+    bool editUnloaded = world.FindChunk(ChunkCoordOf(editX, editZ)) == nullptr;
+    size_t flightLoads = streamer.Stats.totalLoads - loadsBefore;
+
+    // Pace +-12 blocks around a chunk border; only the first swing may load anything.
+    float borderX = (float)(FloorDiv((int)x, CHUNK_SIZE) * CHUNK_SIZE) - 0.5f;
+    size_t churnBefore = 0;
+    for (int f = 0; f < 480; f++) {
+        if (f == 120) churnBefore = streamer.Stats.totalLoads + streamer.Stats.totalUnloads;
+        float px = borderX + 12.0f * sinf(f * (2.0f * 3.14159265f / 120.0f));
+        frame(px, z, cosf(f * (2.0f * 3.14159265f / 120.0f)) >= 0.0f ? 1.0f : -1.0f, 0.0f);
+    }
+    size_t churn = streamer.Stats.totalLoads + streamer.Stats.totalUnloads - churnBefore;
+
+    // Straight back home, where the edited chunk must come back from the region files.
+    x = borderX;
+    float backX = -x / 600.0f, backZ = -z / 600.0f;
+    for (int f = 0; f < 600; f++) {
+        x += backX; z += backZ;
+        frame(x, z, backX, backZ);
+        if (!cameraChunkLoaded(x, z)) framesMissing++;
+    }
+    settle(0.0f, 0.0f, -1.0f, 0.0f);
+    bool editRestored = cameraChunkLoaded((float)editX, (float)editZ) && world.GetBlock(editX, editY, editZ) == BLOCK_LAMP;
+
+    // Teleport far away facing +z: the first loads go ahead of the camera, apart from the nearest
+    // chunks around it, which the player stands on.
+    const float teleportX = 5000.0f, teleportZ = 3000.0f;
+    frame(teleportX, teleportZ, 0.0f, 1.0f);
+    int ahead = 0, behind = 0;
+    for (ChunkCoord c : streamer.Started()) {
+        float dz = (c.z + 0.5f) * CHUNK_SIZE - 0.5f - teleportZ;
+        if (dz > CHUNK_SIZE) ahead++;
+        else if (dz < -CHUNK_SIZE) behind++;
+    }
+    int teleportFrames = settle(teleportX, teleportZ, 0.0f, 1.0f) + 1;
+
+    // Edit every resident chunk, then teleport away again: all of them unload edited in the next
+    // frames, and their saves, which may compact a region file, must stay off the frame.
+    struct Edit { int x, y, z; };
+    std::vector<Edit> edits;
+    std::vector<std::shared_ptr<Chunk>> resident;
+    world.ForEachChunk([&resident](const std::shared_ptr<Chunk>& chunk) { resident.push_back(chunk); });
+    for (const std::shared_ptr<Chunk>& chunk : resident) {
+        Edit e = { chunk->OriginX() + 7, 0, chunk->OriginZ() + 7 };
+        e.y = world.GetTopBlockY(e.x, e.z) + 1;
+        if (world.SetBlock(e.x, e.y, e.z, BLOCK_LAMP)) edits.push_back(e);
+    }
+    resident.clear();
+    size_t stormStart = updateMs.size();
+    size_t unloadsBefore = streamer.Stats.totalUnloads;
+    size_t mostSaving = 0;
+    do {
+        frame(-teleportX, -teleportZ, 0.0f, -1.0f);
+        mostSaving = std::max(mostSaving, streamer.Stats.saving);
+    } while (streamer.Stats.pending > 0 || streamer.Stats.loadsStarted > 0 || streamer.Stats.totalUnloads - unloadsBefore < edits.size());
+    double stormWorstMs = *std::max_element(updateMs.begin() + stormStart, updateMs.end());
+    builder.WaitForSaves();
+    int editsSaved = 0;
+    for (const Edit& e : edits) {
+        Chunk saved;
+        ChunkCoord coord = ChunkCoordOf(e.x, e.z);
+        if (store.LoadChunk(coord, saved) && saved.Get(e.x - saved.OriginX(), e.y - WORLD_MIN_Y, e.z - saved.OriginZ()) == BLOCK_LAMP) editsSaved++;
+    }
+
+    // Unload an edited chunk by hand: while its save is pending neither Load() nor a neighbour's
+    // mesh request in Schedule() may bring the stale copy back, and a second save of the chunk
+    // lands after the first.
+    ChunkCoord savedCoord = ChunkCoordOf((int)-teleportX, (int)-teleportZ);
+    std::shared_ptr<Chunk> first = world.RemoveChunk(savedCoord);
+    bool reloadRefused = false, neighbourRefused = false, lastSaveWins = false;
+    if (first) {
+        first->Set(0, CHUNK_HEIGHT - 1, 0, BLOCK_LAMP);
+        std::shared_ptr<Chunk> second = std::make_shared<Chunk>(*first);
+        second->Set(1, CHUNK_HEIGHT - 1, 0, BLOCK_LAMP);
+        builder.Save(store, first);
+        builder.Save(store, second);
+        reloadRefused = !builder.Load(world, savedCoord);
+        std::vector<ChunkRequest> neighbour = { { { savedCoord.x + 1, savedCoord.z }, 0.0f } };
+        builder.Schedule(world, neighbour);
+        neighbourRefused = !builder.IsGenerating(savedCoord);
+        builder.WaitForSaves();
+        Chunk saved;
+        lastSaveWins = store.LoadChunk(savedCoord, saved) && saved.Get(0, CHUNK_HEIGHT - 1, 0) == BLOCK_LAMP &&
+                       saved.Get(1, CHUNK_HEIGHT - 1, 0) == BLOCK_LAMP;
+    }
+
+    std::vector<double> sorted(updateMs);
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5))]; };
+    int perAxis = (2 * streamer.UnloadRadius + CHUNK_SIZE - 1) / CHUNK_SIZE + 1;
+    size_t residentBound = (size_t)(perAxis * perAxis + streamer.MaxPending);
+
+    printf("[streaming] %d frames: %zu loads, %zu unloads (%zu during the 10 s flight out)\n", frames,
+        streamer.Stats.totalLoads, streamer.Stats.totalUnloads, flightLoads);
+    printf("[streaming] Update(): p50 %.3f ms, p99 %.3f ms, max %.3f ms against a %.1f ms budget; worst overrun %.3f ms\n",
+        percentile(50), percentile(99), sorted.back(), streamer.BudgetMs, streamer.Stats.worstOverrunMs);
+    printf("[streaming] resident: at most %zu chunks (bound %zu), %.0f KB at most, %zu now\n",
+        maxResident, residentBound, maxMemory / 1024.0, streamer.Stats.resident);
+    printf("[streaming] teleport: %d loads ahead / %d behind in the first frame, settled after %d frames\n", ahead, behind, teleportFrames);
+    printf("[streaming] edited unload: %d of %d edited chunks saved, up to %zu saves in flight, Update() max %.3f ms\n",
+        editsSaved, (int)edits.size(), mostSaving, stormWorstMs);
+
+    check("camera chunk resident on every frame of the flights", framesMissing == 0);
+    check("pacing over a chunk border loads and unloads nothing", churn == 0);
+    check("resident set stays within the unload radius", maxResident <= residentBound);
+    check("edited chunk unloaded, saved and loaded back", edited && editUnloaded && editRestored);
+    check("first loads favour chunks ahead of the camera", ahead > 0 && ahead >= 4 * behind);
+    check("every edited chunk unloaded after the teleport is saved", !edits.empty() && editsSaved == (int)edits.size());
+    check("a chunk being saved is not reloaded, nor as a neighbour", reloadRefused && neighbourRefused);
+    check("a second save of a chunk lands after the first", lastSaveWins);
+    check("unloading edited chunks stays under two budgets", stormWorstMs < 2.0 * streamer.BudgetMs);
+    check("worst overrun stays under one budget", streamer.Stats.worstOverrunMs < streamer.BudgetMs);
+    printf("[streaming] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+    std::filesystem::remove_all(directory, ec);
+}
+
+// What VS() did before the matrices: four trig calls per vertex, then the hand-rolled projection.
+static Vec4 ShaderTrigClip(const float p[3], const float eye[3], float yaw, float pitch, float fovScale, float aspect, float nearZ) {
+    float v[3] = { p[0] - eye[0], p[1] - eye[1], p[2] - eye[2] };
+    float c = cosf(yaw), s = sinf(yaw);
+    float t[3] = { v[0] * c - v[2] * s, v[1], v[0] * s + v[2] * c };
+    c = cosf(pitch); s = sinf(pitch);
+    float f[3] = { t[0], t[1] * c - t[2] * s, t[1] * s + t[2] * c };
+    return { f[0] * fovScale, f[1] * fovScale * aspect, f[2] - nearZ, f[2] };
+}
+
+// Unit checks for CameraMath.h against plain loops and the shader's old trig path, then batch
+// transform throughput.
+static void BenchMath() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[math] %-54s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+    unsigned int rng = 11;
+    auto random = [&rng](float lo, float hi) { rng = rng * 1664525u + 1013904223u; return lo + (hi - lo) * (float)(rng >> 8) / (float)(1 << 24); };
+    auto close = [](float a, float b, float tolerance) { return fabsf(a - b) <= tolerance * std::max(1.0f, std::max(fabsf(a), fabsf(b))); };
+
+    // Products and transforms against a plain row-times-column loop.
+    bool productsMatch = true, transformsMatch = true, identityKeeps = true;
+    for (int round = 0; round < 1000; round++) {
+        Mat4 a, b;
+        for (int r = 0; r < 4; r++)
+            for (int c = 0; c < 4; c++) { a.Set(r, c, random(-4.0f, 4.0f)); b.Set(r, c, random(-4.0f, 4.0f)); }
+        Mat4 ab = Mat4Multiply(a, b), ai = Mat4Multiply(a, Mat4::Identity());
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 4; c++) {
+                double sum = 0.0;
+                for (int k = 0; k < 4; k++) sum += (double)a.At(r, k) * b.At(k, c);
+                productsMatch = productsMatch && close(ab.At(r, c), (float)sum, 1e-5f);
+                identityKeeps = identityKeeps && ai.At(r, c) == a.At(r, c);
+            }
+        }
+        Vec4 v = { random(-100.0f, 100.0f), random(-100.0f, 100.0f), random(-100.0f, 100.0f), 1.0f };
+        Vec4 out = Mat4Transform(a, v), point = Mat4TransformPoint(a, v.x, v.y, v.z);
+        const float* o = &out.x;
+        for (int r = 0; r < 4; r++) {
+            double sum = (double)a.At(r, 0) * v.x + (double)a.At(r, 1) * v.y + (double)a.At(r, 2) * v.z + a.At(r, 3);
+            double magnitude = fabs(a.At(r, 0) * v.x) + fabs(a.At(r, 1) * v.y) + fabs(a.At(r, 2) * v.z) + fabs(a.At(r, 3));
+            transformsMatch = transformsMatch && fabs(o[r] - sum) <= 1e-6 * magnitude;
+        }
+        transformsMatch = transformsMatch && memcmp(&out, &point, sizeof(Vec4)) == 0;
+    }
+    check("Mat4Multiply matches a plain loop", productsMatch);
+    check("multiplying by the identity changes nothing", identityKeeps);
+    check("Mat4Transform / Mat4TransformPoint match a plain loop", transformsMatch);
+
+    // Camera matrices against the shader's old per-vertex trig.
+    bool sameClip = true, sameForward = true, fullMatchesRelative = true, sameFrustum = true;
+    for (int round = 0; round < 1000; round++) {
+        float eye[3] = { random(-50.0f, 50.0f), random(-5.0f, 30.0f), random(-50.0f, 50.0f) };
+        float yaw = random(-6.0f, 6.0f), pitch = random(-1.5f, 1.5f), aspect = random(0.5f, 2.5f);
+        CameraMatrices camera = CameraMatrices::FromCamera(eye[0], eye[1], eye[2], yaw, pitch, CAMERA_FOV_SCALE, aspect, CAMERA_NEAR);
+        for (int k = 0; k < 8; k++) {
+            float p[3] = { eye[0] + random(-40.0f, 40.0f), eye[1] + random(-40.0f, 40.0f), eye[2] + random(-40.0f, 40.0f) };
+            Vec4 mine = camera.ToClip(p[0], p[1], p[2]), old = ShaderTrigClip(p, eye, yaw, pitch, CAMERA_FOV_SCALE, aspect, CAMERA_NEAR);
+            Vec4 full = Mat4TransformPoint(camera.viewProj, p[0], p[1], p[2]);
+            const float* a = &mine.x; const float* b = &old.x; const float* f = &full.x;
+            for (int c = 0; c < 4; c++) {
+                sameClip = sameClip && fabsf(a[c] - b[c]) <= 1e-4f;
+                fullMatchesRelative = fullMatchesRelative && fabsf(a[c] - f[c]) <= 1e-4f;
+            }
+        }
+        const float forward[3] = { sinf(yaw) * cosf(pitch), sinf(pitch), cosf(yaw) * cosf(pitch) };
+        Vec4 ahead = Mat4TransformPoint(camera.view, eye[0] + camera.forward[0], eye[1] + camera.forward[1], eye[2] + camera.forward[2]);
+        for (int a = 0; a < 3; a++) sameForward = sameForward && fabsf(camera.forward[a] - forward[a]) <= 1e-6f;
+        sameForward = sameForward && fabsf(ahead.x) <= 1e-5f && fabsf(ahead.y) <= 1e-5f && fabsf(ahead.z - 1.0f) <= 1e-5f;
+
+        // The planes must accept exactly the points whose clip coordinates are inside.
+        Frustum frustum = Frustum::FromCamera(camera);
+        for (int k = 0; k < 32; k++) {
+            float p[3] = { eye[0] + random(-40.0f, 40.0f), eye[1] + random(-40.0f, 40.0f), eye[2] + random(-40.0f, 40.0f) };
+            Vec4 clip = camera.ToClip(p[0], p[1], p[2]);
+            const float conditions[5] = { clip.w + clip.x, clip.w - clip.x, clip.w + clip.y, clip.w - clip.y, clip.z };
+            for (int i = 0; i < Frustum::PLANE_COUNT; i++) {
+                const Plane& plane = frustum.planes[i];
+                float distance = plane.nx * p[0] + plane.ny * p[1] + plane.nz * p[2] + plane.d;
+                if (fabsf(conditions[i]) > 1e-3f) sameFrustum = sameFrustum && ((distance >= 0.0f) == (conditions[i] >= 0.0f));
+            }
+        }
+    }
+    check("clip coordinates match the old shader trig", sameClip);
+    check("viewProj agrees with eye-relative relativeViewProj", fullMatchesRelative);
+    check("forward is the view's +z axis", sameForward);
+    check("frustum planes agree with the clip-space test", sameFrustum);
+
+    // The aspect ratio from the viewport keeps pixels square: a view-space offset of (1, 1) lands
+    // as many pixels right as up.
+    bool square = true;
+    const int sizes[3][2] = { { 800, 600 }, { 1920, 1080 }, { 600, 900 } };
+    for (const auto& size : sizes) {
+        CameraMatrices camera = CameraMatrices::FromCamera(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, CAMERA_FOV_SCALE, (float)size[0] / size[1], CAMERA_NEAR);
+        Vec4 clip = camera.ToClip(1.0f, 1.0f, 10.0f);
+        float right = clip.x / clip.w * size[0] * 0.5f, up = clip.y / clip.w * size[1] * 0.5f;
+        square = square && close(right, up, 1e-5f);
+    }
+    check("viewport aspect gives square pixels", square);
+
+    // Throughput over a chunk-sized vertex array, read in place at the Vertex stride.
+    const size_t count = 1 << 20;
+    std::vector<Vertex> vertices(count);
+    for (Vertex& v : vertices) v = { random(-100.0f, 100.0f), random(-6.0f, 25.0f), random(-100.0f, 100.0f), 1.0f, 1.0f, 1.0f, 1.0f };
+    std::vector<Vec4> out(count), batched(count);
+    const float eye[3] = { 3.0f, 12.0f, -4.0f };
+    const float yaw = 0.7f, pitch = 0.3f;
+    const int reps = 8;
+
+    double start = NowSeconds();
+    for (int r = 0; r < reps; r++)
+        for (size_t i = 0; i < count; i++) out[i] = ShaderTrigClip(&vertices[i].x, eye, yaw + r * 1e-3f, pitch, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+    double trigRate = count * reps / (NowSeconds() - start) * 1e-6;
+
+    start = NowSeconds();
+    CameraMatrices camera;
+    for (int r = 0; r < reps; r++) {
+        camera = CameraMatrices::FromCamera(eye[0], eye[1], eye[2], yaw + r * 1e-3f, pitch, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+        for (size_t i = 0; i < count; i++) out[i] = Mat4TransformPoint(camera.viewProj, vertices[i].x, vertices[i].y, vertices[i].z);
+    }
+    double pointRate = count * reps / (NowSeconds() - start) * 1e-6;
+
+    start = NowSeconds();
+    for (int r = 0; r < reps; r++) {
+        camera = CameraMatrices::FromCamera(eye[0], eye[1], eye[2], yaw + r * 1e-3f, pitch, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+        TransformPoints(camera.viewProj, &vertices[0].x, count, sizeof(Vertex) / sizeof(float), batched.data());
+    }
+    double batchRate = count * reps / (NowSeconds() - start) * 1e-6;
+    check("TransformPoints matches Mat4TransformPoint bit for bit", memcmp(out.data(), batched.data(), count * sizeof(Vec4)) == 0);
+
+    printf("[math] %zu vertices: per-vertex trig %.0f M/s, matrix per point %.0f M/s, batched %.0f M/s (%.1fx the trig path)\n",
+        count, trigRate, pointRate, batchRate, batchRate / trigRate);
+    printf("[math] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// FNV-1a over the visible part of a frame.
+static unsigned long long HashFrame(const SoftwareRasterizer& raster) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (int y = 0; y < raster.Height(); y++) {
+        const uint8_t* bytes = (const uint8_t*)(raster.Pixels() + (size_t)y * raster.Stride());
+        for (int i = 0; i < raster.Width() * 4; i++) { hash ^= bytes[i]; hash *= 1099511628211ULL; }
+    }
+    return hash;
+}
+
+// Straightforward double-precision rasterizer to hold SoftwareRasterizer against: every
+// triangle tests every pixel of its bounding box with barycentrics, no tiles, planes or SIMD.
+static void ReferenceRaster(const std::vector<ChunkMesh>& meshes, const std::vector<uint8_t>& visible, const double cam[3], double yaw, double pitch,
+                            int width, int height, std::vector<uint32_t>& color) {
+    const double c = cos(yaw), s = sin(yaw), cp = cos(pitch), sp = sin(pitch);
+    const double rows[3][3] = { { c, 0.0, -s }, { -s * sp, cp, -c * sp }, { s * cp, sp, c * cp } };
+    const double scaleX = CAMERA_FOV_SCALE * 0.5 * width, scaleY = CAMERA_FOV_SCALE * CAMERA_ASPECT * 0.5 * height;
+    color.assign((size_t)width * height, SoftwareRasterizer::PackColor(0.6f, 0.8f, 1.0f, 1.0f));
+    std::vector<double> depth((size_t)width * height, 0.0);
+    struct V { double p[3], col[4]; };
+
+    auto drawTriangle = [&](const V& a, const V& b, const V& d) {
+        const V* v[3] = { &a, &b, &d };
+        double x[3], y[3], w[3];
+        for (int k = 0; k < 3; k++) {
+            w[k] = 1.0 / v[k]->p[2];
+            x[k] = width * 0.5 + v[k]->p[0] * w[k] * scaleX;
+            y[k] = height * 0.5 - v[k]->p[1] * w[k] * scaleY;
+        }
+        double area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (area <= 0.0) return;
+        int x0 = std::max((int)floor(std::min(x[0], std::min(x[1], x[2]))), 0), x1 = std::min((int)ceil(std::max(x[0], std::max(x[1], x[2]))), width - 1);
+        int y0 = std::max((int)floor(std::min(y[0], std::min(y[1], y[2]))), 0), y1 = std::min((int)ceil(std::max(y[0], std::max(y[1], y[2]))), height - 1);
+        for (int py = y0; py <= y1; py++) {
+            for (int px = x0; px <= x1; px++) {
+                double sx = px + 0.5, sy = py + 0.5, bary[3];
+                bool inside = true;
+                for (int k = 0; k < 3; k++) {
+                    int n = (k + 1) % 3, o = (k + 2) % 3;
+                    bary[o] = ((x[n] - x[k]) * (sy - y[k]) - (y[n] - y[k]) * (sx - x[k])) / area;
+                    inside = inside && bary[o] >= 0.0;
+                }
+                if (!inside) continue;
+                double invZ = bary[0] * w[0] + bary[1] * w[1] + bary[2] * w[2];
+                size_t index = (size_t)py * width + px;
+                if (invZ <= depth[index]) continue;
+                depth[index] = invZ;
+                float out[4];
+                for (int ch = 0; ch < 4; ch++) out[ch] = (float)((bary[0] * v[0]->col[ch] * w[0] + bary[1] * v[1]->col[ch] * w[1] + bary[2] * v[2]->col[ch] * w[2]) / invZ);
+                color[index] = SoftwareRasterizer::PackColor(out[0], out[1], out[2], out[3]);
+            }
+        }
+    };
+
+    for (size_t m = 0; m < meshes.size(); m++) {
+        if (!visible[m]) continue;
+        const std::vector<Vertex>& vertices = meshes[m].vertices;
+        for (size_t i = 0; i + 3 <= vertices.size(); i += 3) {
+            V view[3];
+            for (int k = 0; k < 3; k++) {
+                const Vertex& src = vertices[i + k];
+                double d[3] = { src.x - cam[0], src.y - cam[1], src.z - cam[2] };
+                for (int r = 0; r < 3; r++) view[k].p[r] = rows[r][0] * d[0] + rows[r][1] * d[1] + rows[r][2] * d[2];
+                view[k].col[0] = src.r; view[k].col[1] = src.g; view[k].col[2] = src.b; view[k].col[3] = src.a;
+            }
+            V poly[4];
+            int count = 0;
+            for (int k = 0; k < 3; k++) {
+                const V& a = view[k];
+                const V& b = view[(k + 1) % 3];
+                bool aIn = a.p[2] >= CAMERA_NEAR, bIn = b.p[2] >= CAMERA_NEAR;
+                if (aIn) poly[count++] = a;
+                if (aIn != bIn) {
+                    double t = (CAMERA_NEAR - a.p[2]) / (b.p[2] - a.p[2]);
+                    for (int d = 0; d < 3; d++) poly[count].p[d] = a.p[d] + (b.p[d] - a.p[d]) * t;
+                    for (int d = 0; d < 4; d++) poly[count].col[d] = a.col[d] + (b.col[d] - a.col[d]) * t;
+                    count++;
+                }
+            }
+            for (int k = 1; k + 1 < count; k++) drawTriangle(poly[0], poly[k], poly[k + 1]);
+        }
+    }
+}
+
+// Renders a fixed scene headlessly: every LOD ring around a spot on a hillside, frustum culled the
+// way RenderGraphics() does it. The frame has to come out bit-identical on any number of threads
+// and agree with ReferenceRaster() apart from pixels right on triangle edges, where float and
+// double can disagree about coverage, and hash to kRasterGoldenHash.
+//
+// The golden hash covers terrain generation, meshing, lighting, culling and rasterization. A change
+// that alters the picture on purpose updates it to the value the run prints, after looking at the PPM.
+static const unsigned long long kRasterGoldenHash = 0x11ff85abc6533f50ull;
+
+static void BenchRaster() {
+    bool ok = true;
+    auto check = [&ok](const char* what, bool pass) {
+        printf("[raster] %-54s %s\n", what, pass ? "OK" : "FAILED");
+        ok = ok && pass;
+    };
+
+    VoxelWorld world(1 << 16);
+    world.Reset(BenchTerrainConfig());
+    const int spotX = 20, spotZ = -12;
+    world.GetChunk(ChunkCoordOf(spotX, spotZ));
+    const float camX = (float)spotX, camZ = (float)spotZ, camY = world.GetGroundHeight(camX, camZ) + 1.3f + 3.0f;
+    const float yaw = 0.7f, pitch = -0.2f;
+
+    std::vector<ChunkMesh> meshes;
+    const int reach = kLodRingRadius[LOD_LEVELS - 1] / CHUNK_SIZE + 1;
+    ChunkCoord camChunk = ChunkCoordOf(spotX, spotZ);
+    for (int cx = camChunk.x - reach; cx <= camChunk.x + reach; cx++) {
+        for (int cz = camChunk.z - reach; cz <= camChunk.z + reach; cz++) {
+            int level = LodLevelForChunk({ cx, cz }, spotX, spotZ);
+            if (level < 0) continue;
+            meshes.emplace_back();
+            if (level == 0) MeshChunk(GetNeighborhood(world, { cx, cz }), meshes.back());
+            else MeshLodTile(world.Terrain, { cx, cz }, level, meshes.back());
+        }
+    }
+    CameraMatrices camera = CameraMatrices::FromCamera(camX, camY, camZ, yaw, pitch, CAMERA_FOV_SCALE, CAMERA_ASPECT, CAMERA_NEAR);
+    Frustum frustum = Frustum::FromCamera(camera);
+    AabbBatch boxes;
+    for (const ChunkMesh& mesh : meshes) boxes.Add(mesh.boundsMin, mesh.boundsMax);
+    std::vector<uint8_t> visible(boxes.Count());
+    CullStats frustumStats;
+    CullAabbs(frustum, boxes, visible.data(), frustumStats);
+
+    const int width = 800, height = 600;
+    const float sky[4] = { 0.6f, 0.8f, 1.0f, 1.0f };
+    SoftwareRasterizer raster;
+    raster.Resize(width, height);
+    auto renderFrame = [&](JobSystem* jobs, double* setupMs, double* rasterMs) {
+        double start = NowSeconds();
+        raster.BeginFrame(camera, sky);
+        for (size_t i = 0; i < meshes.size(); i++) if (visible[i]) raster.AddMesh(meshes[i].vertices.data(), meshes[i].vertices.size());
+        double mid = NowSeconds();
+        raster.Render(jobs);
+        if (setupMs) *setupMs += (mid - start) * 1000.0;
+        if (rasterMs) *rasterMs += (NowSeconds() - mid) * 1000.0;
+        return HashFrame(raster);
+    };
+
+    unsigned long long golden = renderFrame(nullptr, nullptr, nullptr);
+    const RasterStats stats = raster.Stats;
+    std::vector<uint32_t> frame(raster.Pixels(), raster.Pixels() + (size_t)raster.Stride() * height);
+    printf("[raster] %dx%d, %d of %d chunks/tiles after the frustum, %d triangles in, %d drawn, %d tile bin entries\n", width, height,
+        frustumStats.visible, (int)meshes.size(), stats.trianglesIn, stats.trianglesDrawn, stats.binEntries);
+
+    const int reps = 20;
+    int maxThreads = std::max(4, (int)std::thread::hardware_concurrency());
+    bool sameEverywhere = true;
+    double singleMs = 0.0;
+    for (int threads = 0; threads <= maxThreads; threads = threads ? threads * 2 : 1) {
+        JobSystem* jobs = threads ? new JobSystem(threads) : nullptr;
+        double setupMs = 0.0, rasterMs = 0.0;
+        for (int r = 0; r < reps; r++) sameEverywhere = renderFrame(jobs, &setupMs, &rasterMs) == golden && sameEverywhere;
+        if (!threads) singleMs = rasterMs;
+        printf("[raster] %-10s setup %.2f ms, raster %.2f ms (%.2fx), %.1f M triangles/s end to end\n",
+            threads ? (std::to_string(threads + 1) + " threads").c_str() : "caller", setupMs / reps, rasterMs / reps, singleMs / rasterMs,
+            stats.trianglesIn * reps / ((setupMs + rasterMs) * 1000.0));
+        delete jobs;
+    }
+    check("same frame with or without workers, any thread count", sameEverywhere);
+
+    std::vector<uint32_t> reference;
+    const double cam[3] = { camX, camY, camZ };
+    ReferenceRaster(meshes, visible, cam, yaw, pitch, width, height, reference);
+    int differing = 0, colorOff = 0, sky_ = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint32_t mine = frame[(size_t)y * raster.Stride() + x], theirs = reference[(size_t)y * width + x];
+            if (mine == SoftwareRasterizer::PackColor(sky[0], sky[1], sky[2], sky[3])) sky_++;
+            if (mine == theirs) continue;
+            differing++;
+            int worst = 0;
+            for (int ch = 0; ch < 4; ch++) worst = std::max(worst, abs((int)((mine >> (ch * 8)) & 255) - (int)((theirs >> (ch * 8)) & 255)));
+            if (worst <= 1) colorOff++;
+        }
+    }
+    printf("[raster] vs double-precision reference: %d pixels differ (%d by one step of rounding), %.1f%% sky\n",
+        differing, colorOff, sky_ * 100.0 / (width * height));
+    check("terrain fills most of the frame", sky_ < width * height / 2);
+    check("matches the reference on all but 0.1% of pixels", differing <= width * height / 1000);
+
+    std::error_code ec;
+    std::string image = (std::filesystem::temp_directory_path(ec) / "bench_3d_raster.ppm").string();
+    raster.BeginFrame(camera, sky);
+    for (size_t i = 0; i < meshes.size(); i++) if (visible[i]) raster.AddMesh(meshes[i].vertices.data(), meshes[i].vertices.size());
+    raster.Render();
+    check("frame written to a PPM", raster.SaveImage(image.c_str()));
+    printf("[raster] frame hash %016llx (golden %016llx), image %s\n", golden, kRasterGoldenHash, image.c_str());
+    check("frame matches the golden image", golden == kRasterGoldenHash);
+    printf("[raster] %s\n", ok ? "all checks passed" : "SOME CHECKS FAILED");
+}
+
+// Generates and meshes a square of chunks through ChunkBuilder, driving Schedule()/Poll() the way
+// the frame loop does, for a growing number of worker threads.
+static void BenchJobs() {
+    const int radius = 6;
+    int maxThreads = std::max(4, (int)std::thread::hardware_concurrency());
+    double singleRate = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        VoxelWorld world(4096);
+        world.Reset(BenchTerrainConfig());
+        ChunkBuilder builder(threads);
+
+        std::vector<ChunkRequest> requests;
+        std::vector<ChunkMesh> finished;
+        long long vertices = 0;
+        int meshed = 0;
+        const int wanted = (2 * radius) * (2 * radius);
+        std::vector<uint8_t> done(wanted, 0);
+        double start = NowSeconds();
+        while (meshed < wanted) {
+            finished.clear();
+            builder.Poll(world, finished);
+            for (const ChunkMesh& mesh : finished) {
+                vertices += (long long)mesh.vertices.size();
+                done[(mesh.coord.x + radius) * (2 * radius) + (mesh.coord.z + radius)] = 1;
+                meshed++;
+            }
+            requests.clear();
+            for (int cx = -radius; cx < radius; cx++)
+                for (int cz = -radius; cz < radius; cz++)
+                    if (!done[(cx + radius) * (2 * radius) + (cz + radius)]) requests.push_back({ { cx, cz }, (float)(cx * cx + cz * cz) });
+            builder.Schedule(world, requests);
+            std::this_thread::yield();
+        }
+        double elapsed = NowSeconds() - start;
+        double rate = wanted / elapsed;
+        if (threads == 1) singleRate = rate;
+        printf("[jobs] %2d threads: %d chunks generated, %d meshed in %.1f ms, %.0f chunks/s (%.2fx), %lld vertices\n",
+            threads, (int)builder.ChunksGenerated, meshed, elapsed * 1000.0, rate, rate / singleRate, vertices);
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+}
+
+struct BenchEntry {
+    const char* name;
+    void (*fn)();
+};
+
+static const BenchEntry kBenches[] = {
+    { "terrain", BenchTerrain },
+    { "mesher", BenchMesher },
+    { "ao", BenchAo },
+    { "frustum", BenchFrustum },
+    { "jobs", BenchJobs },
+    { "lod", BenchLod },
+    { "occlusion", BenchOcclusion },
+    { "physics", BenchPhysics },
+    { "ticks", BenchTicks },
+    { "raycast", BenchRaycast },
+    { "blocks", BenchBlocks },
+    { "regions", BenchRegions },
+    { "edits", BenchEdits },
+    { "light", BenchLight },
+    { "streaming", BenchStreaming },
+    { "raster", BenchRaster },
+    { "math", BenchMath },
+};
+
+int main(int argc, char** argv) {
+    bool ranAny = false;
+    for (const BenchEntry& bench : kBenches) {
+        if (argc > 1 && strcmp(argv[1], bench.name) != 0) continue;
+        bench.fn();
+        ranAny = true;
+    }
+    if (!ranAny) {
+        printf("Unknown benchmark '%s'. Available:", argv[1]);
+        for (const BenchEntry& bench : kBenches) printf(" %s", bench.name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
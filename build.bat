@@ -1,2 +1,4 @@
 g++ main_3d.cpp imgui.cpp imgui_draw.cpp imgui_tables.cpp imgui_widgets.cpp imgui_demo.cpp imgui_impl_dx11.cpp imgui_impl_win32.cpp -o main.exe -ld3d11 -ld3dcompiler -ldwmapi -lgdi32 -ldxgi -ldxguid -static -static-libgcc -static-libstdc++
+g++ -O2 bench_3d.cpp -o bench_3d.exe -static -static-libgcc -static-libstdc++
+g++ -O2 bench_2d.cpp imgui.cpp imgui_draw.cpp imgui_tables.cpp imgui_widgets.cpp -o bench_2d.exe -static -static-libgcc -static-libstdc++
 pause
\ No newline at end of file
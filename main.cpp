@@ -7,11 +7,12 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-#include <math.h> // For sqrt()
-#include <stdlib.h> // For rand()
-
 #include <vector>
 
+#include "GalleDodgeSim.h"
+#include "FixedTimestep.h"
+#include "CircleSprite.h"
+
 static ID3D11Device* g_pd3dDevice = nullptr;
 static ID3D11DeviceContext* g_pd3dDeviceContext = nullptr;
 static IDXGISwapChain* g_pSwapChain = nullptr;
@@ -25,43 +26,29 @@ void CreateRenderTarget();
 void CleanupRenderTarget();
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
-struct Enemy {
-    ImVec2 position; 
-    ImVec2 velocity; 
-};
-
-static std::vector<Enemy> enemies;
-
-static float spawn_timer = 0.0f;
-static float current_spawn_rate = 2.0f; // Start: Spawn 1 enemy every 2 seconds
-
-static float pos_x = 100.0f;
-static float pos_y = 100.0f;
-
-const float MAX_SPRINT_TIME = 1.0f;  // Can run for 1 seconds
-const float COOLDOWN_TIME   = 1.5f;  // Must wait 1.5 seconds if overheated
-
-static float sprint_timer   = 0.0f;  // How long we've been running
-static float cooldown_timer = 0.0f;  // Timer for the penalty
+static DodgeGame game;                              // Player, enemies, timers and score (GalleDodgeSim.h)
+static FixedTimestep game_clock(1.0f / 120.0f);     // The rules always step at 120 Hz, whatever the frame rate
+static uint32_t games_started = 0;
+static CircleSprite enemy_sprite;                   // Baked into the font atlas on the first frame
 
 int game_state = 0; 
 
-int score = 0;
 int high_score = 0;
 
-void ResetGame() {
-    score = 0;
-    high_score = (score > high_score) ? score : high_score;
-    
-    pos_x = 100.0f;
-    pos_y = 100.0f;
-    sprint_timer = 0.0f;
-    cooldown_timer = 0.0f;
-
-    enemies.clear();
+void ResetGame(float width, float height) {
+    game.Reset(++games_started, width, height); // Each game gets the next seed, back to easy mode
+    game_clock.Reset();
+}
 
-    spawn_timer = 0.0f;
-    current_spawn_rate = 2.0f; // Reset to easy mode
+// The keys held this frame as the simulation's input bits.
+static uint32_t ReadDodgeInput() {
+    uint32_t input = 0;
+    if (ImGui::IsKeyDown(ImGuiKey_LeftArrow) || ImGui::IsKeyDown(ImGuiKey_A)) input |= DODGE_LEFT;
+    if (ImGui::IsKeyDown(ImGuiKey_RightArrow)|| ImGui::IsKeyDown(ImGuiKey_D)) input |= DODGE_RIGHT;
+    if (ImGui::IsKeyDown(ImGuiKey_UpArrow)   || ImGui::IsKeyDown(ImGuiKey_W)) input |= DODGE_UP;
+    if (ImGui::IsKeyDown(ImGuiKey_DownArrow) || ImGui::IsKeyDown(ImGuiKey_S)) input |= DODGE_DOWN;
+    if (ImGui::IsKeyDown(ImGuiKey_LeftShift) || ImGui::IsKeyDown(ImGuiKey_RightShift)) input |= DODGE_SPRINT;
+    return input;
 }
 
 bool LoadTextureFromFile(const char* filename, ID3D11ShaderResourceView** out_srv, int* out_width, int* out_height)
@@ -179,6 +166,7 @@ int main(int, char**)
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
+        if (!enemy_sprite.IsBaked()) enemy_sprite.Bake(io.Fonts);
 
         const ImGuiViewport* viewport = ImGui::GetMainViewport();
         ImGui::SetNextWindowPos(viewport->WorkPos);
@@ -202,121 +190,46 @@ int main(int, char**)
             
             if (ImGui::Button("START GAME", ImVec2(btn_width, 40.0f)) || ImGui::IsKeyPressed(ImGuiKey_Enter) || ImGui::IsKeyPressed(ImGuiKey_Space))
             {
-                ResetGame();
+                ResetGame(win_size.x, win_size.y);
                 game_state = 1; // Switch to Playing
             }
         }
         else if (game_state == 1)
         {
-            float PLAYER_SIZE = 30.0f; 
-
-            float move_speed = 150.0f; // Default "Walk" speed every frame
-
-            if (cooldown_timer > 0.0f) {
-                cooldown_timer -= dt;
-            }
-            else if (ImGui::IsKeyDown(ImGuiKey_LeftShift) || ImGui::IsKeyDown(ImGuiKey_RightShift)) {
-                move_speed = 300.0f;    
-                sprint_timer += dt;     
-                
-                if (sprint_timer >= MAX_SPRINT_TIME) {
-                    cooldown_timer = COOLDOWN_TIME; 
-                    sprint_timer = 0.0f;            
-                }
-            }
-            else {
-                float recovery_speed = 1.5f; // Recover faster than you drain
-                sprint_timer -= recovery_speed * dt;
-                if (sprint_timer < 0.0f) sprint_timer = 0.0f;
-            }
-
-            float step = move_speed * dt;
-
-            if (ImGui::IsKeyDown(ImGuiKey_LeftArrow) || ImGui::IsKeyDown(ImGuiKey_A)) pos_x -= step;
-            if (ImGui::IsKeyDown(ImGuiKey_RightArrow)|| ImGui::IsKeyDown(ImGuiKey_D)) pos_x += step;
-            if (ImGui::IsKeyDown(ImGuiKey_UpArrow)   || ImGui::IsKeyDown(ImGuiKey_W)) pos_y -= step;
-            if (ImGui::IsKeyDown(ImGuiKey_DownArrow) || ImGui::IsKeyDown(ImGuiKey_S)) pos_y += step;
-
-            if (pos_x < 0) pos_x = 0;
-            if (pos_y < 0) pos_y = 0;
-            if (pos_x > win_size.x - PLAYER_SIZE) pos_x = win_size.x - PLAYER_SIZE;
-            if (pos_y > win_size.y - PLAYER_SIZE) pos_y = win_size.y - PLAYER_SIZE;
-
-            spawn_timer -= dt;
-
-            if (spawn_timer <= 0.0f)
+            // The window may have been resized; the rules clamp and spawn against its current size.
+            game.width = win_size.x;
+            game.height = win_size.y;
+            uint32_t input = ReadDodgeInput();
+            int ticks = game_clock.Advance(dt);
+            for (int i = 0; i < ticks && !game.over; i++) StepDodge(game, input, game_clock.Step);
+            if (game.over)
             {
-                Enemy new_enemy;
-                
-                int edge = rand() % 4;
-                ImVec2 spawn;
-                if (edge == 0) spawn = ImVec2((float)(rand() % (int)win_size.x), -20);
-                else if (edge == 1) spawn = ImVec2(win_size.x + 20, (float)(rand() % (int)win_size.y));
-                else if (edge == 2) spawn = ImVec2((float)(rand() % (int)win_size.x), win_size.y + 20);
-                else spawn = ImVec2(-20, (float)(rand() % (int)win_size.y));
-
-                new_enemy.position = spawn;
-
-                float dx = pos_x - spawn.x;
-                float dy = pos_y - spawn.y;
-                float len = sqrtf(dx*dx + dy*dy);
-                if (len > 0) { dx /= len; dy /= len; }
-                
-                new_enemy.velocity = ImVec2(dx * 500.0f, dy * 500.0f);
-                
-                enemies.push_back(new_enemy);
-
-                spawn_timer = current_spawn_rate;
-
-                current_spawn_rate *= 0.98f; 
-                
-                if (current_spawn_rate < 0.2f) current_spawn_rate = 0.2f;
+                if (game.score > high_score) high_score = game.score;
+                game_state = 2; 
             }
 
-            float player_center_x = pos_x + (PLAYER_SIZE * 0.5f);
-            float player_center_y = pos_y + (PLAYER_SIZE * 0.5f);
-            float player_radius = PLAYER_SIZE * 0.4f; 
-            float enemy_radius = 20.0f;
-
-            for (int i = enemies.size() - 1; i >= 0; i--)
-            {
-                enemies[i].position.x += enemies[i].velocity.x * dt;
-                enemies[i].position.y += enemies[i].velocity.y * dt;
-
-                ImGui::GetWindowDrawList()->AddCircleFilled(enemies[i].position, enemy_radius, IM_COL32(255, 0, 0, 255));
-
-                float dx = player_center_x - enemies[i].position.x;
-                float dy = player_center_y - enemies[i].position.y;
-                if (sqrtf(dx*dx + dy*dy) < (player_radius + enemy_radius))
-                {
-                    if (score > high_score) high_score = score;
-                    game_state = 2; 
-                }
-
-                if (enemies[i].position.x < -100 || enemies[i].position.x > win_size.x + 100 ||
-                    enemies[i].position.y < -100 || enemies[i].position.y > win_size.y + 100) 
-                {
-                    score++; // Score when you dodge them successfully
-                    enemies.erase(enemies.begin() + i); // Remove from list
-                }
-            }
+            ImDrawList* draw_list = ImGui::GetWindowDrawList();
+            // One textured quad per enemy; circles only if the atlas lost the sprite.
+            if (!AddCircleSprites(draw_list, enemy_sprite, game.enemies.x.data(), game.enemies.y.data(), game.enemies.Count(), ENEMY_RADIUS, IM_COL32(255, 0, 0, 255)))
+                for (size_t i = 0; i < game.enemies.Count(); i++)
+                    draw_list->AddCircleFilled(ImVec2(game.enemies.x[i], game.enemies.y[i]), ENEMY_RADIUS, IM_COL32(255, 0, 0, 255));
 
-            ImGui::SetCursorPos(ImVec2(pos_x, pos_y));
+            ImGui::SetCursorPos(ImVec2(game.posX, game.posY));
             if (my_texture) ImGui::Image((void*)my_texture, ImVec2(PLAYER_SIZE, PLAYER_SIZE));
             else ImGui::Button("P", ImVec2(PLAYER_SIZE, PLAYER_SIZE));
 
             ImGui::SetCursorPos(ImVec2(20, 20));
-            ImGui::Text("SCORE: %d", score);
-            ImGui::Text("Spawn Rate: %.2fs", current_spawn_rate); // Debug text so you can see it getting faster
+            ImGui::Text("SCORE: %d", game.score);
+            ImGui::Text("Spawn Rate: %.2fs", game.spawnRate); // Debug text so you can see it getting faster
 
             float bar_w = 300.0f;
             ImGui::SetCursorPos(ImVec2((win_size.x - bar_w)*0.5f, win_size.y - 40));
-            if (cooldown_timer > 0) {
+            if (game.cooldownTimer > 0) {
                  ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(1,0,0,1));
-                 ImGui::ProgressBar(cooldown_timer/COOLDOWN_TIME, ImVec2(bar_w, 20), "OVERHEATED");
+                 ImGui::ProgressBar(game.cooldownTimer/COOLDOWN_TIME, ImVec2(bar_w, 20), "OVERHEATED");
                  ImGui::PopStyleColor();
             } else {
-                 ImGui::ProgressBar(sprint_timer/MAX_SPRINT_TIME, ImVec2(bar_w, 20), "Sprint");
+                 ImGui::ProgressBar(game.sprintTimer/MAX_SPRINT_TIME, ImVec2(bar_w, 20), "Sprint");
             }
         }
         else if (game_state == 2)
@@ -327,7 +240,7 @@ int main(int, char**)
             ImGui::TextColored(ImVec4(1, 0, 0, 1), title); // Red Text
 
             char score_text[64];
-            sprintf(score_text, "Score: %d", score);
+            sprintf(score_text, "Score: %d", game.score);
             w = ImGui::CalcTextSize(score_text).x;
             ImGui::SetCursorPos(ImVec2((win_size.x - w) * 0.5f, win_size.y * 0.4f));
             ImGui::Text(score_text);
@@ -341,7 +254,7 @@ int main(int, char**)
             ImGui::SetCursorPos(ImVec2((win_size.x - btn_width) * 0.5f, win_size.y * 0.6f));
             if (ImGui::Button("TRY AGAIN", ImVec2(btn_width, 40.0f)) || ImGui::IsKeyPressed(ImGuiKey_Enter) || ImGui::IsKeyPressed(ImGuiKey_Space))
             {
-                ResetGame();
+                ResetGame(win_size.x, win_size.y);
                 game_state = 1; // Restart
             }
         }
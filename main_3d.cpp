@@ -7,6 +7,25 @@
 #include <ctime>  
 #include <cstdlib> 
 #include <algorithm> // For max/min logic
+#include <chrono>
+
+#include "Terrain.h"
+#include "VoxelWorld.h"
+#include "ChunkMesher.h"
+#include "CameraMath.h"
+#include "Frustum.h"
+#include "ChunkBuilder.h"
+#include "LodMesher.h"
+#include "OcclusionCuller.h"
+#include "VoxelPhysics.h"
+#include "FixedTimestep.h"
+#include "VoxelRaycast.h"
+#include "RegionFile.h"
+#include "DirtyChunks.h"
+#include "SoftwareRasterizer.h"
+#include "VoxelLight.h"
+#include "ChunkStreamer.h"
+#include <unordered_map>
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -14,10 +33,17 @@
 static HWND g_hwnd = nullptr; 
 static bool g_MouseCaptured = false;
 
-struct TerrainConfig {
-    float seedX, seedZ;
-};
 TerrainConfig g_Terrain;
+VoxelWorld g_World;
+ChunkBuilder* g_ChunkBuilder = nullptr;
+
+// Saved world: terrain seeds in world/level.dat, edited chunks in region files under world/region.
+const char* WORLD_DIRECTORY = "world";
+RegionStore* g_Regions = nullptr;
+
+// Chunk residency follows the camera: ring 0 plus a chunk of margin is kept loaded, with 1 ms of
+// frame time for loads and unloads.
+ChunkStreamer g_Streamer;
 
 struct Camera {
     float x = 0.0f;
@@ -25,33 +51,37 @@ struct Camera {
     float z = 0.0f;
     float yaw = 0.0f;
     float pitch = 0.4f;
-    
-    float velY = 0.0f;       // Vertical speed (gravity)
-    bool isGrounded = false; // Are we touching the ground?
 };
 Camera g_Cam;
 
-float GetTerrainHeight(float worldX, float worldZ) {
-    float biome = sin((worldX + g_Terrain.seedX) * 0.05f) * cos((worldZ + g_Terrain.seedZ) * 0.05f);
-    float base = sin(worldX * 0.15f) + cos(worldZ * 0.15f);
-    float detail = sin(worldX * 0.6f) * cos(worldZ * 0.6f);
-    
-    float mountainFactor = biome; 
-    if (mountainFactor < 0.0f) mountainFactor = 0.0f; 
-    mountainFactor = mountainFactor * mountainFactor; 
-
-    float rawHeight = (base + detail) * mountainFactor * 5.0f;
-    
-    return floor(rawHeight) + 1.0f; 
+// The player is simulated at a fixed 60 Hz, two sweeps per tick; the camera shows the body
+// interpolated between the last two ticks.
+FixedTimestep g_PhysicsClock(1.0f / 60.0f);
+const int PHYSICS_SUBSTEPS = 2;
+PhysicsBody g_Player;
+float g_PlayerPrev[3] = { 0.0f, 0.0f, 0.0f };
+bool g_JumpQueued = false;  // A press waits for the next tick, which may be a frame or two away
+
+// Camera matrices for the frame, built once after the camera moves and shared by the shader,
+// culling, picking and the software renderer, and the block under the crosshair.
+CameraMatrices g_View;
+const float PICK_REACH = 8.0f;
+RaycastHit g_Target;
+
+// Chunks waiting to be remeshed after edits; at most four remeshes start per frame.
+DirtyChunks g_DirtyChunks(4);
+
+// Sky and block light; edits and newly loaded chunks are relit on the builder's threads before remeshing.
+VoxelLighting g_Lighting;
+
+void ResetPlayer(float eyeX, float eyeY, float eyeZ) {
+    g_Player = PhysicsBody();
+    g_Player.pos[0] = eyeX; g_Player.pos[1] = eyeY - PLAYER_EYE_HEIGHT; g_Player.pos[2] = eyeZ;
+    for (int i = 0; i < 3; i++) g_PlayerPrev[i] = g_Player.pos[i];
+    g_PhysicsClock.Reset();
 }
 
 void UpdateCamera(float dt) {
-    float moveSpeed = 10.0f * dt;
-    float gravity = 25.0f * dt;
-    float jumpForce = 9.0f;
-    float playerEyeHeight = 1.8f; 
-    float bodyRadius = 0.2f; 
-
     if (g_MouseCaptured && g_hwnd) {
         ImGui::SetMouseCursor(ImGuiMouseCursor_None);
         RECT rect; GetClientRect(g_hwnd, &rect);
@@ -68,60 +98,65 @@ void UpdateCamera(float dt) {
         SetCursorPos(center.x, center.y);
     }
 
+    if (!g_World.IsColumnLoaded(g_Player.pos[0], g_Player.pos[2])) return; // Still being generated off-thread
+
     float fwdX = sin(g_Cam.yaw); float fwdZ = cos(g_Cam.yaw);
     float rgtX = cos(g_Cam.yaw); float rgtZ = -sin(g_Cam.yaw);
     
-    float inputX = 0.0f; float inputZ = 0.0f;
-    if (ImGui::IsKeyDown(ImGuiKey_W)) { inputX += fwdX; inputZ += fwdZ; }
-    if (ImGui::IsKeyDown(ImGuiKey_S)) { inputX -= fwdX; inputZ -= fwdZ; }
-    if (ImGui::IsKeyDown(ImGuiKey_D)) { inputX += rgtX; inputZ += rgtZ; }
-    if (ImGui::IsKeyDown(ImGuiKey_A)) { inputX -= rgtX; inputZ -= rgtZ; }
-
-    if (inputX != 0.0f || inputZ != 0.0f) {
-        float len = sqrt(inputX * inputX + inputZ * inputZ);
-        inputX /= len; inputZ /= len;
-
-        float currentGround = GetTerrainHeight(g_Cam.x, g_Cam.z);
-        float footY = g_Cam.y - playerEyeHeight;
-        
-        float clearance = footY - (currentGround - 1.0f); // Assuming ground is drawn 1 unit down?
-
-        float nextX = g_Cam.x + inputX * moveSpeed;
-        float checkX = nextX + (inputX > 0 ? bodyRadius : -bodyRadius);
-        float groundAtX = GetTerrainHeight(checkX, g_Cam.z);
-        float stepHeightX = groundAtX - currentGround;
-
-        if (stepHeightX <= 0.0f || clearance > stepHeightX) {
-            g_Cam.x = nextX;
-        }
-
-        float nextZ = g_Cam.z + inputZ * moveSpeed;
-        float checkZ = nextZ + (inputZ > 0 ? bodyRadius : -bodyRadius);
-        float groundAtZ = GetTerrainHeight(g_Cam.x, checkZ); // Use current X (or updated X)
-        float stepHeightZ = groundAtZ - currentGround;
-
-        if (stepHeightZ <= 0.0f || clearance > stepHeightZ) {
-            g_Cam.z = nextZ;
-        }
+    PlayerInput input;
+    if (ImGui::IsKeyDown(ImGuiKey_W)) { input.moveX += fwdX; input.moveZ += fwdZ; }
+    if (ImGui::IsKeyDown(ImGuiKey_S)) { input.moveX -= fwdX; input.moveZ -= fwdZ; }
+    if (ImGui::IsKeyDown(ImGuiKey_D)) { input.moveX += rgtX; input.moveZ += rgtZ; }
+    if (ImGui::IsKeyDown(ImGuiKey_A)) { input.moveX -= rgtX; input.moveZ -= rgtZ; }
+
+    if (input.moveX != 0.0f || input.moveZ != 0.0f) {
+        float len = sqrt(input.moveX * input.moveX + input.moveZ * input.moveZ);
+        input.moveX /= len; input.moveZ /= len;
     }
-
-    if (ImGui::IsKeyPressed(ImGuiKey_Space) && g_Cam.isGrounded) {
-        g_Cam.velY = jumpForce;
-        g_Cam.isGrounded = false;
+    if (ImGui::IsKeyPressed(ImGuiKey_Space)) g_JumpQueued = true;
+
+    int ticks = g_PhysicsClock.Advance(dt);
+    for (int i = 0; i < ticks; i++) {
+        for (int k = 0; k < 3; k++) g_PlayerPrev[k] = g_Player.pos[k];
+        input.jump = g_JumpQueued;
+        g_JumpQueued = false;
+        StepPlayer(g_World, g_Player, input, g_PhysicsClock.Step, PHYSICS_SUBSTEPS);
     }
 
-    float groundHeight = GetTerrainHeight(g_Cam.x, g_Cam.z) - 1.0f + playerEyeHeight;
-    
-    g_Cam.velY -= gravity;
-    g_Cam.y += g_Cam.velY * dt;
+    float alpha = g_PhysicsClock.Alpha();
+    g_Cam.x = g_PlayerPrev[0] + (g_Player.pos[0] - g_PlayerPrev[0]) * alpha;
+    g_Cam.y = g_PlayerPrev[1] + (g_Player.pos[1] - g_PlayerPrev[1]) * alpha + PLAYER_EYE_HEIGHT;
+    g_Cam.z = g_PlayerPrev[2] + (g_Player.pos[2] - g_PlayerPrev[2]) * alpha;
+}
+
+// The aspect ratio follows the viewport the scene is drawn into.
+void UpdateView(const D3D11_VIEWPORT& viewport) {
+    float aspect = (viewport.Width > 0.0f && viewport.Height > 0.0f) ? viewport.Width / viewport.Height : CAMERA_ASPECT;
+    g_View = CameraMatrices::FromCamera(g_Cam.x, g_Cam.y, g_Cam.z, g_Cam.yaw, g_Cam.pitch, CAMERA_FOV_SCALE, aspect, CAMERA_NEAR);
+    g_Target = RaycastBlocks(g_World, g_View.eye, g_View.forward, PICK_REACH);
+}
 
-    if (g_Cam.y < groundHeight && g_Cam.velY <= 0.0f) {
-        g_Cam.y = groundHeight; 
-        g_Cam.velY = 0.0f;
-        g_Cam.isGrounded = true;
+// Left click breaks the targeted block, E places stone and Q a lamp against the targeted face
+// unless the player is standing in that cell.
+void EditBlocks() {
+    if (!g_MouseCaptured || !g_Target.hit) return;
+    int cell[3] = { g_Target.block[0], g_Target.block[1], g_Target.block[2] };
+    uint8_t block;
+    if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+        block = BLOCK_AIR;
+    } else if (ImGui::IsKeyPressed(ImGuiKey_E, false) || ImGui::IsKeyPressed(ImGuiKey_Q, false)) {
+        for (int a = 0; a < 3; a++) cell[a] += g_Target.normal[a];
+        Aabb player = g_Player.Box();
+        bool overlapsPlayer = true;
+        for (int a = 0; a < 3; a++) overlapsPlayer = overlapsPlayer && player.min[a] < cell[a] + 0.5f && player.max[a] > cell[a] - 0.5f;
+        if (overlapsPlayer) return;
+        block = ImGui::IsKeyPressed(ImGuiKey_Q, false) ? BLOCK_LAMP : BLOCK_STONE;
     } else {
-        g_Cam.isGrounded = false;
+        return;
     }
+    if (!g_World.SetBlock(cell[0], cell[1], cell[2], block)) return;
+    g_Lighting.BlockChanged(cell[0], cell[1], cell[2]);
+    g_DirtyChunks.MarkBlock(cell[0], cell[2], ImGui::GetTime());
 }
 
 class SimpleFrameBuffer {
@@ -173,20 +208,88 @@ public:
     }
 };
 
-struct Vertex {
-    float x, y, z;
-    float r, g, b, a;
+// CPU-written texture for showing the software renderer's frames through ImGui::Image. Recreated
+// when the frame size changes, otherwise rewritten in place every frame.
+class DynamicTexture {
+public:
+    ID3D11ShaderResourceView* ShaderResourceView = nullptr;
+    int Width = 0, Height = 0;
+
+    ~DynamicTexture() { Release(); }
+    void Release() {
+        if (ShaderResourceView) { ShaderResourceView->Release(); ShaderResourceView = nullptr; }
+        if (m_Texture) { m_Texture->Release(); m_Texture = nullptr; }
+        Width = Height = 0;
+    }
+    // pixels holds height rows of `stride` RGBA8 pixels.
+    bool Upload(ID3D11Device* device, ID3D11DeviceContext* context, const uint32_t* pixels, int width, int height, int stride) {
+        if (width != Width || height != Height || !m_Texture) {
+            Release();
+            D3D11_TEXTURE2D_DESC texDesc = {};
+            texDesc.Width = width; texDesc.Height = height;
+            texDesc.MipLevels = 1; texDesc.ArraySize = 1;
+            texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+            texDesc.SampleDesc.Count = 1; texDesc.Usage = D3D11_USAGE_DYNAMIC;
+            texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE; texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            if (FAILED(device->CreateTexture2D(&texDesc, nullptr, &m_Texture))) return false;
+            device->CreateShaderResourceView(m_Texture, nullptr, &ShaderResourceView);
+            Width = width; Height = height;
+        }
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(context->Map(m_Texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+        for (int y = 0; y < height; y++)
+            memcpy((uint8_t*)mapped.pData + (size_t)y * mapped.RowPitch, pixels + (size_t)y * stride, (size_t)width * sizeof(uint32_t));
+        context->Unmap(m_Texture, 0);
+        return true;
+    }
+
+private:
+    ID3D11Texture2D* m_Texture = nullptr;
 };
 
 struct CBufferData {
+    Mat4 viewProj;
     float camX, camY, camZ, padding1;
-    float camYaw, camPitch, padding2, padding3;
     float objX, objY, objZ, padding4;
-    float isTopBlock; 
-    float padding5, padding6, padding7;
 };
 
-ID3D11Buffer* g_pVertexBuffer = nullptr;
+// GPU copy of a chunk mesh. Built once when the chunk comes into range, rebuilt when it changes
+// LOD ring and dropped when it leaves the last ring.
+struct GpuChunk {
+    ID3D11Buffer* vertexBuffer = nullptr;
+    UINT vertexCount = 0;
+    int lodLevel = 0;
+    std::vector<Vertex> vertices;   // CPU copy for the Hi-Z pass and the software renderer
+    FaceCullStats cull;
+    float boundsMin[3] = { 0, 0, 0 };
+    float boundsMax[3] = { 0, 0, 0 };
+};
+std::unordered_map<ChunkCoord, GpuChunk, ChunkCoordHash> g_GpuChunks;
+
+struct RenderStats {
+    int chunksDrawn = 0;
+    int lodTilesDrawn = 0;
+    int chunksCulled = 0;
+    int chunksOccluded = 0;
+    int occluderTriangles = 0;
+    int chunksPending = 0;
+    int vertices = 0;
+    int facesKept = 0;
+    int facesCulled = 0;
+    double softwareMs = 0.0;        // Setup and raster time when the software renderer is on
+    double lightMs = 0.0;           // Relighting edits and newly loaded chunks
+};
+RenderStats g_RenderStats;
+OcclusionCuller g_Occlusion;
+const size_t OCCLUDER_TRIANGLE_BUDGET = 16384;  // Nearest chunks only; far tiles are cheaper to draw than to rasterize
+
+// F3 switches the view to the CPU rasterizer: same chunks, same culling, drawn on the builder's
+// worker threads instead of the GPU.
+bool g_SoftwareRender = false;
+SoftwareRasterizer g_Software;
+DynamicTexture g_SoftwareFrame;
+const float SKY_COLOR[4] = { 0.6f, 0.8f, 1.0f, 1.0f };
+
 ID3D11InputLayout* g_pInputLayout = nullptr;
 ID3D11VertexShader* g_pVertexShader = nullptr;
 ID3D11PixelShader* g_pPixelShader = nullptr;
@@ -195,58 +298,38 @@ ID3D11RasterizerState* g_pRasterizerState = nullptr;
 
 const char* shaderCode = R"(
 cbuffer CBuf : register(b0) { 
+    float4x4 viewProj;  // (world - camera) -> clip, built once per frame on the CPU
     float camX; float camY; float camZ; float p1;
-    float camYaw; float camPitch; float p2; float p3;
     float objX; float objY; float objZ; float p4;
-    float isTopBlock; float p5; float p6; float p7;
 }
 struct VS_Input { float3 pos : POSITION; float4 col : COLOR; };
-struct PS_Input { float4 pos : SV_POSITION; float4 col : COLOR; float worldY : TEXCOORD0; };
+struct PS_Input { float4 pos : SV_POSITION; float4 col : COLOR; };
 
 PS_Input VS(VS_Input input) {
     PS_Input output;
     float3 worldPos = input.pos + float3(objX, objY, objZ);
-    output.worldY = worldPos.y; 
-    
-    float3 viewPos = worldPos - float3(camX, camY, camZ);
-    float c = cos(camYaw); float s = sin(camYaw);
-    float3 t; t.x = viewPos.x * c - viewPos.z * s; t.y = viewPos.y; t.z = viewPos.x * s + viewPos.z * c;
-    c = cos(camPitch); s = sin(camPitch);
-    float3 f; f.x = t.x; f.y = t.y * c - t.z * s; f.z = t.y * s + t.z * c;
-    
-    float fov = 1.3; 
-    output.pos.x = f.x * fov;
-    output.pos.y = f.y * fov * 1.33; 
-    output.pos.z = f.z - 0.1; 
-    output.pos.w = f.z; 
-    
+    output.pos = mul(viewProj, float4(worldPos - float3(camX, camY, camZ), 1.0));
     output.col = input.col;
     return output;
 }
 
 float4 PS(PS_Input input) : SV_Target {
-    float h = input.worldY;
-    float4 tint = float4(1,1,1,1);
-    
-    if (isTopBlock > 0.5) {
-        if (h < -1.5)       tint = float4(0.0, 0.4, 0.8, 1.0); // Water
-        else if (h < 0.5)   tint = float4(0.2, 0.8, 0.2, 1.0); // Grass
-        else if (h < 4.0)   tint = float4(0.5, 0.5, 0.5, 1.0); // Stone
-        else                tint = float4(1.0, 1.0, 1.0, 1.0); // Snow
-    } else {
-        if (h < -3.0)       tint = float4(0.1, 0.1, 0.1, 1.0); // Bedrock
-        else                tint = float4(0.35, 0.25, 0.2, 1.0); // Dirt
-    }
-    return input.col * 0.4 + tint * 0.6;
+    return input.col; // Face shade and block tint are baked in by the chunk mesher
 }
 )";
 
 float RandomFloat() { return (float)(rand() % 1000) / 10.0f; }
 
 bool InitGraphics(ID3D11Device* device) {
-    srand((unsigned int)time(0)); 
-    g_Terrain.seedX = RandomFloat(); 
-    g_Terrain.seedZ = RandomFloat();
+    if (!ReadWorldInfo(WORLD_DIRECTORY, g_Terrain)) {
+        srand((unsigned int)time(0)); 
+        g_Terrain.seedX = RandomFloat(); 
+        g_Terrain.seedZ = RandomFloat();
+        WriteWorldInfo(WORLD_DIRECTORY, g_Terrain);
+    }
+    g_World.Reset(g_Terrain);
+    g_Lighting.Clear();
+    ResetPlayer(g_Cam.x, g_Cam.y, g_Cam.z);
 
     HRESULT hr;
     ID3DBlob* pVSBlob = nullptr; ID3DBlob* pPSBlob = nullptr;
@@ -260,21 +343,7 @@ bool InitGraphics(ID3D11Device* device) {
     device->CreateInputLayout(ied, 2, pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), &g_pInputLayout);
     pVSBlob->Release();
 
-    float l = -0.5f; float r = 0.5f; 
-    Vertex vertices[] = {
-        { l,l,l, 0.7f,0.7f,0.7f,1 }, { l,r,l, 0.7f,0.7f,0.7f,1 }, { r,r,l, 0.7f,0.7f,0.7f,1 }, { l,l,l, 0.7f,0.7f,0.7f,1 }, { r,r,l, 0.7f,0.7f,0.7f,1 }, { r,l,l, 0.7f,0.7f,0.7f,1 }, 
-        { l,l,r, 0.6f,0.6f,0.6f,1 }, { r,r,r, 0.6f,0.6f,0.6f,1 }, { l,r,r, 0.6f,0.6f,0.6f,1 }, { l,l,r, 0.6f,0.6f,0.6f,1 }, { r,l,r, 0.6f,0.6f,0.6f,1 }, { r,r,r, 0.6f,0.6f,0.6f,1 }, 
-        { l,l,r, 0.5f,0.5f,0.5f,1 }, { l,r,l, 0.5f,0.5f,0.5f,1 }, { l,l,l, 0.5f,0.5f,0.5f,1 }, { l,l,r, 0.5f,0.5f,0.5f,1 }, { l,r,r, 0.5f,0.5f,0.5f,1 }, { l,r,l, 0.5f,0.5f,0.5f,1 }, 
-        { r,l,l, 0.5f,0.5f,0.5f,1 }, { r,r,l, 0.5f,0.5f,0.5f,1 }, { r,l,r, 0.5f,0.5f,0.5f,1 }, { r,l,r, 0.5f,0.5f,0.5f,1 }, { r,r,l, 0.5f,0.5f,0.5f,1 }, { r,r,r, 0.5f,0.5f,0.5f,1 }, 
-        { l,r,l, 1.0f,1.0f,1.0f,1 }, { l,r,r, 1.0f,1.0f,1.0f,1 }, { r,r,r, 1.0f,1.0f,1.0f,1 }, { l,r,l, 1.0f,1.0f,1.0f,1 }, { r,r,r, 1.0f,1.0f,1.0f,1 }, { r,r,l, 1.0f,1.0f,1.0f,1 }, 
-        { l,l,l, 0.3f,0.3f,0.3f,1 }, { r,l,r, 0.3f,0.3f,0.3f,1 }, { l,l,r, 0.3f,0.3f,0.3f,1 }, { l,l,l, 0.3f,0.3f,0.3f,1 }, { r,l,l, 0.3f,0.3f,0.3f,1 }, { r,l,r, 0.3f,0.3f,0.3f,1 }, 
-    };
-
-    D3D11_BUFFER_DESC bd = {}; bd.Usage = D3D11_USAGE_DEFAULT; bd.ByteWidth = sizeof(vertices); bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    D3D11_SUBRESOURCE_DATA initData = {}; initData.pSysMem = vertices;
-    device->CreateBuffer(&bd, &initData, &g_pVertexBuffer);
-
-    D3D11_BUFFER_DESC cbd = {}; cbd.Usage = D3D11_USAGE_DYNAMIC; cbd.ByteWidth = 64; cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER; cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    D3D11_BUFFER_DESC cbd = {}; cbd.Usage = D3D11_USAGE_DYNAMIC; cbd.ByteWidth = sizeof(CBufferData); cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER; cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
     device->CreateBuffer(&cbd, nullptr, &g_pConstantBuffer);
 
     D3D11_RASTERIZER_DESC rsDesc = {}; rsDesc.FillMode = D3D11_FILL_SOLID; rsDesc.CullMode = D3D11_CULL_BACK; 
@@ -283,44 +352,176 @@ bool InitGraphics(ID3D11Device* device) {
     return true;
 }
 
-void RenderGraphics(ID3D11DeviceContext* context) {
+void ReleaseGpuChunk(GpuChunk& gpu) {
+    if (gpu.vertexBuffer) { gpu.vertexBuffer->Release(); gpu.vertexBuffer = nullptr; }
+    gpu.vertexCount = 0;
+}
+
+GpuChunk UploadChunkMesh(ID3D11Device* device, const ChunkMesh& mesh) {
+    GpuChunk gpu;
+    gpu.cull = mesh.cull;
+    gpu.lodLevel = mesh.lodLevel;
+    for (int i = 0; i < 3; i++) { gpu.boundsMin[i] = mesh.boundsMin[i]; gpu.boundsMax[i] = mesh.boundsMax[i]; }
+    if (mesh.vertices.empty()) return gpu;
+    D3D11_BUFFER_DESC bd = {}; bd.Usage = D3D11_USAGE_IMMUTABLE; bd.ByteWidth = (UINT)(mesh.vertices.size() * sizeof(Vertex)); bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA initData = {}; initData.pSysMem = mesh.vertices.data();
+    device->CreateBuffer(&bd, &initData, &gpu.vertexBuffer);
+    gpu.vertexCount = (UINT)mesh.vertices.size();
+    gpu.vertices = mesh.vertices;
+    return gpu;
+}
+
+void RenderGraphics(ID3D11Device* device, ID3D11DeviceContext* context) {
     context->RSSetState(g_pRasterizerState);
-    UINT stride = sizeof(Vertex); UINT offset = 0;
-    context->IASetVertexBuffers(0, 1, &g_pVertexBuffer, &stride, &offset);
     context->IASetInputLayout(g_pInputLayout);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     context->VSSetShader(g_pVertexShader, nullptr, 0);
     context->PSSetShader(g_pPixelShader, nullptr, 0);
     context->VSSetConstantBuffers(0, 1, &g_pConstantBuffer);
 
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    context->Map(g_pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+    CBufferData* dataPtr = (CBufferData*)mappedResource.pData;
+    dataPtr->viewProj = g_View.relativeViewProj;
+    dataPtr->camX = g_View.eye[0]; dataPtr->camY = g_View.eye[1]; dataPtr->camZ = g_View.eye[2];
+    dataPtr->objX = 0.0f; dataPtr->objY = 0.0f; dataPtr->objZ = 0.0f; // Chunk meshes are in world space
+    context->Unmap(g_pConstantBuffer, 0);
+
     int camGridX = (int)floor(g_Cam.x);
     int camGridZ = (int)floor(g_Cam.z);
-    int range = 32; 
+    int reach = kLodRingRadius[LOD_LEVELS - 1];
+
+    ChunkCoord minChunk = ChunkCoordOf(camGridX - reach, camGridZ - reach);
+    ChunkCoord maxChunk = ChunkCoordOf(camGridX + reach, camGridZ + reach);
+
+    // Meshes that scrolled out of the last ring give their GPU memory back.
+    for (auto it = g_GpuChunks.begin(); it != g_GpuChunks.end(); ) {
+        if (LodLevelForChunk(it->first, camGridX, camGridZ) < 0) {
+            ReleaseGpuChunk(it->second);
+            it = g_GpuChunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
 
-    for (int x = camGridX - range; x <= camGridX + range; x++) {
-        for (int z = camGridZ - range; z <= camGridZ + range; z++) {
-            
-            float worldX = (float)x;
-            float worldZ = (float)z;
-
-            int stackHeight = (int)(GetTerrainHeight(worldX, worldZ) - 1.0f);
-            int floorLevel = -6; 
-
-            for (int y = floorLevel; y <= stackHeight; y++) {
-                D3D11_MAPPED_SUBRESOURCE mappedResource;
-                context->Map(g_pConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-                CBufferData* dataPtr = (CBufferData*)mappedResource.pData;
-                
-                dataPtr->camX = g_Cam.x; dataPtr->camY = g_Cam.y; dataPtr->camZ = g_Cam.z;
-                dataPtr->camYaw = g_Cam.yaw; dataPtr->camPitch = g_Cam.pitch;
-                dataPtr->objX = worldX; dataPtr->objY = (float)y; dataPtr->objZ = worldZ;
-                dataPtr->isTopBlock = (y == stackHeight) ? 1.0f : 0.0f; 
-
-                context->Unmap(g_pConstantBuffer, 0);
-                context->Draw(36, 0);
+    // A mesh replaces whatever the chunk showed before, unless the camera has meanwhile moved it to another ring.
+    static std::vector<ChunkMesh> finished;
+    static std::vector<ChunkCoord> inserted, relit;
+    finished.clear(); inserted.clear(); relit.clear();
+    g_ChunkBuilder->Poll(g_World, finished, &inserted);
+    g_Lighting.ChunksInserted(g_World, inserted);
+    for (const ChunkMesh& mesh : finished) {
+        if (mesh.lodLevel == 0) g_DirtyChunks.Finished(mesh.coord, ImGui::GetTime());
+        if (LodLevelForChunk(mesh.coord, camGridX, camGridZ) != mesh.lodLevel) continue;
+        GpuChunk& slot = g_GpuChunks[mesh.coord];
+        ReleaseGpuChunk(slot);
+        slot = UploadChunkMesh(device, mesh);
+    }
+
+    Frustum frustum = Frustum::FromCamera(g_View);
+
+    g_RenderStats = RenderStats();
+    static std::vector<const GpuChunk*> candidates;
+    static AabbBatch boxes;
+    static std::vector<uint8_t> visible;
+    static std::vector<ChunkRequest> requests;
+    candidates.clear(); boxes.Clear(); requests.clear();
+
+    for (int cx = minChunk.x; cx <= maxChunk.x; cx++) {
+        for (int cz = minChunk.z; cz <= maxChunk.z; cz++) {
+            ChunkCoord coord = { cx, cz };
+            int level = LodLevelForChunk(coord, camGridX, camGridZ);
+            if (level < 0) continue;
+
+            auto it = g_GpuChunks.find(coord);
+            if (it == g_GpuChunks.end() || it->second.lodLevel != level) {
+                // Not built at this level yet: nearest first, and chunks in view ahead of those behind the camera.
+                // A chunk changing rings keeps drawing its old mesh until the new one arrives.
+                float boxMin[3] = { cx * (float)CHUNK_SIZE - 0.5f, WORLD_MIN_Y - 0.5f, cz * (float)CHUNK_SIZE - 0.5f };
+                float boxMax[3] = { boxMin[0] + CHUNK_SIZE, WORLD_MAX_Y + 0.5f, boxMin[2] + CHUNK_SIZE };
+                float dx = (boxMin[0] + CHUNK_SIZE * 0.5f) - g_Cam.x, dz = (boxMin[2] + CHUNK_SIZE * 0.5f) - g_Cam.z;
+                float priority = dx * dx + dz * dz;
+                if (!BoxInFrustum(frustum, boxMin, boxMax)) priority *= 4.0f;
+                requests.push_back({ coord, priority, level });
+                if (it == g_GpuChunks.end()) continue;
             }
+
+            const GpuChunk& gpu = it->second;
+            g_RenderStats.facesKept += gpu.cull.facesKept;
+            g_RenderStats.facesCulled += gpu.cull.facesCulled;
+            if (!gpu.vertexBuffer) continue;
+            candidates.push_back(&gpu);
+            boxes.Add(gpu.boundsMin, gpu.boundsMax);
         }
     }
+    // Relight before flushing so an edit's remesh already sees its new light.
+    auto lightStart = std::chrono::steady_clock::now();
+    g_Lighting.Update(g_World, &g_ChunkBuilder->Jobs(), relit);
+    g_RenderStats.lightMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lightStart).count();
+    for (ChunkCoord c : relit) g_DirtyChunks.MarkChunk(c, ImGui::GetTime());
+    g_DirtyChunks.Flush(g_World, *g_ChunkBuilder);   // Edits go ahead of new chunks
+    g_ChunkBuilder->Schedule(g_World, requests);
+    g_RenderStats.chunksPending = (int)requests.size();
+
+    CullStats cullStats;
+    visible.resize(candidates.size());
+    CullAabbs(frustum, boxes, visible.data(), cullStats);
+    g_RenderStats.chunksCulled = cullStats.culled;
+
+    // Hi-Z occlusion: the nearest visible chunks go into the CPU depth buffer, then every box that
+    // survived the frustum is tested against its pyramid.
+    static std::vector<std::pair<float, size_t>> byDistance;
+    byDistance.clear();
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!visible[i]) continue;
+        const GpuChunk& gpu = *candidates[i];
+        float dx = (gpu.boundsMin[0] + gpu.boundsMax[0]) * 0.5f - g_Cam.x;
+        float dz = (gpu.boundsMin[2] + gpu.boundsMax[2]) * 0.5f - g_Cam.z;
+        byDistance.push_back({ dx * dx + dz * dz, i });
+    }
+    std::sort(byDistance.begin(), byDistance.end());
+    g_Occlusion.BeginFrame(g_View);
+    size_t occluderTriangles = 0;
+    for (const auto& entry : byDistance) {
+        const GpuChunk& gpu = *candidates[entry.second];
+        occluderTriangles += gpu.vertexCount / 3;
+        if (occluderTriangles > OCCLUDER_TRIANGLE_BUDGET) break;
+        g_Occlusion.AddOccluder(&gpu.vertices[0].x, gpu.vertices.size(), sizeof(Vertex) / sizeof(float));
+    }
+    g_Occlusion.Rasterize(&g_ChunkBuilder->Jobs());
+    g_Occlusion.CullOccluded(boxes, visible.data());
+    g_RenderStats.chunksOccluded = g_Occlusion.Stats.occluded;
+    g_RenderStats.occluderTriangles = g_Occlusion.Stats.occluderTriangles;
+
+    // The software renderer takes the size of the viewport the GPU would have drawn into.
+    auto softwareStart = std::chrono::steady_clock::now();
+    if (g_SoftwareRender) {
+        D3D11_VIEWPORT viewport; UINT viewports = 1;
+        context->RSGetViewports(&viewports, &viewport);
+        g_Software.Resize((int)viewport.Width, (int)viewport.Height);
+        g_Software.BeginFrame(g_View, SKY_COLOR);
+    }
+
+    UINT stride = sizeof(Vertex); UINT offset = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (!visible[i]) continue;
+        const GpuChunk& gpu = *candidates[i];
+        if (g_SoftwareRender) {
+            g_Software.AddMesh(gpu.vertices.data(), gpu.vertices.size());
+        } else {
+            context->IASetVertexBuffers(0, 1, &gpu.vertexBuffer, &stride, &offset);
+            context->Draw(gpu.vertexCount, 0);
+        }
+        g_RenderStats.chunksDrawn++;
+        if (gpu.lodLevel > 0) g_RenderStats.lodTilesDrawn++;
+        g_RenderStats.vertices += gpu.vertexCount;
+    }
+
+    if (g_SoftwareRender) {
+        g_Software.Render(&g_ChunkBuilder->Jobs());
+        g_SoftwareFrame.Upload(device, context, g_Software.Pixels(), g_Software.Width(), g_Software.Height(), g_Software.Stride());
+        g_RenderStats.softwareMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - softwareStart).count();
+    }
 }
 
 static ID3D11Device* g_pd3dDevice = nullptr;
@@ -346,6 +547,9 @@ int main(int, char**) {
     if (!CreateDeviceD3D(g_hwnd)) { CleanupDeviceD3D(); return 1; }
     
     InitGraphics(g_pd3dDevice); 
+    g_Regions = new RegionStore(std::string(WORLD_DIRECTORY) + "/region");
+    g_ChunkBuilder = new ChunkBuilder();
+    g_ChunkBuilder->Store = g_Regions;
     myFB = new SimpleFrameBuffer(g_pd3dDevice, 800, 600);
 
     ::ShowWindow(g_hwnd, SW_SHOWDEFAULT); ::UpdateWindow(g_hwnd);
@@ -371,16 +575,18 @@ int main(int, char**) {
         }
 
         UpdateCamera(io.DeltaTime);
+        UpdateView(myFB->Viewport);
+        EditBlocks();
+        g_Streamer.Update(g_World, *g_ChunkBuilder, g_Regions, g_Cam.x, g_Cam.z, g_View.forward[0], g_View.forward[2]);
 
         ImGui_ImplDX11_NewFrame(); ImGui_ImplWin32_NewFrame(); ImGui::NewFrame();
         ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport());
 
         myFB->Bind(g_pd3dDeviceContext);
-        float bgColor[4] = { 0.6f, 0.8f, 1.0f, 1.0f }; 
-        g_pd3dDeviceContext->ClearRenderTargetView(myFB->RenderTargetView, bgColor);
+        g_pd3dDeviceContext->ClearRenderTargetView(myFB->RenderTargetView, SKY_COLOR);
         g_pd3dDeviceContext->ClearDepthStencilView(myFB->DepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
         
-        RenderGraphics(g_pd3dDeviceContext);
+        RenderGraphics(g_pd3dDevice, g_pd3dDeviceContext);
         
         myFB->Unbind(g_pd3dDeviceContext, g_mainRenderTargetView);
 
@@ -392,12 +598,53 @@ int main(int, char**) {
             ImVec2 size = ImGui::GetContentRegionAvail();
             if (size.x != myFB->Viewport.Width || size.y != myFB->Viewport.Height)
                 myFB->Resize(g_pd3dDevice, (int)size.x, (int)size.y);
-            ImGui::Image((void*)myFB->ShaderResourceView, size);
+            bool software = g_SoftwareRender && g_SoftwareFrame.ShaderResourceView;
+            ImGui::Image((void*)(software ? g_SoftwareFrame.ShaderResourceView : myFB->ShaderResourceView), size);
             
             ImGui::SetCursorPos(ImVec2(20, 20));
             ImGui::TextColored(ImVec4(1,1,0,1), "X: %.1f Y: %.1f Z: %.1f", g_Cam.x, g_Cam.y, g_Cam.z);
+            ImGui::SetCursorPos(ImVec2(20, 40));
+            const StreamingStats& stream = g_Streamer.Stats;
+            ImGui::TextColored(ImVec4(1,1,0,1), "Chunks: %d resident (%.0f KB) of %d wanted, %d loading, %d saving, %d loaded / %d unloaded, streaming %.2f ms (worst overrun %.2f ms)",
+                (int)stream.resident, stream.memoryBytes / 1024.0, (int)stream.wanted, (int)stream.pending, (int)stream.saving, (int)stream.totalLoads, (int)stream.totalUnloads,
+                stream.updateMs, stream.worstOverrunMs);
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(1,1,0,1), "| builder: %d threads, %d in flight, %d waiting", g_ChunkBuilder->ThreadCount(), g_ChunkBuilder->InFlight(), g_RenderStats.chunksPending);
+            ImGui::SetCursorPos(ImVec2(20, 60));
+            ImGui::TextColored(ImVec4(1,1,0,1), "Draws: %d (%d LOD tiles, %d frustum culled), vertices: %d, faces kept %d / culled %d", g_RenderStats.chunksDrawn, g_RenderStats.lodTilesDrawn, g_RenderStats.chunksCulled, g_RenderStats.vertices, g_RenderStats.facesKept, g_RenderStats.facesCulled);
+            ImGui::SetCursorPos(ImVec2(20, 80));
+            ImGui::TextColored(ImVec4(1,1,0,1), "Hi-Z: %d occluded, %d occluder triangles", g_RenderStats.chunksOccluded, g_RenderStats.occluderTriangles);
+            ImGui::SetCursorPos(ImVec2(20, 100));
+            if (g_Target.hit) {
+                static const char* faceNames[3][3] = { { "-X", "", "+X" }, { "-Y", "", "+Y" }, { "-Z", "", "+Z" } };
+                const char* face = "inside";
+                for (int a = 0; a < 3; a++) if (g_Target.normal[a] != 0) face = faceNames[a][g_Target.normal[a] + 1];
+                ImGui::TextColored(ImVec4(1,1,0,1), "Target: %s at (%d, %d, %d), face %s, %.1f blocks", BlockTypeName(g_Target.type),
+                    g_Target.block[0], g_Target.block[1], g_Target.block[2], face, g_Target.distance);
+            } else {
+                ImGui::TextColored(ImVec4(1,1,0,1), "Target: none within %.0f blocks", PICK_REACH);
+            }
+            const double latencyPercentiles[2] = { 50.0, 95.0 };
+            double latency[2];
+            g_DirtyChunks.LatencyPercentiles(latencyPercentiles, latency, 2);
+            ImGui::SetCursorPos(ImVec2(20, 120));
+            ImGui::TextColored(ImVec4(1,1,0,1), "Edits: %d, remeshes %d waiting / %d building, latency p50 %.1f ms p95 %.1f ms", (int)g_DirtyChunks.EditsMarked,
+                (int)g_DirtyChunks.Pending(), (int)g_DirtyChunks.InFlight(), latency[0] * 1000.0, latency[1] * 1000.0);
+            ImGui::SetCursorPos(ImVec2(20, 140));
+            ImGui::TextColored(ImVec4(1,1,0,1), "Light: %d full / %d edit passes, %d waiting, %.2f ms this frame", (int)g_Lighting.FullPasses,
+                (int)g_Lighting.EditPasses, (int)g_Lighting.Pending(), g_RenderStats.lightMs);
+            ImGui::SetCursorPos(ImVec2(20, 160));
+            if (software) {
+                ImGui::TextColored(ImVec4(1,1,0,1), "Renderer: software (F3), %d triangles in %d tile bins, %.2f ms on %d threads", g_Software.Stats.trianglesDrawn,
+                    g_Software.Stats.binEntries, g_RenderStats.softwareMs, g_ChunkBuilder->Jobs().ThreadCount() + 1);
+            } else {
+                ImGui::TextColored(ImVec4(1,1,0,1), "Renderer: GPU (F3 for software)");
+            }
+            ImGui::SetCursorPos(ImVec2(size.x * 0.5f - 4.0f, size.y * 0.5f - 8.0f));
+            ImGui::TextColored(ImVec4(1,1,1,1), "+");
 
             if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) g_MouseCaptured = !g_MouseCaptured;
+            if (ImGui::IsKeyPressed(ImGuiKey_F3, false)) g_SoftwareRender = !g_SoftwareRender;
         ImGui::End();
 
         ImGui::Render();
@@ -408,6 +655,10 @@ int main(int, char**) {
         g_pSwapChain->Present(1, 0);
     }
     ImGui_ImplDX11_Shutdown(); ImGui_ImplWin32_Shutdown(); ImGui::DestroyContext();
+    g_SoftwareFrame.Release();
+    delete g_ChunkBuilder;
+    g_World.ForEachChunk([](const std::shared_ptr<Chunk>& chunk) { if (chunk->modified) g_Regions->SaveChunk(*chunk); });
+    delete g_Regions;
     CleanupDeviceD3D(); ::DestroyWindow(g_hwnd);
     return 0;
 }